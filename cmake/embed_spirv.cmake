@@ -0,0 +1,59 @@
+# Writes a SPIR-V binary as a C++ header holding a constexpr uint32_t array.
+#
+#   cmake -DINPUT=shader.spv -DOUTPUT=shader.spv.h -DNAME=shader
+#         -DSOURCE=shaders/shader.comp -P embed_spirv.cmake
+#
+# The array is named after NAME in the repo's constant style: "tiles" becomes
+# kernels::kTilesSpirv.
+
+file(READ "${INPUT}" hex HEX)
+string(LENGTH "${hex}" hex_length)
+math(EXPR remainder "${hex_length} % 8")
+if (hex_length EQUAL 0 OR NOT remainder EQUAL 0)
+  message(FATAL_ERROR "${INPUT}: not a SPIR-V module.")
+endif ()
+
+# SPIR-V words are little-endian; five of them per line.
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u,;" words "${hex}")
+set(lines "")
+set(line "")
+set(count 0)
+foreach (word ${words})
+  if (count EQUAL 5)
+    string(APPEND lines "   ${line}\n")
+    set(line "")
+    set(count 0)
+  endif ()
+  string(APPEND line " ${word}")
+  math(EXPR count "${count} + 1")
+endforeach ()
+string(APPEND lines "   ${line}\n")
+
+set(array "k")
+string(REPLACE "_" ";" parts "${NAME}")
+foreach (part ${parts})
+  string(SUBSTRING "${part}" 0 1 first)
+  string(SUBSTRING "${part}" 1 -1 rest)
+  string(TOUPPER "${first}" first)
+  string(APPEND array "${first}${rest}")
+endforeach ()
+string(APPEND array "Spirv")
+string(TOUPPER "${NAME}_SPV_H" guard)
+
+file(WRITE "${OUTPUT}"
+"/* Generated from ${SOURCE} by embed_spirv.cmake; do not edit. */
+
+#ifndef ${guard}
+#define ${guard}
+
+#include <cstdint>
+
+namespace kernels {
+
+constexpr uint32_t ${array}[] = {
+${lines}};
+
+}  // namespace kernels
+
+#endif
+")
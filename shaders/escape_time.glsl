@@ -0,0 +1,113 @@
+/*
+Escape-time iteration and coloring shared by the compute kernels, which
+pull it in with #include.
+
+Specialization constants (see src/kernels.h) are fixed when a pipeline is
+created, so each option below is compiled in or out rather than tested in
+the loop.
+*/
+layout(constant_id = 0) const uint MAX_ITERATIONS = 128;
+layout(constant_id = 1) const uint COLORING = 0;  // 0: cosine palette, 1: grayscale
+layout(constant_id = 2) const bool INTERIOR_CHECK = false;
+layout(constant_id = 3) const bool PERIODICITY = false;
+// 0: Mandelbrot, 1: Multibrot, 2: Julia, 3: Burning Ship (kernels::Family)
+layout(constant_id = 4) const uint FAMILY = 0;
+layout(constant_id = 5) const uint EXPONENT = 3;  // Multibrot's z^EXPONENT
+layout(constant_id = 6) const float JULIA_X = 0.0;
+layout(constant_id = 7) const float JULIA_Y = 0.0;
+// Write iteration counts for the histogram passes instead of colors
+layout(constant_id = 8) const bool HISTOGRAM = false;
+// Samples per pixel along each axis
+layout(constant_id = 9) const uint SUPERSAMPLING = 1;
+const uint SAMPLES = SUPERSAMPLING * SUPERSAMPLING;
+
+/*
+Position of sample s of a pixel, in 1/SAMPLES of a pixel from its corner.
+The samples form a rotated grid: no two share a row or a column, so edges
+near horizontal or vertical get SAMPLES levels of coverage rather than
+SUPERSAMPLING. With one sample, it is the corner, as without
+supersampling.
+*/
+uvec2 sampleOffset(uint s) {
+  uint i = s / SUPERSAMPLING, j = s % SUPERSAMPLING;
+  return uvec2(i * SUPERSAMPLING + j,
+               j * SUPERSAMPLING + SUPERSAMPLING - 1 - i);
+}
+
+/*
+Whether c lies in the main cardioid or the period-2 bulb, where every point
+would run to the iteration cap.
+*/
+bool inInterior(vec2 c) {
+  float x = c.x - 0.25;
+  float q = x*x + c.y*c.y;
+  return q*(q + x) <= 0.25*c.y*c.y ||
+         (c.x + 1.0)*(c.x + 1.0) + c.y*c.y <= 0.0625;
+}
+
+/* z^EXPONENT; the loop unrolls once the pipeline fixes EXPONENT. */
+vec2 power(vec2 z) {
+  vec2 w = z;
+  for (uint k = 1; k < EXPONENT; k++)
+    w = vec2(w.x*z.x - w.y*z.y, w.x*z.y + w.y*z.x);
+  return w;
+}
+
+/* One step of the FAMILY's formula. */
+vec2 advance(vec2 z, vec2 c) {
+  if (FAMILY == 1)
+    return power(z) + c;
+  if (FAMILY == 3)
+    z = abs(z);
+  return vec2(z.x*z.x - z.y*z.y, 2.*z.x*z.y) + c;
+}
+
+/*
+Number of iterations before the orbit of c escapes, up to max_iterations.
+With PERIODICITY, an orbit that comes back exactly to a saved point is
+cycling and will never escape. For Julia sets, c is the starting point and
+the constant is (JULIA_X, JULIA_Y). The Mandelbrot kernel keeps its
+historical escape test |z|^2 > 2; the other families use |z| > 2, past
+which every orbit diverges.
+*/
+float iterate(vec2 c, uint max_iterations) {
+  if (INTERIOR_CHECK && FAMILY == 0 && inInterior(c))
+    return float(max_iterations);
+  vec2 z = vec2(0.0), saved = vec2(0.0);
+  if (FAMILY == 2) {
+    z = c;
+    c = vec2(JULIA_X, JULIA_Y);
+  }
+  float escape = FAMILY == 0 ? 2.0 : 4.0;
+  uint since_saved = 0;
+  float n = 0.0;
+  for (uint i = 0; i < max_iterations; i++)
+  {
+    z = advance(z, c);
+    if (dot(z, z) > escape) break;
+    n++;
+    if (PERIODICITY) {
+      if (z == saved)
+        return float(max_iterations);
+      if (++since_saved == 20) {
+        saved = z;
+        since_saved = 0;
+      }
+    }
+  }
+  return n;
+}
+
+/*
+Color for t = iterations / cap. The palette is a cosine one:
+http://iquilezles.org/www/articles/palettes/palettes.htm
+*/
+vec4 colorize(float t) {
+  if (COLORING == 1)
+    return vec4(vec3(t), 1.0);
+  vec3 d = vec3(0.3, 0.3 ,0.5);
+  vec3 e = vec3(-0.2, -0.3 ,-0.5);
+  vec3 f = vec3(2.1, 2.0, 3.0);
+  vec3 g = vec3(0.0, 0.1, 0.0);
+  return vec4( d + e*cos( 6.28318*(f*t+g) ) ,1.0);
+}
@@ -0,0 +1,38 @@
+/*
+Buffers and binning shared by the kernels of histogram coloring (HISTOGRAM),
+which pull it in with #include after escape_time.glsl:
+
+  1. the image kernel writes the iteration count of each sample to counts,
+     SAMPLES consecutive ones per pixel;
+  2. histogram.comp counts the escaped pixels per bin;
+  3. prefix_sum.comp turns the bins into a cumulative distribution;
+  4. colorize.comp colors each sample by its count's rank in it and
+     stores the average of a pixel's samples.
+
+Every buffer stays in device memory; only the colored, resolved image is
+read back.
+*/
+
+/* kernels::kHistogramBins; 4096 32-bit bins fill the minimum shared memory. */
+#define BINS 4096u
+
+layout(std430, binding = 1) buffer Counts
+{
+   uint counts[];
+};
+
+/*
+bins[b] holds the escaped pixels of bin b, and bins[BINS + b] those of bins
+0 to b. The host clears the buffer before the histogram pass.
+*/
+layout(std430, binding = 2) buffer Histogram
+{
+   uint bins[2 * BINS];
+};
+
+/* The bin of an escaped pixel's count n < MAX_ITERATIONS. */
+uint histogramBin(uint n) {
+  if (MAX_ITERATIONS <= BINS)
+    return n;
+  return min(uint(float(n) / float(MAX_ITERATIONS) * float(BINS)), BINS - 1u);
+}
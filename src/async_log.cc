@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "async_log.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace async_log {
+
+namespace {
+
+const size_t kMessageSize = 512;
+/* IDs tracked for rate limiting; further IDs are never limited. */
+const size_t kCounters = 256;
+const int64_t kNoId = INT64_MIN;
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+}  // namespace
+
+/*
+ * A ring slot, after Dmitry Vyukov's bounded queue: sequence == position
+ * when the slot is free for the producer claiming position, position + 1
+ * once that producer has filled it.
+ */
+struct Logger::Slot {
+  std::atomic<size_t> sequence;
+  char text[kMessageSize];
+};
+
+/* Messages of one ID in the current interval. */
+struct Logger::Counter {
+  std::atomic<int64_t> id{kNoId};
+  std::atomic<unsigned> count{0};
+};
+
+Logger::Logger(std::ostream &out, const Options &options)
+    : out_(out),
+      options_(options),
+      slots_(new Slot[RoundUpToPowerOfTwo(options.capacity)]),
+      mask_(RoundUpToPowerOfTwo(options.capacity) - 1),
+      counters_(new Counter[kCounters]),
+      counter_mask_(kCounters - 1) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  thread_ = std::thread(&Logger::Run, this);
+}
+
+Logger::~Logger() {
+  stop_.store(true, std::memory_order_release);
+  thread_.join();
+}
+
+/* Counts the message against its ID; false if over the limit. */
+bool Logger::Admit(int32_t id) {
+  size_t start = static_cast<uint32_t>(id) * 2654435761u;
+  for (size_t probe = 0; probe <= counter_mask_; ++probe) {
+    Counter &counter = counters_[(start + probe) & counter_mask_];
+    int64_t current = counter.id.load(std::memory_order_acquire);
+    if (current == kNoId and
+        counter.id.compare_exchange_strong(current, id,
+                                           std::memory_order_acq_rel)) {
+      current = id;
+    }
+    if (current == id) {
+      return counter.count.fetch_add(1, std::memory_order_relaxed) <
+             options_.per_id_limit;
+    }
+  }
+  return true;
+}
+
+void Logger::Log(int32_t id, const char *prefix, const char *message) {
+  if (not Admit(id)) {
+    return;
+  }
+  size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Slot *slot;
+  for (;;) {
+    slot = &slots_[position & mask_];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    auto difference = static_cast<intptr_t>(sequence) -
+                      static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;  // full
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  std::snprintf(slot->text, kMessageSize, "%s: %s", prefix, message);
+  slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void Logger::Drain() {
+  for (;;) {
+    Slot &slot = slots_[dequeue_position_ & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) !=
+        dequeue_position_ + 1) {
+      break;
+    }
+    out_ << slot.text << '\n';
+    slot.sequence.store(dequeue_position_ + mask_ + 1,
+                        std::memory_order_release);
+    ++dequeue_position_;
+  }
+  out_.flush();
+}
+
+/* Ends the rate-limiting interval. */
+void Logger::ReportSuppressed() {
+  for (size_t i = 0; i <= counter_mask_; ++i) {
+    unsigned count = counters_[i].count.exchange(0, std::memory_order_relaxed);
+    if (count > options_.per_id_limit) {
+      out_ << "(" << count - options_.per_id_limit
+           << " more messages with ID "
+           << counters_[i].id.load(std::memory_order_relaxed)
+           << " suppressed)\n";
+    }
+  }
+}
+
+void Logger::Run() {
+  auto interval_start = std::chrono::steady_clock::now();
+  for (;;) {
+    bool stopping = stop_.load(std::memory_order_acquire);
+    Drain();
+    if (stopping or
+        std::chrono::steady_clock::now() - interval_start >=
+            options_.interval) {
+      ReportSuppressed();
+      interval_start = std::chrono::steady_clock::now();
+    }
+    if (stopping) {
+      break;
+    }
+    std::this_thread::sleep_for(options_.drain_interval);
+  }
+  uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped > 0) {
+    out_ << "(" << dropped << " messages dropped: log ring full)\n";
+  }
+  out_.flush();
+}
+
+}  // namespace async_log
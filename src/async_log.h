@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+/*
+ * Diagnostics that never stall the thread reporting them. Log() formats the
+ * message into a slot of a bounded lock-free ring (any number of threads may
+ * log at once) and returns; a background thread drains the ring into the
+ * output stream. When the ring is full the message is dropped and counted.
+ *
+ * Messages are rate-limited per ID: past the limit within one interval the
+ * messages of an ID are counted, not queued, and the drain thread reports how
+ * many were suppressed once the interval ends.
+ */
+namespace async_log {
+
+struct Options {
+  /* Ring slots, rounded up to a power of two. */
+  size_t capacity = 1024;
+  /* Messages per ID and interval before the rest are suppressed. */
+  unsigned per_id_limit = 10;
+  std::chrono::milliseconds interval{1000};
+  /* How often the background thread drains the ring. */
+  std::chrono::milliseconds drain_interval{20};
+};
+
+class Logger {
+ public:
+  explicit Logger(std::ostream &out, const Options &options = Options());
+  /* Drains every queued message before returning. */
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  /* Queues "prefix: message". Lock-free; truncates very long messages. */
+  void Log(int32_t id, const char *prefix, const char *message);
+
+  /* Messages lost because the ring was full. */
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Slot;
+  struct Counter;
+
+  bool Admit(int32_t id);
+  void Drain();
+  void ReportSuppressed();
+  void Run();
+
+  std::ostream &out_;
+  Options options_;
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  std::atomic<size_t> enqueue_position_{0};
+  size_t dequeue_position_ = 0;  // drain thread only
+
+  std::unique_ptr<Counter[]> counters_;
+  size_t counter_mask_;
+
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace async_log
+
+#endif
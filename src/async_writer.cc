@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "async_writer.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace async_writer {
+
+namespace {
+
+const size_t kAlignment = 4096;
+
+}  // namespace
+
+/*
+ * Carries out the positioned writes of whole buffers. A buffer is only
+ * returned by Wait once all of its bytes are written or an error happened.
+ */
+class Queue {
+ public:
+  using Buffer = FileWriter::Buffer;
+
+  virtual ~Queue() = default;
+
+  /* Starts writing buffer->data[written, size) at buffer->offset + written. */
+  virtual void Submit(Buffer *buffer) = 0;
+
+  /*
+   * Blocks until a submitted buffer is done and returns it. *error is 0 on
+   * success, an errno value otherwise.
+   */
+  virtual Buffer *Wait(int *error) = 0;
+};
+
+namespace {
+
+/*
+ * io_uring set up with the raw syscalls. Needs Linux 5.6 for IORING_OP_WRITE;
+ * IORING_FEAT_RW_CUR_POS came with the same release and is used to detect it.
+ */
+class IoUringQueue : public Queue {
+ public:
+  static std::unique_ptr<Queue> Create(int fd, unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd < 0) {
+      return nullptr;
+    }
+    if (not(params.features & IORING_FEAT_SINGLE_MMAP) or
+        not(params.features & IORING_FEAT_RW_CUR_POS)) {
+      close(ring_fd);
+      return nullptr;
+    }
+    size_t ring_size =
+        std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                 params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void *ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+      close(ring_fd);
+      return nullptr;
+    }
+    size_t sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      munmap(ring, ring_size);
+      close(ring_fd);
+      return nullptr;
+    }
+    return std::unique_ptr<Queue>(new IoUringQueue(
+        fd, ring_fd, params, ring, ring_size,
+        static_cast<io_uring_sqe *>(sqes), sqes_size));
+  }
+
+  ~IoUringQueue() override {
+    munmap(sqes_, sqes_size_);
+    munmap(ring_, ring_size_);
+    close(ring_fd_);
+  }
+
+  void Submit(Buffer *buffer) override {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer->data + buffer->written);
+    sqe->len = static_cast<uint32_t>(buffer->size - buffer->written);
+    sqe->off = buffer->offset + buffer->written;
+    sqe->user_data = reinterpret_cast<uint64_t>(buffer);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++unsubmitted_;
+    Enter(0, 0);
+  }
+
+  Buffer *Wait(int *error) override {
+    for (;;) {
+      unsigned head = *cq_head_;
+      if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+        auto buffer = reinterpret_cast<Buffer *>(cqe.user_data);
+        int result = cqe.res;
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        if (result <= 0) {
+          *error = result < 0 ? -result : EIO;
+          return buffer;
+        }
+        buffer->written += result;
+        if (buffer->written < buffer->size) {
+          Submit(buffer);  // short write, queue the rest
+          continue;
+        }
+        *error = 0;
+        return buffer;
+      }
+      int enter_error = Enter(1, IORING_ENTER_GETEVENTS);
+      if (enter_error != 0) {
+        *error = enter_error;
+        return nullptr;
+      }
+    }
+  }
+
+ private:
+  IoUringQueue(int fd, int ring_fd, const io_uring_params &params, void *ring,
+               size_t ring_size, io_uring_sqe *sqes, size_t sqes_size)
+      : fd_(fd),
+        ring_fd_(ring_fd),
+        ring_(ring),
+        ring_size_(ring_size),
+        sqes_(sqes),
+        sqes_size_(sqes_size) {
+    auto base = static_cast<unsigned char *>(ring);
+    sq_tail_ = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+  }
+
+  /* Submits the queued entries and optionally waits for completions. */
+  int Enter(unsigned min_complete, unsigned flags) {
+    for (;;) {
+      long submitted = syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_,
+                               min_complete, flags, nullptr, 0);
+      if (submitted >= 0) {
+        unsubmitted_ -= static_cast<unsigned>(submitted);
+        return 0;
+      }
+      if (errno != EINTR) {
+        return errno;
+      }
+    }
+  }
+
+  int fd_;
+  int ring_fd_;
+  void *ring_;
+  size_t ring_size_;
+  io_uring_sqe *sqes_;
+  size_t sqes_size_;
+  unsigned *sq_tail_, *sq_mask_, *sq_array_;
+  unsigned *cq_head_, *cq_tail_, *cq_mask_;
+  io_uring_cqe *cqes_;
+  unsigned unsubmitted_ = 0;
+};
+
+/* Fallback: one background thread issuing pwrite for each buffer in turn. */
+class ThreadQueue : public Queue {
+ public:
+  explicit ThreadQueue(int fd) : fd_(fd), thread_([this] { Run(); }) {}
+
+  ~ThreadQueue() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    submitted_cv_.notify_one();
+    thread_.join();
+  }
+
+  void Submit(Buffer *buffer) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      submitted_.push_back(buffer);
+    }
+    submitted_cv_.notify_one();
+  }
+
+  Buffer *Wait(int *error) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return not done_.empty(); });
+    auto done = done_.front();
+    done_.pop_front();
+    *error = done.second;
+    return done.first;
+  }
+
+ private:
+  void Run() {
+    for (;;) {
+      Buffer *buffer;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        submitted_cv_.wait(lock,
+                           [this] { return stop_ or not submitted_.empty(); });
+        if (submitted_.empty()) {
+          return;
+        }
+        buffer = submitted_.front();
+        submitted_.pop_front();
+      }
+      int error = 0;
+      while (buffer->written < buffer->size) {
+        ssize_t result =
+            pwrite(fd_, buffer->data + buffer->written,
+                   buffer->size - buffer->written,
+                   static_cast<off_t>(buffer->offset + buffer->written));
+        if (result < 0 and errno == EINTR) {
+          continue;
+        }
+        if (result <= 0) {
+          error = result < 0 ? errno : EIO;
+          break;
+        }
+        buffer->written += result;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.emplace_back(buffer, error);
+      }
+      done_cv_.notify_one();
+    }
+  }
+
+  int fd_;
+  std::mutex mutex_;
+  std::condition_variable submitted_cv_, done_cv_;
+  std::deque<Buffer *> submitted_;
+  std::deque<std::pair<Buffer *, int>> done_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace
+
+FileWriter::FileWriter(const std::string &filename, const Options &options)
+    : filename_(filename), options_(options) {
+  options_.buffer_size =
+      std::max(kAlignment, (options_.buffer_size + kAlignment - 1) /
+                               kAlignment * kAlignment);
+  options_.buffer_count = std::max(2u, options_.buffer_count);
+
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  if (options_.direct) {
+    fd_ = open(filename.c_str(), flags | O_DIRECT, 0644);
+    if (fd_ < 0 and errno == EINVAL) {
+      options_.direct = false;  // not supported by this filesystem
+    }
+  }
+  if (not options_.direct) {
+    fd_ = open(filename.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    throw std::runtime_error(filename + ": could not open for writing.");
+  }
+
+  if (options_.backend != Backend::kThread) {
+    queue_ = IoUringQueue::Create(fd_, options_.buffer_count);
+  }
+  if (queue_) {
+    backend_ = Backend::kIoUring;
+  } else if (options_.backend == Backend::kIoUring) {
+    close(fd_);
+    throw std::runtime_error("io_uring is not available.");
+  } else {
+    queue_.reset(new ThreadQueue(fd_));
+    backend_ = Backend::kThread;
+  }
+
+  /* Buffers are allocated on first use; reserving keeps their addresses. */
+  buffers_.reserve(options_.buffer_count);
+  Preallocate(options_.expected_size);
+}
+
+FileWriter::~FileWriter() {
+  if (fd_ >= 0) {
+    /* Not closed: let the pending writes finish, ignoring their errors. */
+    int error;
+    while (in_flight_ > 0 and queue_->Wait(&error) != nullptr) {
+      --in_flight_;
+    }
+    close(fd_);
+  }
+  queue_.reset();
+  for (auto &buffer : buffers_) {
+    std::free(buffer.data);
+  }
+}
+
+void FileWriter::Write(const void *data, size_t size) {
+  auto bytes = static_cast<const unsigned char *>(data);
+  while (size > 0) {
+    if (current_ == nullptr) {
+      current_ = Acquire();
+    }
+    size_t n = std::min(size, options_.buffer_size - current_->size);
+    std::memcpy(current_->data + current_->size, bytes, n);
+    current_->size += n;
+    bytes += n;
+    size -= n;
+    if (current_->size == options_.buffer_size) {
+      SubmitCurrent();
+    }
+  }
+}
+
+void FileWriter::Close() {
+  if (fd_ < 0) {
+    return;
+  }
+  if (current_ != nullptr and current_->size > 0) {
+    SubmitCurrent();
+  }
+  while (in_flight_ > 0) {
+    free_.push_back(WaitForWrite());
+  }
+  /* Drops the unused preallocation and the padding of a direct last write. */
+  if (ftruncate(fd_, static_cast<off_t>(offset_)) != 0 or close(fd_) != 0) {
+    fd_ = -1;
+    throw std::runtime_error(filename_ + ": write error.");
+  }
+  fd_ = -1;
+}
+
+FileWriter::Buffer *FileWriter::Acquire() {
+  Buffer *buffer;
+  if (not free_.empty()) {
+    buffer = free_.back();
+    free_.pop_back();
+  } else if (buffers_.size() < options_.buffer_count) {
+    void *data = nullptr;
+    if (posix_memalign(&data, kAlignment, options_.buffer_size) != 0) {
+      throw std::bad_alloc();
+    }
+    buffers_.emplace_back();
+    buffer = &buffers_.back();
+    buffer->data = static_cast<unsigned char *>(data);
+  } else {
+    buffer = WaitForWrite();
+  }
+  buffer->size = 0;
+  buffer->written = 0;
+  return buffer;
+}
+
+FileWriter::Buffer *FileWriter::WaitForWrite() {
+  int error = 0;
+  Buffer *buffer = queue_->Wait(&error);
+  if (buffer != nullptr) {
+    --in_flight_;
+  }
+  if (error != 0) {
+    throw std::runtime_error(filename_ + ": write error (" +
+                             std::strerror(error) + ").");
+  }
+  return buffer;
+}
+
+void FileWriter::SubmitCurrent() {
+  Buffer *buffer = current_;
+  current_ = nullptr;
+  buffer->offset = offset_;
+  offset_ += buffer->size;
+  if (options_.direct and buffer->size % kAlignment != 0) {
+    /* O_DIRECT writes whole blocks; Close truncates the padding away. */
+    size_t padded = (buffer->size + kAlignment - 1) / kAlignment * kAlignment;
+    std::memset(buffer->data + buffer->size, 0, padded - buffer->size);
+    buffer->size = padded;
+  }
+  Preallocate(buffer->offset + buffer->size);
+  queue_->Submit(buffer);
+  ++in_flight_;
+}
+
+void FileWriter::Preallocate(uint64_t end) {
+  if (not preallocate_ or end <= preallocated_) {
+    return;
+  }
+  uint64_t size = std::max(end, preallocated_ * 2);
+  if (fallocate(fd_, 0, 0, static_cast<off_t>(size)) == 0) {
+    preallocated_ = size;
+  } else {
+    preallocate_ = false;  // e.g. EOPNOTSUPP: the writes still work
+  }
+}
+
+}  // namespace async_writer
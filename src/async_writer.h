@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Asynchronous file output for large images. Bytes are gathered into a small
+ * pool of fixed-size buffers; each full buffer is handed to the kernel as a
+ * positioned write while the caller keeps encoding into the next one. Memory
+ * use is bounded by the pool, whatever the size of the file.
+ *
+ * Writes go through io_uring when the kernel supports it (set up with raw
+ * syscalls, no liburing needed) and otherwise through a background thread
+ * issuing pwrite. The file is preallocated with fallocate in growing extents
+ * and truncated to the bytes actually written on Close.
+ */
+namespace async_writer {
+
+enum class Backend {
+  kAuto,     /* io_uring if available, the pwrite thread otherwise. */
+  kIoUring,
+  kThread,
+};
+
+struct Options {
+  Backend backend = Backend::kAuto;
+  /* Bytes per write request, a multiple of 4096. */
+  size_t buffer_size = 1 << 20;
+  /* Maximum number of write requests in flight. */
+  unsigned buffer_count = 8;
+  /* Size to preallocate up front. The preallocation doubles when exceeded. */
+  uint64_t expected_size = 0;
+  /* Bypass the page cache with O_DIRECT, if the filesystem supports it. */
+  bool direct = false;
+};
+
+class Queue;
+
+class FileWriter {
+ public:
+  /* Creates or truncates filename. Throws std::runtime_error on failure. */
+  explicit FileWriter(const std::string &filename,
+                      const Options &options = Options());
+  /* Waits for pending writes. Call Close to see write errors. */
+  ~FileWriter();
+
+  FileWriter(const FileWriter &) = delete;
+  FileWriter &operator=(const FileWriter &) = delete;
+
+  void Write(const void *data, size_t size);
+
+  /* Writes what is buffered, waits for every write and sets the final size. */
+  void Close();
+
+  /* The backend actually in use, never kAuto. */
+  Backend backend() const { return backend_; }
+
+  struct Buffer {
+    unsigned char *data = nullptr;
+    size_t size = 0;
+    size_t written = 0;
+    uint64_t offset = 0;
+  };
+
+ private:
+  Buffer *Acquire();
+  Buffer *WaitForWrite();
+  void SubmitCurrent();
+  void Preallocate(uint64_t end);
+
+  std::string filename_;
+  Options options_;
+  Backend backend_;
+  int fd_ = -1;
+  std::unique_ptr<Queue> queue_;
+  std::vector<Buffer> buffers_;
+  std::vector<Buffer *> free_;
+  Buffer *current_ = nullptr;
+  unsigned in_flight_ = 0;
+  uint64_t offset_ = 0;
+  uint64_t preallocated_ = 0;
+  bool preallocate_ = true;
+};
+
+}  // namespace async_writer
+
+#endif
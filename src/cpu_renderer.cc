@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "cpu_renderer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace cpu_renderer {
+
+namespace {
+
+/*
+ * Double-double arithmetic (Dekker, Knuth): a value is hi + lo with
+ * |lo| <= ulp(hi) / 2. Only what the escape-time loop needs.
+ */
+struct DoubleDouble {
+  double hi, lo;
+
+  DoubleDouble() = default;
+  explicit DoubleDouble(double value) : hi(value), lo(0.0) {}
+  DoubleDouble(double h, double l) : hi(h), lo(l) {}
+};
+
+/* a + b as an exact sum s + e. */
+inline DoubleDouble TwoSum(double a, double b) {
+  double s = a + b;
+  double v = s - a;
+  return DoubleDouble(s, (a - (s - v)) + (b - v));
+}
+
+/* Like TwoSum, for |a| >= |b|. */
+inline DoubleDouble QuickTwoSum(double a, double b) {
+  double s = a + b;
+  return DoubleDouble(s, b - (s - a));
+}
+
+/* a * b as an exact sum p + e. */
+inline DoubleDouble TwoProduct(double a, double b) {
+  double p = a * b;
+#ifdef __FMA__
+  return DoubleDouble(p, std::fma(a, b, -p));
+#else
+  const double kSplitter = 134217729.0;  // 2^27 + 1
+  double t = kSplitter * a;
+  double a_hi = t - (t - a), a_lo = a - a_hi;
+  t = kSplitter * b;
+  double b_hi = t - (t - b), b_lo = b - b_hi;
+  return DoubleDouble(
+      p, ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo);
+#endif
+}
+
+inline DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+  DoubleDouble s = TwoSum(a.hi, b.hi);
+  return QuickTwoSum(s.hi, s.lo + a.lo + b.lo);
+}
+
+inline DoubleDouble operator-(DoubleDouble a, DoubleDouble b) {
+  return a + DoubleDouble(-b.hi, -b.lo);
+}
+
+inline DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+  DoubleDouble p = TwoProduct(a.hi, b.hi);
+  return QuickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+inline bool operator<=(DoubleDouble a, DoubleDouble b) {
+  return a.hi < b.hi or (a.hi == b.hi and a.lo <= b.lo);
+}
+
+#ifdef __SIZEOF_INT128__
+/*
+ * Signed fixed point with kFractionBits fractional bits in 64 bits, so
+ * values lie in [-128, 128). The products of the loop stay well inside that
+ * until an orbit escapes; past that, sums wrap instead of overflowing, and
+ * the lane is no longer counted anyway.
+ */
+struct Fixed64 {
+  static const int kFractionBits = 56;
+  int64_t raw;
+
+  Fixed64() = default;
+  explicit Fixed64(double value) {
+    value = std::max(-127.0, std::min(127.0, value));
+    raw = static_cast<int64_t>(std::ldexp(value, kFractionBits));
+  }
+};
+
+inline Fixed64 FromRaw(uint64_t raw) {
+  Fixed64 value;
+  value.raw = static_cast<int64_t>(raw);
+  return value;
+}
+
+inline Fixed64 operator+(Fixed64 a, Fixed64 b) {
+  return FromRaw(uint64_t(a.raw) + uint64_t(b.raw));
+}
+
+inline Fixed64 operator-(Fixed64 a, Fixed64 b) {
+  return FromRaw(uint64_t(a.raw) - uint64_t(b.raw));
+}
+
+inline Fixed64 operator*(Fixed64 a, Fixed64 b) {
+  return FromRaw(static_cast<uint64_t>(
+      (static_cast<__int128>(a.raw) * b.raw) >> Fixed64::kFractionBits));
+}
+
+inline bool operator<=(Fixed64 a, Fixed64 b) { return a.raw <= b.raw; }
+
+/*
+ * The same with 128 bits and 120 fractional bits, as two's complement in an
+ * unsigned __int128. Sums are exact; products are truncated toward zero,
+ * exactly as shaders/fixed128.comp does it, so both give the same orbits.
+ */
+struct Fixed128 {
+  static const int kFractionBits = 120;
+  unsigned __int128 raw;
+
+  Fixed128() = default;
+  explicit Fixed128(double value) {
+    value = std::max(-127.0, std::min(127.0, value));
+    /* The top 64 bits hold value's bits down to 2^-56, the rest below. */
+    double high = std::floor(std::ldexp(value, 56));
+    double low = std::ldexp(value - std::ldexp(high, -56), 120);
+    raw = static_cast<unsigned __int128>(static_cast<int64_t>(high)) << 64 |
+          static_cast<uint64_t>(low);
+  }
+};
+
+inline Fixed128 FromRaw(unsigned __int128 raw) {
+  Fixed128 value;
+  value.raw = raw;
+  return value;
+}
+
+inline Fixed128 operator+(Fixed128 a, Fixed128 b) {
+  return FromRaw(a.raw + b.raw);
+}
+
+inline Fixed128 operator-(Fixed128 a, Fixed128 b) {
+  return FromRaw(a.raw - b.raw);
+}
+
+inline Fixed128 operator*(Fixed128 a, Fixed128 b) {
+  typedef unsigned __int128 U128;
+  bool negative = (static_cast<__int128>(a.raw) < 0) !=
+                  (static_cast<__int128>(b.raw) < 0);
+  U128 x = static_cast<__int128>(a.raw) < 0 ? -a.raw : a.raw;
+  U128 y = static_cast<__int128>(b.raw) < 0 ? -b.raw : b.raw;
+  uint64_t x0 = uint64_t(x), x1 = uint64_t(x >> 64);
+  uint64_t y0 = uint64_t(y), y1 = uint64_t(y >> 64);
+  /* The 256-bit product as words w0..w3; bits 120 and up are kept. */
+  U128 low = U128(x0) * y0, middle_1 = U128(x0) * y1,
+       middle_2 = U128(x1) * y0, high = U128(x1) * y1;
+  U128 sum = (low >> 64) + uint64_t(middle_1) + uint64_t(middle_2);
+  uint64_t w1 = uint64_t(sum);
+  sum = (sum >> 64) + (middle_1 >> 64) + (middle_2 >> 64) + uint64_t(high);
+  uint64_t w2 = uint64_t(sum);
+  uint64_t w3 = uint64_t(sum >> 64) + uint64_t(high >> 64);
+  U128 product = U128(w3 << 8 | w2 >> 56) << 64 | (w2 << 8 | w1 >> 56);
+  return FromRaw(negative ? -product : product);
+}
+
+inline bool operator<=(Fixed128 a, Fixed128 b) {
+  return static_cast<__int128>(a.raw) <= static_cast<__int128>(b.raw);
+}
+#endif
+
+#if defined(__SIZEOF_FLOAT128__)
+typedef __float128 Float128;
+#define HAVE_FLOAT128 1
+#elif LDBL_MANT_DIG == 113
+typedef long double Float128;
+#define HAVE_FLOAT128 1
+#endif
+
+/*
+ * Same palette as the shaders: http://iquilezles.org/www/articles/palettes/palettes.htm
+ * Rounded to bytes like their packUnorm4x8.
+ */
+void Colorize(float t, unsigned char *rgba) {
+  const float d[3] = {0.3f, 0.3f, 0.5f};
+  const float e[3] = {-0.2f, -0.3f, -0.5f};
+  const float f[3] = {2.1f, 2.0f, 3.0f};
+  const float g[3] = {0.0f, 0.1f, 0.0f};
+  for (int i = 0; i < 3; ++i) {
+    float value = d[i] + e[i] * std::cos(6.28318f * (f[i] * t + g[i]));
+    rgba[i] = static_cast<unsigned char>(255.0f * value + 0.5f);
+  }
+  rgba[3] = 255;
+}
+
+template <typename Real>
+inline Real Abs(Real x) {
+  return x <= Real(0.0) ? Real(0.0) - x : x;
+}
+
+/* (x + iy)^kExponent, multiplied out the way shaders/ do it. */
+template <unsigned kExponent, typename Real>
+inline void Power(Real x, Real y, Real *power_x, Real *power_y) {
+  Real wx = x, wy = y;
+  for (unsigned k = 1; k < kExponent; ++k) {
+    Real t = wx * x - wy * y;
+    wy = wx * y + wy * x;
+    wx = t;
+  }
+  *power_x = wx;
+  *power_y = wy;
+}
+
+/*
+ * The escape-time loop of shaders/escape_time.glsl over Lanes pixels of a
+ * row at once, for one family (and Multibrot exponent) fixed at compile
+ * time. Every lane runs until all of them have escaped; a lane only counts
+ * iterations while it is inside, so the result matches the scalar loop.
+ * The lane loops have no branches, for the vectorizer.
+ */
+template <typename Real, unsigned Lanes, Family kFamily, unsigned kExponent>
+void RenderRange(const View &view, const Fractal &fractal, unsigned width,
+                 unsigned height, unsigned max_iterations, unsigned first_row,
+                 unsigned end_row, unsigned char *rgba) {
+  const bool kJulia = kFamily == Family::kJulia;
+  /* See iterate() in shaders/escape_time.glsl. */
+  const Real kEscape(kFamily == Family::kMandelbrot ? 2.0 : 4.0);
+  const Real kTwo(2.0);
+  const Real julia_x(fractal.julia_x), julia_y(fractal.julia_y);
+  for (unsigned y = first_row; y < end_row; ++y) {
+    Real row_y = Real(view.min_y) + Real(double(y) / height * view.span_y);
+    Real cy = kJulia ? julia_y : row_y;
+    for (unsigned x = 0; x < width; x += Lanes) {
+      Real cx[Lanes], zx[Lanes], zy[Lanes];
+      unsigned inside[Lanes], n[Lanes];
+      for (unsigned l = 0; l < Lanes; ++l) {
+        /* Lanes past the end of the row repeat its last pixel. */
+        unsigned px = std::min(x + l, width - 1);
+        Real row_x =
+            Real(view.min_x) + Real(double(px) / width * view.span_x);
+        cx[l] = kJulia ? julia_x : row_x;
+        zx[l] = kJulia ? row_x : Real(0.0);
+        zy[l] = kJulia ? row_y : Real(0.0);
+        inside[l] = 1;
+        n[l] = 0;
+      }
+      for (unsigned i = 0; i < max_iterations; ++i) {
+        unsigned any = 0;
+        for (unsigned l = 0; l < Lanes; ++l) {
+          Real ax = zx[l], ay = zy[l];
+          if (kFamily == Family::kBurningShip) {
+            ax = Abs(ax);
+            ay = Abs(ay);
+          }
+          if (kFamily == Family::kMultibrot) {
+            Real wx, wy;
+            Power<kExponent>(ax, ay, &wx, &wy);
+            zx[l] = wx + cx[l];
+            zy[l] = wy + cy;
+            /* Keeps the squares below in range for fixed point. */
+            inside[l] &= unsigned(Abs(zx[l]) <= kTwo) &
+                         unsigned(Abs(zy[l]) <= kTwo);
+          } else {
+            Real xx = ax * ax, yy = ay * ay, xy = ax * ay;
+            zx[l] = xx - yy + cx[l];
+            zy[l] = xy + xy + cy;
+          }
+          inside[l] &= unsigned(zx[l] * zx[l] + zy[l] * zy[l] <= kEscape);
+          n[l] += inside[l];
+          any |= inside[l];
+        }
+        if (not any) {
+          break;
+        }
+      }
+      for (unsigned l = 0; l < std::min(Lanes, width - x); ++l) {
+        Colorize(float(n[l]) / float(max_iterations), rgba);
+        rgba += 4;
+      }
+    }
+  }
+}
+
+typedef void (*RangeRenderer)(const View &view, const Fractal &fractal,
+                              unsigned width, unsigned height,
+                              unsigned max_iterations, unsigned first_row,
+                              unsigned end_row, unsigned char *rgba);
+
+template <typename Real, unsigned Lanes>
+RangeRenderer ForFractal(const Fractal &fractal) {
+  switch (fractal.family) {
+    case Family::kMandelbrot:
+      return &RenderRange<Real, Lanes, Family::kMandelbrot, 2>;
+    case Family::kJulia:
+      return &RenderRange<Real, Lanes, Family::kJulia, 2>;
+    case Family::kBurningShip:
+      return &RenderRange<Real, Lanes, Family::kBurningShip, 2>;
+    case Family::kMultibrot:
+      switch (fractal.exponent) {
+        case 3:
+          return &RenderRange<Real, Lanes, Family::kMultibrot, 3>;
+        case 4:
+          return &RenderRange<Real, Lanes, Family::kMultibrot, 4>;
+        case 5:
+          return &RenderRange<Real, Lanes, Family::kMultibrot, 5>;
+        case 6:
+          return &RenderRange<Real, Lanes, Family::kMultibrot, 6>;
+      }
+      break;
+  }
+  throw std::runtime_error("No CPU kernel for Multibrot exponent " +
+                           std::to_string(fractal.exponent) + ".");
+}
+
+template <typename Real>
+RangeRenderer ForLanes(unsigned lanes, const Fractal &fractal) {
+  switch (lanes) {
+    case 1:
+      return ForFractal<Real, 1>(fractal);
+    case 4:
+      return ForFractal<Real, 4>(fractal);
+    case 8:
+      return ForFractal<Real, 8>(fractal);
+    case 16:
+      return ForFractal<Real, 16>(fractal);
+  }
+  throw std::runtime_error("No CPU kernel with " + std::to_string(lanes) +
+                           " lanes.");
+}
+
+/*
+ * Lanes per type when none are asked for: a couple of SIMD registers' worth
+ * for the hardware types, and enough independent chains to hide latency
+ * for the emulated ones. --benchmark-cpu shows the alternatives.
+ */
+unsigned DefaultLanes(Precision precision) {
+  switch (precision) {
+    case Precision::kFloat:
+      return 16;
+    case Precision::kDouble:
+      return 8;
+    case Precision::kFixed128:
+    case Precision::kFloat128:
+      return 1;
+    default:
+      return 4;
+  }
+}
+
+RangeRenderer SelectKernel(Precision precision, unsigned lanes,
+                           const Fractal &fractal) {
+  if (lanes == 0) {
+    lanes = DefaultLanes(precision);
+  }
+  switch (precision) {
+    case Precision::kFloat:
+      return ForLanes<float>(lanes, fractal);
+    case Precision::kDouble:
+      return ForLanes<double>(lanes, fractal);
+    case Precision::kDoubleDouble:
+      return ForLanes<DoubleDouble>(lanes, fractal);
+#ifdef __SIZEOF_INT128__
+    case Precision::kFixed64:
+      return ForLanes<Fixed64>(lanes, fractal);
+    case Precision::kFixed128:
+      return ForLanes<Fixed128>(lanes, fractal);
+#endif
+#ifdef HAVE_FLOAT128
+    case Precision::kFloat128:
+      return ForLanes<Float128>(lanes, fractal);
+#endif
+    default:
+      throw std::runtime_error(PrecisionName(precision) +
+                               std::string(" is not available in this build."));
+  }
+}
+
+/*
+ * Smallest step the type can take at coordinates of the given magnitude:
+ * relative for floating point, absolute for fixed point.
+ */
+double Resolution(Precision precision, double magnitude) {
+  switch (precision) {
+    case Precision::kFloat:
+      return std::ldexp(magnitude, -FLT_MANT_DIG);
+    case Precision::kDouble:
+      return std::ldexp(magnitude, -DBL_MANT_DIG);
+    case Precision::kFixed64:
+      return magnitude < 8.0 ? std::ldexp(1.0, -56) : HUGE_VAL;
+    case Precision::kFixed128:
+      return magnitude < 8.0 ? std::ldexp(1.0, -120) : HUGE_VAL;
+    case Precision::kDoubleDouble:
+      return std::ldexp(magnitude, -2 * DBL_MANT_DIG);
+    default:
+      return std::ldexp(magnitude, -113);
+  }
+}
+
+}  // namespace
+
+Precision ChoosePrecision(const View &view, unsigned width, unsigned height,
+                          unsigned max_iterations) {
+  /*
+   * Resolution must be this many times finer than the pixel spacing. Long
+   * orbits near the boundary amplify the rounding error a lot: measured
+   * against float128, the headroom has to grow about as the square of the
+   * iteration cap.
+   */
+  double headroom =
+      std::max(256.0, double(max_iterations) * max_iterations / 64.0);
+  double spacing = std::min(view.span_x / width, view.span_y / height);
+  double magnitude = std::max(
+      {std::abs(view.min_x), std::abs(view.min_x + view.span_x),
+       std::abs(view.min_y), std::abs(view.min_y + view.span_y)});
+  Precision best = Precision::kDoubleDouble;
+  for (auto precision :
+       {Precision::kFloat, Precision::kDouble, Precision::kFixed64,
+        Precision::kDoubleDouble, Precision::kFixed128, Precision::kFloat128}) {
+    if (not IsAvailable(precision)) {
+      continue;
+    }
+    best = precision;
+    if (Resolution(precision, magnitude) * headroom <= spacing) {
+      break;
+    }
+  }
+  return best;
+}
+
+bool IsAvailable(Precision precision) {
+  switch (precision) {
+    case Precision::kFixed64:
+    case Precision::kFixed128:
+#ifdef __SIZEOF_INT128__
+      return true;
+#else
+      return false;
+#endif
+    case Precision::kFloat128:
+#ifdef HAVE_FLOAT128
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return true;
+  }
+}
+
+const char *PrecisionName(Precision precision) {
+  switch (precision) {
+    case Precision::kAuto:
+      return "auto";
+    case Precision::kFloat:
+      return "float";
+    case Precision::kDouble:
+      return "double";
+    case Precision::kFixed64:
+      return "fixed64";
+    case Precision::kDoubleDouble:
+      return "double-double";
+    case Precision::kFixed128:
+      return "fixed128";
+    case Precision::kFloat128:
+      return "float128";
+  }
+  return "?";
+}
+
+bool ParsePrecision(const std::string &name, Precision *precision) {
+  for (auto candidate : {Precision::kAuto, Precision::kFloat,
+                         Precision::kDouble, Precision::kFixed64,
+                         Precision::kDoubleDouble, Precision::kFixed128,
+                         Precision::kFloat128}) {
+    if (name == PrecisionName(candidate)) {
+      *precision = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *InstructionSet() {
+#if defined(__AVX512F__)
+  return "AVX-512";
+#elif defined(__AVX2__)
+  return "AVX2";
+#elif defined(__AVX__)
+  return "AVX";
+#elif defined(__SSE2__)
+  return "SSE2";
+#elif defined(__ARM_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+void RenderRows(const View &view, unsigned width, unsigned height,
+                unsigned max_iterations, unsigned first_row,
+                unsigned row_count, unsigned char *rgba, unsigned threads,
+                Precision precision, unsigned lanes, const Fractal &fractal) {
+  if (precision == Precision::kAuto) {
+    precision = ChoosePrecision(view, width, height, max_iterations);
+  }
+  RangeRenderer render_range = SelectKernel(precision, lanes, fractal);
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, std::max(1u, row_count));
+  if (threads == 1) {
+    render_range(view, fractal, width, height, max_iterations, first_row,
+                 first_row + row_count, rgba);
+    return;
+  }
+  /* Interleaved chunks of a few rows balance the expensive rows inside the set. */
+  const unsigned kChunkRows = 4;
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t) {
+    pool.emplace_back([=, &view, &fractal] {
+      for (unsigned row = t * kChunkRows; row < row_count;
+           row += threads * kChunkRows) {
+        unsigned end = std::min(row_count, row + kChunkRows);
+        render_range(view, fractal, width, height, max_iterations,
+                     first_row + row, first_row + end,
+                     rgba + size_t(row) * width * 4);
+      }
+    });
+  }
+  for (auto &thread : pool) {
+    thread.join();
+  }
+}
+
+}  // namespace cpu_renderer
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CPU_RENDERER_H
+#define CPU_RENDERER_H
+
+#include <string>
+
+/*
+ * A CPU implementation of the compute shaders, for hosts without a Vulkan
+ * device (such as render workers) and for checking the GPU output. It runs
+ * the same escape-time loop and cosine palette.
+ *
+ * The loop is a single template over the scalar type, the number of pixels
+ * iterated side by side (lanes, which the compiler maps onto SIMD registers
+ * for float and double) and the fractal's formula, so no family pays for
+ * another's generality. Deep zooms need more precision than float, so each
+ * job picks the cheapest scalar type that still resolves its pixel spacing.
+ */
+namespace cpu_renderer {
+
+/*
+ * A rectangle of the complex plane. Pixel (x, y) of a width x height image
+ * samples c = min + (x / width, y / height) * span, as shaders/tiles.comp.
+ */
+struct View {
+  double min_x, min_y;
+  double span_x, span_y;
+};
+
+/* The iterated formula, as kernels::Family for the compute kernels. */
+enum class Family { kMandelbrot, kMultibrot, kJulia, kBurningShip };
+
+struct Fractal {
+  Family family = Family::kMandelbrot;
+  /* Multibrot only: z^exponent + c, for an exponent from 3 to 6. */
+  unsigned exponent = 3;
+  /* Julia only: z^2 + julia, starting from z = c. */
+  double julia_x = 0.0, julia_y = 0.0;
+};
+
+/* Scalar types of the escape-time loop, cheapest first. */
+enum class Precision {
+  kAuto,
+  kFloat,
+  kDouble,
+  /* Signed 64-bit fixed point with 56 fractional bits; |c| must stay < 8. */
+  kFixed64,
+  /* Unevaluated sum of two doubles, about 106 bits of mantissa. */
+  kDoubleDouble,
+  /* Signed 128-bit fixed point with 120 fractional bits; |c| must stay < 8. */
+  kFixed128,
+  /* IEEE binary128 in software: __float128, or long double where it is. */
+  kFloat128,
+};
+
+/*
+ * Cheapest available precision whose resolution at the coordinates of view
+ * is a few hundred times finer than the pixel spacing of a width x height
+ * image (far more for high iteration caps), leaving headroom for the rounding
+ * error the iteration amplifies.
+ */
+Precision ChoosePrecision(const View &view, unsigned width, unsigned height,
+                          unsigned max_iterations);
+
+/* Whether this build has the scalar type (kAuto always is). */
+bool IsAvailable(Precision precision);
+
+/*
+ * "auto", "float", "double", "fixed64", "double-double", "fixed128" or
+ * "float128".
+ */
+const char *PrecisionName(Precision precision);
+
+/* Parses one of the names above. */
+bool ParsePrecision(const std::string &name, Precision *precision);
+
+/* Lane counts the kernels are instantiated for; 0 picks one per type. */
+const unsigned kLaneCounts[] = {1, 4, 8, 16};
+
+/* Instruction set the kernels were compiled for, e.g. "AVX2". */
+const char *InstructionSet();
+
+/*
+ * Renders rows [first_row, first_row + row_count) of a width x height image
+ * of fractal in view into rgba, 4 bytes per pixel. The rows are split
+ * across threads worker threads; 0 uses every core. Throws
+ * std::runtime_error for a precision this build lacks, a lane count not in
+ * kLaneCounts or a Multibrot exponent out of range.
+ */
+void RenderRows(const View &view, unsigned width, unsigned height,
+                unsigned max_iterations, unsigned first_row,
+                unsigned row_count, unsigned char *rgba, unsigned threads = 0,
+                Precision precision = Precision::kAuto, unsigned lanes = 0,
+                const Fractal &fractal = Fractal());
+
+}  // namespace cpu_renderer
+
+#endif
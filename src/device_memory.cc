@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "device_memory.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace device_memory {
+
+Allocator::Allocator(vk::PhysicalDevice physical_device, vk::Device device,
+                     vk::DeviceSize block_size)
+    : device_(device),
+      memory_properties_(physical_device.getMemoryProperties()),
+      granularity_(
+          physical_device.getProperties().limits.bufferImageGranularity),
+      block_size_(block_size) {}
+
+Allocation Allocator::Allocate(const vk::MemoryRequirements &requirements,
+                               uint32_t memory_type_index, Lifetime lifetime) {
+  uint64_t offset;
+  if (lifetime == Lifetime::kFrame) {
+    if (requirements.size > block_size_) {
+      throw std::runtime_error(
+          "Per-frame allocation of " + std::to_string(requirements.size) +
+          " bytes does not fit the staging ring.");
+    }
+    for (uint32_t i = 0; i < blocks_.size(); ++i) {
+      auto &block = blocks_[i];
+      if (block and block->ring and
+          block->memory_type_index == memory_type_index) {
+        if (not block->ring->Allocate(requirements.size,
+                                      requirements.alignment, &offset)) {
+          throw std::runtime_error(
+              "Staging ring full: retire frames before allocating more.");
+        }
+        return Place(i, offset, requirements.size, lifetime);
+      }
+    }
+    uint32_t i = CreateBlock(memory_type_index, block_size_);
+    blocks_[i]->ring.reset(new suballocator::Ring(block_size_));
+    blocks_[i]->ring->Allocate(requirements.size, requirements.alignment,
+                               &offset);
+    return Place(i, offset, requirements.size, lifetime);
+  }
+  for (uint32_t i = 0; i < blocks_.size(); ++i) {
+    auto &block = blocks_[i];
+    if (block and block->free_list and
+        block->memory_type_index == memory_type_index and
+        block->free_list->Allocate(requirements.size, requirements.alignment,
+                                   true, &offset)) {
+      return Place(i, offset, requirements.size, lifetime);
+    }
+  }
+  uint32_t i = CreateBlock(memory_type_index,
+                           std::max(block_size_, requirements.size));
+  blocks_[i]->free_list.reset(
+      new suballocator::FreeList(std::max(block_size_, requirements.size),
+                                 granularity_));
+  blocks_[i]->free_list->Allocate(requirements.size, requirements.alignment,
+                                  true, &offset);
+  return Place(i, offset, requirements.size, lifetime);
+}
+
+void Allocator::Free(const Allocation &allocation) {
+  if (allocation.lifetime != Lifetime::kLongLived or
+      allocation.block >= blocks_.size() or not blocks_[allocation.block]) {
+    throw std::invalid_argument("Allocator::Free: not a live allocation.");
+  }
+  auto &block = blocks_[allocation.block];
+  block->free_list->Free(allocation.offset);
+  /* Oversized blocks served a single resource; regular ones are kept. */
+  if (block->free_list->allocations() == 0 and
+      block->free_list->size() > block_size_) {
+    block.reset();
+  }
+}
+
+Allocation Allocator::AllocateForBuffer(vk::Buffer buffer,
+                                        uint32_t memory_type_index,
+                                        Lifetime lifetime) {
+  auto allocation =
+      Allocate(device_.getBufferMemoryRequirements(buffer), memory_type_index,
+               lifetime);
+  device_.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+  return allocation;
+}
+
+void Allocator::EndFrame() {
+  for (auto &block : blocks_) {
+    if (block and block->ring) {
+      block->ring->EndFrame();
+    }
+  }
+}
+
+void Allocator::RetireFrame() {
+  for (auto &block : blocks_) {
+    if (block and block->ring) {
+      block->ring->RetireFrame();
+    }
+  }
+}
+
+Stats Allocator::stats() const {
+  Stats stats;
+  for (const auto &block : blocks_) {
+    if (not block) {
+      continue;
+    }
+    ++stats.blocks;
+    if (block->free_list) {
+      stats.block_bytes += block->free_list->size();
+      stats.allocations += block->free_list->allocations();
+      stats.allocated_bytes += block->free_list->used();
+    } else {
+      stats.block_bytes += block->ring->size();
+      stats.frame_bytes += block->ring->used();
+    }
+  }
+  stats.device_allocations = device_allocations_;
+  return stats;
+}
+
+vk::DeviceSize Allocator::HeapBlockBytes(uint32_t heap_index) const {
+  vk::DeviceSize bytes = 0;
+  for (const auto &block : blocks_) {
+    if (block and
+        memory_properties_.memoryTypes[block->memory_type_index].heapIndex ==
+            heap_index) {
+      bytes += block->free_list ? block->free_list->size()
+                                : block->ring->size();
+    }
+  }
+  return bytes;
+}
+
+uint32_t Allocator::CreateBlock(uint32_t memory_type_index,
+                                vk::DeviceSize size) {
+  std::unique_ptr<Block> block(new Block());
+  auto allocate_info = vk::MemoryAllocateInfo();
+  allocate_info.setAllocationSize(size).setMemoryTypeIndex(memory_type_index);
+  block->memory = device_.allocateMemoryUnique(allocate_info);
+  ++device_allocations_;
+  block->memory_type_index = memory_type_index;
+  block->mapped = nullptr;
+  if (memory_properties_.memoryTypes[memory_type_index].propertyFlags &
+      vk::MemoryPropertyFlagBits::eHostVisible) {
+    block->mapped = device_.mapMemory(*block->memory, 0, VK_WHOLE_SIZE);
+  }
+  /* Reuse the slot of a released block. */
+  for (uint32_t i = 0; i < blocks_.size(); ++i) {
+    if (not blocks_[i]) {
+      blocks_[i] = std::move(block);
+      return i;
+    }
+  }
+  blocks_.push_back(std::move(block));
+  return blocks_.size() - 1;
+}
+
+Allocation Allocator::Place(uint32_t block, uint64_t offset,
+                            vk::DeviceSize size, Lifetime lifetime) const {
+  Allocation allocation;
+  allocation.memory = *blocks_[block]->memory;
+  allocation.offset = offset;
+  allocation.size = size;
+  if (blocks_[block]->mapped) {
+    allocation.mapped = static_cast<char *>(blocks_[block]->mapped) + offset;
+  }
+  allocation.lifetime = lifetime;
+  allocation.block = block;
+  return allocation;
+}
+
+}  // namespace device_memory
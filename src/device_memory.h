@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DEVICE_MEMORY_H
+#define DEVICE_MEMORY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "suballocator.h"
+
+/*
+ * Sub-allocates Vulkan memory from a few large blocks per memory type
+ * instead of one vkAllocateMemory per resource, which is slow and limited
+ * to maxMemoryAllocationCount live allocations. Long-lived resources get
+ * first-fit space in shared blocks; per-frame staging data is bump-allocated
+ * from a ring per memory type and released a frame at a time. Host-visible
+ * blocks are mapped once, for their lifetime.
+ *
+ * Not thread-safe.
+ */
+namespace device_memory {
+
+enum class Lifetime {
+  /* Until Free(). */
+  kLongLived,
+  /* Until the RetireFrame() of the frame it was allocated in. */
+  kFrame,
+};
+
+struct Allocation {
+  vk::DeviceMemory memory;
+  vk::DeviceSize offset = 0;
+  vk::DeviceSize size = 0;
+  /* Host address of offset in host-visible memory, null otherwise. */
+  void *mapped = nullptr;
+  Lifetime lifetime = Lifetime::kLongLived;
+  uint32_t block = 0;
+};
+
+struct Stats {
+  /* Live vkAllocateMemory allocations and their total size. */
+  uint32_t blocks = 0;
+  vk::DeviceSize block_bytes = 0;
+  /* Live long-lived allocations and their total size. */
+  uint32_t allocations = 0;
+  vk::DeviceSize allocated_bytes = 0;
+  /* Ring bytes held by frames not retired yet. */
+  vk::DeviceSize frame_bytes = 0;
+  /* vkAllocateMemory calls over the allocator's lifetime. */
+  uint64_t device_allocations = 0;
+};
+
+class Allocator {
+ public:
+  static const vk::DeviceSize kDefaultBlockSize = 64 << 20;
+
+  Allocator(vk::PhysicalDevice physical_device, vk::Device device,
+            vk::DeviceSize block_size = kDefaultBlockSize);
+
+  Allocator(const Allocator &) = delete;
+  Allocator &operator=(const Allocator &) = delete;
+
+  /*
+   * Returns memory of memory_type_index meeting requirements. Resources
+   * larger than a block get a block of their own, released when they are
+   * freed. Throws vk::SystemError when the device is out of memory.
+   */
+  Allocation Allocate(const vk::MemoryRequirements &requirements,
+                      uint32_t memory_type_index, Lifetime lifetime);
+  /* Releases a long-lived allocation. */
+  void Free(const Allocation &allocation);
+
+  /* Allocates and binds memory for buffer. */
+  Allocation AllocateForBuffer(vk::Buffer buffer, uint32_t memory_type_index,
+                               Lifetime lifetime);
+
+  /* See suballocator::Ring. */
+  void EndFrame();
+  void RetireFrame();
+
+  Stats stats() const;
+  /* Total size of the live blocks of memory types in heap heap_index. */
+  vk::DeviceSize HeapBlockBytes(uint32_t heap_index) const;
+
+ private:
+  struct Block {
+    vk::UniqueDeviceMemory memory;
+    uint32_t memory_type_index;
+    void *mapped;
+    /* One of the two is set. */
+    std::unique_ptr<suballocator::FreeList> free_list;
+    std::unique_ptr<suballocator::Ring> ring;
+  };
+
+  uint32_t CreateBlock(uint32_t memory_type_index, vk::DeviceSize size);
+  Allocation Place(uint32_t block, uint64_t offset, vk::DeviceSize size,
+                   Lifetime lifetime) const;
+
+  vk::Device device_;
+  vk::PhysicalDeviceMemoryProperties memory_properties_;
+  vk::DeviceSize granularity_;
+  vk::DeviceSize block_size_;
+  /* Released blocks leave a null entry, so block indices stay valid. */
+  std::vector<std::unique_ptr<Block>> blocks_;
+  uint64_t device_allocations_ = 0;
+};
+
+}  // namespace device_memory
+
+#endif
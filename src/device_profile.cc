@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "device_profile.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace device_profile {
+
+namespace {
+
+const int kVersion = 3;
+
+using Fields = std::map<std::string, std::string>;
+
+bool GetString(const Fields &fields, const char *key, std::string *value) {
+  auto field = fields.find(key);
+  if (field == fields.end()) {
+    return false;
+  }
+  *value = field->second;
+  return true;
+}
+
+/* Reads count comma-separated unsigned values. */
+bool GetUints(const Fields &fields, const char *key, uint32_t *values,
+              size_t count = 1) {
+  std::string text;
+  if (not GetString(fields, key, &text)) {
+    return false;
+  }
+  std::istringstream in(text);
+  for (size_t i = 0; i < count; ++i) {
+    char comma;
+    if (not(in >> values[i]) or (i + 1 < count and not(in >> comma))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GetBool(const Fields &fields, const char *key, bool *value) {
+  uint32_t number;
+  if (not GetUints(fields, key, &number)) {
+    return false;
+  }
+  *value = number != 0;
+  return true;
+}
+
+}  // namespace
+
+bool Load(const std::string &filename, Profile *profile) {
+  std::ifstream in(filename);
+  if (not in.good()) {
+    return false;
+  }
+  Fields fields;
+  std::string line;
+  while (std::getline(in, line)) {
+    auto equals = line.find('=');
+    if (line.empty() or line[0] == '#' or equals == std::string::npos) {
+      continue;
+    }
+    fields[line.substr(0, equals)] = line.substr(equals + 1);
+  }
+  uint32_t version = 0;
+  return GetUints(fields, "version", &version) and version == kVersion and
+         GetUints(fields, "vendor_id", &profile->vendor_id) and
+         GetUints(fields, "device_id", &profile->device_id) and
+         GetUints(fields, "driver_version", &profile->driver_version) and
+         GetString(fields, "pipeline_cache_uuid",
+                   &profile->pipeline_cache_uuid) and
+         GetString(fields, "device_name", &profile->device_name) and
+         GetUints(fields, "queue_family_index",
+                  &profile->queue_family_index) and
+         GetUints(fields, "memory_type_index", &profile->memory_type_index) and
+         GetBool(fields, "validation_layer", &profile->validation_layer) and
+         GetBool(fields, "debug_report", &profile->debug_report) and
+         GetBool(fields, "physical_device_properties2",
+                 &profile->physical_device_properties2) and
+         GetBool(fields, "push_descriptor", &profile->push_descriptor) and
+         GetBool(fields, "memory_budget", &profile->memory_budget) and
+         GetBool(fields, "shader_int64", &profile->shader_int64) and
+         GetUints(fields, "max_compute_work_group_invocations",
+                  &profile->max_compute_work_group_invocations) and
+         GetUints(fields, "max_compute_work_group_size",
+                  profile->max_compute_work_group_size, 3) and
+         GetUints(fields, "max_compute_work_group_count",
+                  profile->max_compute_work_group_count, 3) and
+         GetUints(fields, "max_storage_buffer_range",
+                  &profile->max_storage_buffer_range);
+}
+
+void Save(const std::string &filename, const Profile &profile) {
+  auto triple = [](const uint32_t *values) {
+    return std::to_string(values[0]) + "," + std::to_string(values[1]) + "," +
+           std::to_string(values[2]);
+  };
+  std::ostringstream out;
+  out << "# Device profile written by mandelbrot; delete to re-probe.\n"
+      << "version=" << kVersion << "\n"
+      << "vendor_id=" << profile.vendor_id << "\n"
+      << "device_id=" << profile.device_id << "\n"
+      << "driver_version=" << profile.driver_version << "\n"
+      << "pipeline_cache_uuid=" << profile.pipeline_cache_uuid << "\n"
+      << "device_name=" << profile.device_name << "\n"
+      << "queue_family_index=" << profile.queue_family_index << "\n"
+      << "memory_type_index=" << profile.memory_type_index << "\n"
+      << "validation_layer=" << profile.validation_layer << "\n"
+      << "debug_report=" << profile.debug_report << "\n"
+      << "physical_device_properties2="
+      << profile.physical_device_properties2 << "\n"
+      << "push_descriptor=" << profile.push_descriptor << "\n"
+      << "memory_budget=" << profile.memory_budget << "\n"
+      << "shader_int64=" << profile.shader_int64 << "\n"
+      << "max_compute_work_group_invocations="
+      << profile.max_compute_work_group_invocations << "\n"
+      << "max_compute_work_group_size="
+      << triple(profile.max_compute_work_group_size) << "\n"
+      << "max_compute_work_group_count="
+      << triple(profile.max_compute_work_group_count) << "\n"
+      << "max_storage_buffer_range=" << profile.max_storage_buffer_range
+      << "\n";
+
+  /*
+   * Jobs starting together may all save a profile: each writes its own
+   * temporary file next to the profile, and the last rename wins.
+   */
+  std::string temporary = filename + ".XXXXXX";
+  int fd = mkstemp(&temporary[0]);
+  if (fd < 0) {
+    throw std::runtime_error(temporary + ": " + std::strerror(errno));
+  }
+  std::string contents = out.str();
+  /* mkstemp creates it private; make it as readable as a plain file. */
+  bool written =
+      fchmod(fd, 0644) == 0 and
+      write(fd, contents.data(), contents.size()) == ssize_t(contents.size());
+  written = close(fd) == 0 and written;
+  if (not written) {
+    unlink(temporary.c_str());
+    throw std::runtime_error(temporary + ": write error.");
+  }
+  if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    unlink(temporary.c_str());
+    throw std::runtime_error(filename + ": could not replace.");
+  }
+}
+
+bool SameDevice(const Profile &a, const Profile &b) {
+  for (int i = 0; i < 3; ++i) {
+    if (a.max_compute_work_group_size[i] !=
+            b.max_compute_work_group_size[i] or
+        a.max_compute_work_group_count[i] !=
+            b.max_compute_work_group_count[i]) {
+      return false;
+    }
+  }
+  return a.vendor_id == b.vendor_id and a.device_id == b.device_id and
+         a.driver_version == b.driver_version and
+         a.pipeline_cache_uuid == b.pipeline_cache_uuid and
+         a.max_compute_work_group_invocations ==
+             b.max_compute_work_group_invocations and
+         a.max_storage_buffer_range == b.max_storage_buffer_range;
+}
+
+std::string HexString(const uint8_t *bytes, size_t size) {
+  static const char kDigits[] = "0123456789abcdef";
+  std::string hex;
+  for (size_t i = 0; i < size; ++i) {
+    hex += kDigits[bytes[i] >> 4];
+    hex += kDigits[bytes[i] & 15];
+  }
+  return hex;
+}
+
+}  // namespace device_profile
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DEVICE_PROFILE_H
+#define DEVICE_PROFILE_H
+
+#include <cstdint>
+#include <string>
+
+/*
+ * What a run learns about the Vulkan installation before it can render: the
+ * layers and extensions available, the device picked, its compute queue
+ * family, host-visible memory type and compute limits. Saved to a small text
+ * file, it lets later runs on the same host skip enumerating everything;
+ * they only check that the recorded device is still there, unchanged.
+ */
+namespace device_profile {
+
+struct Profile {
+  /* Identify the physical device and its driver. */
+  uint32_t vendor_id = 0;
+  uint32_t device_id = 0;
+  uint32_t driver_version = 0;
+  std::string pipeline_cache_uuid;  // hex
+  std::string device_name;          // for people reading the file
+
+  uint32_t queue_family_index = 0;
+  uint32_t memory_type_index = 0;  // host-visible, host-coherent
+
+  bool validation_layer = false;
+  bool debug_report = false;
+  bool physical_device_properties2 = false;
+  bool push_descriptor = false;
+  bool memory_budget = false;
+  /* The shaderInt64 feature, for the fixed-point kernel. */
+  bool shader_int64 = false;
+
+  uint32_t max_compute_work_group_invocations = 0;
+  uint32_t max_compute_work_group_size[3] = {0, 0, 0};
+  uint32_t max_compute_work_group_count[3] = {0, 0, 0};
+  uint32_t max_storage_buffer_range = 0;
+};
+
+/* False if the file is missing, malformed or from another version. */
+bool Load(const std::string &filename, Profile *profile);
+
+/*
+ * Replaces the file atomically, through a temporary file of its own, so
+ * concurrent saves do not collide. Throws std::runtime_error on failure.
+ */
+void Save(const std::string &filename, const Profile &profile);
+
+/* True if a and b describe the same device, driver and compute limits. */
+bool SameDevice(const Profile &a, const Profile &b);
+
+/* Hex encoding of a device or pipeline cache UUID. */
+std::string HexString(const uint8_t *bytes, size_t size);
+
+}  // namespace device_profile
+
+#endif
@@ -0,0 +1,646 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "distributed.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "image_writers.h"
+
+namespace distributed {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Every message is an 8-byte header (type, payload size) followed by the
+ * payload. All integers are little-endian 32-bit; doubles travel as their
+ * 64 bits, low word first.
+ *
+ *   kHello   worker -> coordinator, empty
+ *   kJob     coordinator -> worker: band, first row, row count, width,
+ *            height, max iterations, precision, lanes, family, exponent,
+ *            then the doubles min x, min y, span x, span y, julia x, julia y
+ *   kResult  worker -> coordinator: band, then row count * width RGBA8 pixels
+ *   kDone    coordinator -> worker, empty: the render is over
+ */
+enum MessageType : uint32_t {
+  kHello = 1,
+  kJob = 2,
+  kResult = 3,
+  kDone = 4,
+};
+
+const size_t kHeaderSize = 8;
+const size_t kJobSize = 88;
+
+/* Before the first band returns there is no average to scale from. */
+const double kInitialRetrySeconds = 60.0;
+const double kMinimumRetrySeconds = 10.0;
+/* The coordinator gives up when no worker has been connected this long. */
+const double kNoWorkerSeconds = 60.0;
+/* How long spawned workers get to exit once the render is over. */
+const double kReapSeconds = 2.0;
+/* How long a worker keeps trying to reach the coordinator. */
+const double kConnectSeconds = 10.0;
+
+void PutU32(std::vector<unsigned char> *out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out->push_back(static_cast<unsigned char>(value >> (8 * i)));
+  }
+}
+
+void PutDouble(std::vector<unsigned char> *out, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, 8);
+  PutU32(out, static_cast<uint32_t>(bits));
+  PutU32(out, static_cast<uint32_t>(bits >> 32));
+}
+
+uint32_t GetU32(const unsigned char *in) {
+  return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 |
+         uint32_t(in[3]) << 24;
+}
+
+double GetDouble(const unsigned char *in) {
+  uint64_t bits = GetU32(in) | uint64_t(GetU32(in + 4)) << 32;
+  double value;
+  std::memcpy(&value, &bits, 8);
+  return value;
+}
+
+std::vector<unsigned char> Header(MessageType type, size_t payload_size) {
+  std::vector<unsigned char> header;
+  PutU32(&header, type);
+  PutU32(&header, static_cast<uint32_t>(payload_size));
+  return header;
+}
+
+/* Sends everything, waiting out a full socket buffer. False on failure. */
+bool SendAll(int fd, const void *data, size_t size) {
+  auto bytes = static_cast<const unsigned char *>(data);
+  while (size > 0) {
+    ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+    if (sent < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) {
+      pollfd wait = {fd, POLLOUT, 0};
+      poll(&wait, 1, -1);
+      continue;
+    }
+    if (sent < 0 and errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    bytes += sent;
+    size -= size_t(sent);
+  }
+  return true;
+}
+
+/* Blocking read of exactly size bytes. False on EOF or error. */
+bool ReceiveAll(int fd, void *data, size_t size) {
+  auto bytes = static_cast<unsigned char *>(data);
+  while (size > 0) {
+    ssize_t received = recv(fd, bytes, size, 0);
+    if (received < 0 and errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      return false;
+    }
+    bytes += received;
+    size -= size_t(received);
+  }
+  return true;
+}
+
+double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Band {
+  unsigned first_row = 0, row_count = 0;
+  bool done = false;
+  bool queued = false;     // waiting in the pending queue
+  unsigned attempts = 0;   // hand-outs so far
+  unsigned in_flight = 0;  // workers currently holding it
+  Clock::time_point handed_out;
+  std::vector<unsigned char> pixels;  // finished, not yet streamed
+};
+
+struct Connection {
+  int fd = -1;
+  bool ready = false;  // said hello
+  std::vector<unsigned char> inbox;
+  std::vector<std::pair<unsigned, Clock::time_point>> assigned;
+  unsigned completed = 0, stolen = 0;
+};
+
+class Coordinator {
+ public:
+  Coordinator(const RenderJob &job, const CoordinatorOptions &options,
+              const std::string &output)
+      : job_(job),
+        options_(options),
+        stream_(output, job.width, job.height) {
+    for (unsigned row = 0; row < job.height; row += job.band_rows) {
+      Band band;
+      band.first_row = row;
+      band.row_count = std::min(job.band_rows, job.height - row);
+      band.queued = true;
+      pending_.push_back(unsigned(bands_.size()));
+      bands_.push_back(std::move(band));
+    }
+  }
+
+  ~Coordinator() {
+    for (auto &connection : connections_) {
+      close(connection->fd);
+    }
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+    }
+    ReapWorkers();
+  }
+
+  void Run() {
+    auto start = Clock::now();
+    Listen();
+    SpawnWorkers();
+    auto last_connected = Clock::now();
+    while (next_to_stream_ < bands_.size()) {
+      std::vector<pollfd> fds = {{listen_fd_, POLLIN, 0}};
+      for (auto &connection : connections_) {
+        fds.push_back({connection->fd, POLLIN, 0});
+      }
+      if (poll(fds.data(), fds.size(), 100) < 0 and errno != EINTR) {
+        throw std::runtime_error("poll failed.");
+      }
+      if (fds[0].revents & POLLIN) {
+        Accept();
+      }
+      /* Backwards, so dropping a connection leaves the others in place. */
+      for (size_t i = connections_.size(); i-- > 0;) {
+        if (fds[i + 1].revents != 0 and not Receive(*connections_[i])) {
+          Drop(i);
+        }
+      }
+      RetryOverdue();
+      for (size_t i = connections_.size(); i-- > 0;) {
+        if (not Feed(*connections_[i])) {
+          Drop(i);
+        }
+      }
+      if (not connections_.empty()) {
+        last_connected = Clock::now();
+      } else if (SecondsSince(last_connected) > kNoWorkerSeconds) {
+        throw std::runtime_error("No render worker connected.");
+      }
+    }
+
+    auto done = Header(kDone, 0);
+    for (auto &connection : connections_) {
+      SendAll(connection->fd, done.data(), done.size());
+    }
+    stream_.Finish();
+
+    std::cerr << "Rendered " << bands_.size() << " bands of " << job_.width
+              << "x" << job_.band_rows << " in " << SecondsSince(start)
+              << " s: " << retries_ << " retried, " << steals_
+              << " stolen, " << duplicates_ << " duplicate results."
+              << std::endl;
+    for (auto &connection : connections_) {
+      std::cerr << "  worker " << connection->fd << ": "
+                << connection->completed << " bands, " << connection->stolen
+                << " stolen" << std::endl;
+    }
+  }
+
+ private:
+  void Listen() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int yes = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(options_.port);
+    socklen_t length = sizeof(address);
+    if (listen_fd_ < 0 or
+        bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), length) != 0 or
+        listen(listen_fd_, 64) != 0 or
+        getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&address),
+                    &length) != 0) {
+      throw std::runtime_error("Could not listen on port " +
+                               std::to_string(options_.port) + ".");
+    }
+    port_ = ntohs(address.sin_port);
+    std::cerr << "Coordinator listening on port " << port_ << ", "
+              << bands_.size() << " bands to render." << std::endl;
+  }
+
+  void SpawnWorkers() {
+    if (options_.spawn_workers == 0) {
+      return;
+    }
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency() /
+                                        options_.spawn_workers);
+    std::string worker = "--worker=127.0.0.1:" + std::to_string(port_);
+    std::string worker_threads = "--worker-threads=" + std::to_string(threads);
+    for (unsigned i = 0; i < options_.spawn_workers; ++i) {
+      pid_t child = fork();
+      if (child < 0) {
+        throw std::runtime_error("Could not start a render worker.");
+      }
+      if (child == 0) {
+        execl(options_.worker_executable.c_str(), "mandelbrot", worker.c_str(),
+              worker_threads.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+      }
+      children_.push_back(child);
+    }
+  }
+
+  /* Spawned workers exit on kDone or EOF; a hung one is killed. */
+  void ReapWorkers() {
+    auto start = Clock::now();
+    while (not children_.empty()) {
+      bool overdue = SecondsSince(start) > kReapSeconds;
+      for (size_t i = children_.size(); i-- > 0;) {
+        if (overdue) {
+          kill(children_[i], SIGKILL);
+        }
+        if (waitpid(children_[i], nullptr, overdue ? 0 : WNOHANG) != 0) {
+          children_.erase(children_.begin() + i);
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  void Accept() {
+    for (;;) {
+      int fd = accept4(listen_fd_, nullptr, nullptr,
+                       SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        return;
+      }
+      int yes = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+      std::unique_ptr<Connection> connection(new Connection);
+      connection->fd = fd;
+      connections_.push_back(std::move(connection));
+    }
+  }
+
+  /* Reads what arrived and handles complete messages. False to drop. */
+  bool Receive(Connection &connection) {
+    auto &inbox = connection.inbox;
+    for (;;) {
+      size_t old_size = inbox.size();
+      inbox.resize(old_size + (1 << 20));
+      ssize_t received = recv(connection.fd, inbox.data() + old_size,
+                              inbox.size() - old_size, 0);
+      inbox.resize(old_size + size_t(std::max<ssize_t>(received, 0)));
+      if (received == 0) {
+        return false;
+      }
+      if (received < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN or errno == EWOULDBLOCK) {
+          break;
+        }
+        return false;
+      }
+    }
+    size_t offset = 0;
+    while (inbox.size() - offset >= kHeaderSize) {
+      uint32_t type = GetU32(&inbox[offset]);
+      size_t size = GetU32(&inbox[offset + 4]);
+      if (inbox.size() - offset - kHeaderSize < size) {
+        break;
+      }
+      if (not Handle(connection, type, &inbox[offset + kHeaderSize], size)) {
+        return false;
+      }
+      offset += kHeaderSize + size;
+    }
+    inbox.erase(inbox.begin(), inbox.begin() + offset);
+    return true;
+  }
+
+  bool Handle(Connection &connection, uint32_t type,
+              const unsigned char *payload, size_t size) {
+    if (type == kHello) {
+      connection.ready = true;
+      return true;
+    }
+    if (type != kResult or size < 4) {
+      return false;  // protocol error
+    }
+    unsigned index = GetU32(payload);
+    auto &assigned = connection.assigned;
+    auto held = std::find_if(
+        assigned.begin(), assigned.end(),
+        [index](const std::pair<unsigned, Clock::time_point> &entry) {
+          return entry.first == index;
+        });
+    if (held == assigned.end()) {
+      return false;  // not a band this worker was given
+    }
+    Band &band = bands_[index];
+    if (size != 4 + size_t(band.row_count) * job_.width * 4) {
+      return false;
+    }
+    total_band_seconds_ += SecondsSince(held->second);
+    ++timed_bands_;
+    assigned.erase(held);
+    --band.in_flight;
+    if (band.done) {
+      ++duplicates_;
+      return true;
+    }
+    band.done = true;
+    band.pixels.assign(payload + 4, payload + size);
+    ++connection.completed;
+    StreamFinishedBands();
+    return true;
+  }
+
+  /* Tops up the worker's queue of bands. False if the worker is gone. */
+  bool Feed(Connection &connection) {
+    if (not connection.ready) {
+      return true;
+    }
+    while (connection.assigned.size() < options_.worker_queue_depth) {
+      int index = NextBand(connection);
+      if (index < 0) {
+        break;
+      }
+      Band &band = bands_[index];
+      auto message = Header(kJob, kJobSize);
+      PutU32(&message, unsigned(index));
+      PutU32(&message, band.first_row);
+      PutU32(&message, band.row_count);
+      PutU32(&message, job_.width);
+      PutU32(&message, job_.height);
+      PutU32(&message, job_.max_iterations);
+      PutU32(&message, static_cast<uint32_t>(job_.precision));
+      PutU32(&message, job_.lanes);
+      PutU32(&message, static_cast<uint32_t>(job_.fractal.family));
+      PutU32(&message, job_.fractal.exponent);
+      PutDouble(&message, job_.view.min_x);
+      PutDouble(&message, job_.view.min_y);
+      PutDouble(&message, job_.view.span_x);
+      PutDouble(&message, job_.view.span_y);
+      PutDouble(&message, job_.fractal.julia_x);
+      PutDouble(&message, job_.fractal.julia_y);
+      ++band.attempts;
+      ++band.in_flight;
+      band.handed_out = Clock::now();
+      connection.assigned.emplace_back(unsigned(index), band.handed_out);
+      if (not SendAll(connection.fd, message.data(), message.size())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /* The lowest pending band, or a band to steal if the worker is idle. */
+  int NextBand(Connection &connection) {
+    while (not pending_.empty()) {
+      unsigned index = pending_.front();
+      pending_.pop_front();
+      bands_[index].queued = false;
+      if (not bands_[index].done) {
+        return int(index);
+      }
+    }
+    if (not connection.assigned.empty() or timed_bands_ == 0) {
+      return -1;
+    }
+    double threshold = AverageBandSeconds() * options_.steal_factor;
+    int oldest = -1;
+    for (size_t i = next_to_stream_; i < bands_.size(); ++i) {
+      const Band &band = bands_[i];
+      if (band.done or band.in_flight != 1 or
+          SecondsSince(band.handed_out) < threshold) {
+        continue;
+      }
+      if (oldest < 0 or band.handed_out < bands_[oldest].handed_out) {
+        oldest = int(i);
+      }
+    }
+    if (oldest >= 0) {
+      ++steals_;
+      ++connection.stolen;
+    }
+    return oldest;
+  }
+
+  /* Hands out again the bands that have been out for far too long. */
+  void RetryOverdue() {
+    double timeout =
+        timed_bands_ == 0
+            ? kInitialRetrySeconds
+            : std::max(kMinimumRetrySeconds,
+                       AverageBandSeconds() * options_.retry_factor);
+    for (size_t i = next_to_stream_; i < bands_.size(); ++i) {
+      Band &band = bands_[i];
+      if (not band.done and not band.queued and band.in_flight > 0 and
+          SecondsSince(band.handed_out) > timeout) {
+        Requeue(unsigned(i));
+      }
+    }
+  }
+
+  void Requeue(unsigned index) {
+    Band &band = bands_[index];
+    if (band.attempts >= options_.max_attempts) {
+      throw std::runtime_error("Band " + std::to_string(index) + " failed " +
+                               std::to_string(band.attempts) + " times.");
+    }
+    band.queued = true;
+    pending_.push_front(index);
+    ++retries_;
+  }
+
+  /* Closes a connection and gives its unfinished bands to the others. */
+  void Drop(size_t i) {
+    Connection &connection = *connections_[i];
+    for (auto &entry : connection.assigned) {
+      Band &band = bands_[entry.first];
+      --band.in_flight;
+      if (not band.done and not band.queued and band.in_flight == 0) {
+        Requeue(entry.first);
+      }
+    }
+    std::cerr << "Worker " << connection.fd << " disconnected after "
+              << connection.completed << " bands." << std::endl;
+    close(connection.fd);
+    connections_.erase(connections_.begin() + i);
+  }
+
+  void StreamFinishedBands() {
+    while (next_to_stream_ < bands_.size() and bands_[next_to_stream_].done) {
+      Band &band = bands_[next_to_stream_];
+      stream_.AddRows(band.pixels.data(), band.row_count);
+      std::vector<unsigned char>().swap(band.pixels);
+      ++next_to_stream_;
+    }
+  }
+
+  double AverageBandSeconds() const {
+    return total_band_seconds_ / timed_bands_;
+  }
+
+  RenderJob job_;
+  CoordinatorOptions options_;
+  image_writers::PngStream stream_;
+
+  std::vector<Band> bands_;
+  std::deque<unsigned> pending_;
+  size_t next_to_stream_ = 0;
+
+  int listen_fd_ = -1;
+  uint16_t port_ = 0;
+  std::vector<std::unique_ptr<Connection>> connections_;
+  std::vector<pid_t> children_;
+
+  double total_band_seconds_ = 0.0;
+  unsigned timed_bands_ = 0;
+  unsigned retries_ = 0, steals_ = 0, duplicates_ = 0;
+};
+
+int Connect(const std::string &address) {
+  auto colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    throw std::runtime_error(address + ": expected HOST:PORT.");
+  }
+  std::string host = address.substr(0, colon);
+  std::string port = address.substr(colon + 1);
+  auto start = Clock::now();
+  for (;;) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *results = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &results) == 0) {
+      for (addrinfo *entry = results; entry != nullptr; entry = entry->ai_next) {
+        int fd = socket(entry->ai_family, entry->ai_socktype | SOCK_CLOEXEC,
+                        entry->ai_protocol);
+        if (fd >= 0 and connect(fd, entry->ai_addr, entry->ai_addrlen) == 0) {
+          freeaddrinfo(results);
+          int yes = 1;
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+          return fd;
+        }
+        if (fd >= 0) {
+          close(fd);
+        }
+      }
+      freeaddrinfo(results);
+    }
+    if (SecondsSince(start) > kConnectSeconds) {
+      throw std::runtime_error(address + ": could not connect.");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+}  // namespace
+
+void RunCoordinator(const RenderJob &job, const CoordinatorOptions &options,
+                    const std::string &output) {
+  if (job.width == 0 or job.height == 0 or job.band_rows == 0) {
+    throw std::runtime_error("Empty render.");
+  }
+  Coordinator coordinator(job, options, output);
+  coordinator.Run();
+}
+
+void RunWorker(const std::string &address, unsigned threads) {
+  int fd = Connect(address);
+  auto hello = Header(kHello, 0);
+  if (not SendAll(fd, hello.data(), hello.size())) {
+    close(fd);
+    throw std::runtime_error(address + ": connection lost.");
+  }
+  std::vector<unsigned char> message;
+  unsigned char header[kHeaderSize], job[kJobSize];
+  while (ReceiveAll(fd, header, kHeaderSize)) {
+    uint32_t type = GetU32(header);
+    uint32_t size = GetU32(header + 4);
+    if (type != kJob or size != kJobSize or not ReceiveAll(fd, job, size)) {
+      break;  // kDone, or the coordinator went away
+    }
+    unsigned index = GetU32(job);
+    unsigned first_row = GetU32(job + 4), row_count = GetU32(job + 8);
+    unsigned width = GetU32(job + 12), height = GetU32(job + 16);
+    unsigned max_iterations = GetU32(job + 20);
+    auto precision = static_cast<cpu_renderer::Precision>(GetU32(job + 24));
+    unsigned lanes = GetU32(job + 28);
+    cpu_renderer::Fractal fractal;
+    fractal.family = static_cast<cpu_renderer::Family>(GetU32(job + 32));
+    fractal.exponent = GetU32(job + 36);
+    cpu_renderer::View view = {GetDouble(job + 40), GetDouble(job + 48),
+                               GetDouble(job + 56), GetDouble(job + 64)};
+    fractal.julia_x = GetDouble(job + 72);
+    fractal.julia_y = GetDouble(job + 80);
+
+    size_t pixel_bytes = size_t(row_count) * width * 4;
+    message = Header(kResult, 4 + pixel_bytes);
+    PutU32(&message, index);
+    message.resize(message.size() + pixel_bytes);
+    cpu_renderer::RenderRows(view, width, height, max_iterations, first_row,
+                             row_count, &message[kHeaderSize + 4], threads,
+                             precision, lanes, fractal);
+    if (not SendAll(fd, message.data(), message.size())) {
+      break;
+    }
+  }
+  close(fd);
+}
+
+}  // namespace distributed
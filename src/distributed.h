@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <cstdint>
+#include <string>
+#include "cpu_renderer.h"
+
+/*
+ * Renders one large image on several worker processes, possibly on other
+ * hosts. The coordinator splits the image into full-width bands of rows,
+ * hands them to the workers over TCP and streams the finished bands, in
+ * order, into a PNG. Workers render their bands with the CPU renderer.
+ *
+ * Scheduling:
+ *   - each worker gets a couple of bands ahead, so it never waits for the
+ *     network between bands;
+ *   - pending bands go out lowest first, so the output can stream early;
+ *   - once nothing is pending, an idle worker steals the oldest band that
+ *     has been running for several times the average band time on another
+ *     worker; the first result wins and the other one is discarded;
+ *   - bands of a worker that disconnects, or that take far longer than the
+ *     average, are handed out again, up to a retry limit.
+ */
+namespace distributed {
+
+struct RenderJob {
+  cpu_renderer::View view;
+  unsigned width = 0, height = 0;
+  unsigned max_iterations = 0;
+  /* Rows per band; every band is a unit of work. */
+  unsigned band_rows = 64;
+  /* CPU kernel for the workers; kAuto lets them choose from the zoom. */
+  cpu_renderer::Precision precision = cpu_renderer::Precision::kAuto;
+  unsigned lanes = 0;
+  cpu_renderer::Fractal fractal;
+};
+
+struct CoordinatorOptions {
+  /* TCP port to listen on; 0 picks a free one. */
+  uint16_t port = 0;
+  /* Worker processes to start on this host, connecting over loopback. */
+  unsigned spawn_workers = 0;
+  /* Program started for those workers: normally this very binary. */
+  std::string worker_executable = "/proc/self/exe";
+  /* Bands sent to a worker before it returns the first one. */
+  unsigned worker_queue_depth = 2;
+  /* Running this many average band times makes a band eligible to steal. */
+  double steal_factor = 2.0;
+  /* Without a result after this many average band times, a band is retried. */
+  double retry_factor = 10.0;
+  /* Hand-outs of a single band before the render fails. */
+  unsigned max_attempts = 5;
+};
+
+/* Runs a render to a PNG file. Throws std::runtime_error on failure. */
+void RunCoordinator(const RenderJob &job, const CoordinatorOptions &options,
+                    const std::string &output);
+
+/*
+ * Connects to the coordinator at "host:port" and renders bands until told to
+ * stop. threads is passed to the CPU renderer (0 for every core).
+ */
+void RunWorker(const std::string &address, unsigned threads);
+
+}  // namespace distributed
+
+#endif
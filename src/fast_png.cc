@@ -0,0 +1,497 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "fast_png.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fast_png {
+
+namespace {
+
+const size_t kMinMatch = 4;
+const size_t kMaxMatch = 258;
+const size_t kMaxDistance = 32768;
+const unsigned kHashBits = 15;
+/* Filtered bytes kept before sliding the window back to kMaxDistance. */
+const size_t kWindowSlack = 1 << 20;
+
+/*
+ * Precomputed fixed-Huffman codes (RFC 1951, 3.2.6), already bit-reversed so
+ * they can be OR-ed straight into the LSB-first bit buffer. For lengths the
+ * extra bits are merged into the code, so a match length costs one lookup.
+ */
+struct Code {
+  uint32_t bits;
+  uint32_t count;
+};
+
+struct Tables {
+  Code literal[256];
+  Code length[kMaxMatch + 1];
+  Code end_of_block;
+  uint8_t distance_code[512];
+  uint32_t crc[8][256];
+
+  Tables() {
+    for (unsigned v = 0; v < 256; ++v) {
+      literal[v] = FixedCode(v);
+    }
+    end_of_block = FixedCode(256);
+
+    static const unsigned kLengthBase[29] = {
+        3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const unsigned kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                              1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                              4, 4, 4, 4, 5, 5, 5, 5, 0};
+    for (unsigned symbol = 0; symbol < 29; ++symbol) {
+      unsigned last = symbol == 28 ? kMaxMatch
+                                   : kLengthBase[symbol] +
+                                         (1u << kLengthExtra[symbol]) - 1;
+      if (symbol == 27) {
+        last = 257;
+      }
+      Code code = FixedCode(257 + symbol);
+      for (unsigned length = kLengthBase[symbol]; length <= last; ++length) {
+        this->length[length] = {
+            code.bits | (length - kLengthBase[symbol]) << code.count,
+            code.count + kLengthExtra[symbol]};
+      }
+    }
+
+    /* Distance codes by (distance - 1), zlib style: direct for values below
+       256, by (distance - 1) >> 7 above. */
+    for (unsigned code = 0, d = 0; code < 16; ++code) {
+      for (unsigned n = 0; n < (1u << DistanceExtra(code)); ++n) {
+        distance_code[d++] = code;
+      }
+    }
+    for (unsigned code = 16, d = 256 + 2; code < 30; ++code) {
+      for (unsigned n = 0; n < (1u << (DistanceExtra(code) - 7)); ++n) {
+        distance_code[d++] = code;
+      }
+    }
+
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      crc[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; ++n) {
+      for (int k = 1; k < 8; ++k) {
+        crc[k][n] = (crc[k - 1][n] >> 8) ^ crc[0][crc[k - 1][n] & 0xff];
+      }
+    }
+  }
+
+  static unsigned DistanceExtra(unsigned code) {
+    return code < 4 ? 0 : code / 2 - 1;
+  }
+
+  static uint32_t Reverse(uint32_t code, unsigned count) {
+    uint32_t result = 0;
+    for (unsigned i = 0; i < count; ++i) {
+      result = (result << 1) | ((code >> i) & 1);
+    }
+    return result;
+  }
+
+  static Code FixedCode(unsigned symbol) {
+    if (symbol < 144) {
+      return {Reverse(0x30 + symbol, 8), 8};
+    } else if (symbol < 256) {
+      return {Reverse(0x190 + symbol - 144, 9), 9};
+    } else if (symbol < 280) {
+      return {Reverse(symbol - 256, 7), 7};
+    }
+    return {Reverse(0xc0 + symbol - 280, 8), 8};
+  }
+};
+
+const Tables &GetTables() {
+  static const Tables tables;
+  return tables;
+}
+
+inline uint32_t Load32(const unsigned char *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+inline size_t MatchLength(const unsigned char *a, const unsigned char *b,
+                          size_t limit) {
+  size_t length = 0;
+  while (length + 8 <= limit) {
+    uint64_t x, y;
+    std::memcpy(&x, a + length, 8);
+    std::memcpy(&y, b + length, 8);
+    if (x != y) {
+#if defined(__GNUC__)
+      return length + (__builtin_ctzll(x ^ y) >> 3);
+#else
+      break;
+#endif
+    }
+    length += 8;
+  }
+  while (length < limit and a[length] == b[length]) {
+    ++length;
+  }
+  return length;
+}
+
+inline unsigned char Paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+  if (pa <= pb and pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+}  // namespace
+
+uint32_t Crc32(uint32_t crc, const unsigned char *data, size_t size) {
+  const auto &t = GetTables().crc;
+  crc = ~crc;
+  while (size >= 8) {
+    uint32_t lo = Load32(data) ^ crc;
+    uint32_t hi = Load32(data + 4);
+    crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^
+          t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+          t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size--) {
+    crc = t[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t Adler32(uint32_t adler, const unsigned char *data, size_t size) {
+  const uint32_t kBase = 65521;
+  /* Largest block for which s2 cannot overflow 32 bits. */
+  const size_t kBlock = 5552;
+  uint32_t s1 = adler & 0xffff, s2 = adler >> 16;
+  while (size > 0) {
+    size_t block = size < kBlock ? size : kBlock;
+    size -= block;
+#if defined(__SSE2__)
+    /* 16 bytes at a time: s2 += 16 * s1 + sum((16 - k) * b[k]),
+       s1 += sum(b[k]). */
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights_hi = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i weights_lo = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+    while (block >= 16) {
+      size_t n = block / 16;
+      block -= n * 16;
+      __m128i v_s1 = _mm_setzero_si128();
+      __m128i v_s2 = _mm_setzero_si128();
+      __m128i v_s1_prefix = _mm_setzero_si128();
+      for (size_t i = 0; i < n; ++i) {
+        __m128i bytes =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        v_s1_prefix = _mm_add_epi32(v_s1_prefix, v_s1);
+        v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes, zero));
+        v_s2 = _mm_add_epi32(
+            v_s2, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weights_hi));
+        v_s2 = _mm_add_epi32(
+            v_s2, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weights_lo));
+        data += 16;
+      }
+      uint32_t lanes[4];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v_s1);
+      uint32_t sum1 = lanes[0] + lanes[2];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v_s1_prefix);
+      uint32_t prefix = lanes[0] + lanes[2];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v_s2);
+      uint32_t sum2 = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+      s2 += uint32_t(n * 16) * s1 + 16 * prefix + sum2;
+      s1 += sum1;
+    }
+#endif
+    while (block--) {
+      s1 += *data++;
+      s2 += s1;
+    }
+    s1 %= kBase;
+    s2 %= kBase;
+  }
+  return s2 << 16 | s1;
+}
+
+Encoder::Encoder(Sink sink, unsigned width, unsigned height,
+                 unsigned channels, const Options &options,
+                 const std::vector<PaletteEntry> &palette)
+    : sink_(std::move(sink)),
+      width_(width),
+      height_(height),
+      channels_(channels),
+      options_(options),
+      row_bytes_(size_t(width) * channels),
+      previous_row_(row_bytes_, 0),
+      hash_(size_t(1) << kHashBits, 0) {
+  if (width == 0 or height == 0) {
+    throw std::invalid_argument("fast_png: empty image.");
+  }
+  if (channels != 1 and channels != 3 and channels != 4) {
+    throw std::invalid_argument("fast_png: unsupported channel count.");
+  }
+  if (channels == 1 and (palette.empty() or palette.size() > 256)) {
+    throw std::invalid_argument("fast_png: palette needs 1 to 256 entries.");
+  }
+
+  static const unsigned char kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  sink_(kSignature, sizeof(kSignature));
+
+  unsigned char ihdr[13] = {
+      uint8_t(width >> 24),  uint8_t(width >> 16),  uint8_t(width >> 8),
+      uint8_t(width),        uint8_t(height >> 24), uint8_t(height >> 16),
+      uint8_t(height >> 8),  uint8_t(height),
+      8,                                                 // bit depth
+      uint8_t(channels == 4 ? 6 : channels == 3 ? 2 : 3),  // color type
+      0, 0, 0};  // deflate, adaptive filtering, no interlace
+  WriteChunk("IHDR", ihdr, sizeof(ihdr));
+
+  if (channels == 1) {
+    std::vector<unsigned char> plte, trns;
+    bool has_alpha = false;
+    for (const auto &entry : palette) {
+      plte.insert(plte.end(), {entry.r, entry.g, entry.b});
+      trns.push_back(entry.a);
+      has_alpha = has_alpha or entry.a != 255;
+    }
+    WriteChunk("PLTE", plte.data(), plte.size());
+    if (has_alpha) {
+      WriteChunk("tRNS", trns.data(), trns.size());
+    }
+  }
+
+  window_.reserve(kWindowSlack + row_bytes_ + 1);
+  idat_.reserve(options_.idat_size + 64);
+  /* zlib header: deflate, 32K window, fastest compression. */
+  idat_.push_back(0x78);
+  idat_.push_back(0x01);
+  /* One fixed-Huffman block for all rows; BFINAL is set on a trailing empty
+     block in Finish, so the row count need not be known up front. */
+  PutBits(0x2, 3);
+}
+
+void Encoder::AddRow(const unsigned char *row) {
+  if (rows_added_ == height_) {
+    throw std::logic_error("fast_png: too many rows.");
+  }
+  ++rows_added_;
+  if (window_.size() > kWindowSlack) {
+    /* Keep the last kMaxDistance bytes, plus anything not yet compressed. */
+    size_t keep_from = std::min(window_.size() - kMaxDistance, pos_);
+    window_.erase(window_.begin(), window_.begin() + keep_from);
+    window_base_ += keep_from;
+    pos_ -= keep_from;
+  }
+  size_t start = window_.size();
+  FilterRow(row);
+  adler_ = Adler32(adler_, window_.data() + start, window_.size() - start);
+  Compress(window_.size());
+  FlushIdat(false);
+}
+
+void Encoder::FilterRow(const unsigned char *row) {
+  const unsigned char *up = previous_row_.data();
+  size_t bpp = channels_;
+  size_t start = window_.size();
+  window_.resize(start + 1 + row_bytes_);
+  unsigned char *out = window_.data() + start;
+  if (options_.filter == Filter::kUp) {
+    *out++ = 2;
+    for (size_t i = 0; i < row_bytes_; ++i) {
+      out[i] = row[i] - up[i];
+    }
+  } else {
+    *out++ = 4;
+    for (size_t i = 0; i < bpp; ++i) {
+      out[i] = row[i] - up[i];
+    }
+    for (size_t i = bpp; i < row_bytes_; ++i) {
+      out[i] = row[i] - Paeth(row[i - bpp], up[i], up[i - bpp]);
+    }
+  }
+  std::memcpy(previous_row_.data(), row, row_bytes_);
+}
+
+void Encoder::Compress(size_t end) {
+  const unsigned char *data = window_.data();
+  size_t rle_distance = channels_;
+  while (pos_ + kMinMatch <= end) {
+    size_t limit = std::min(kMaxMatch, end - pos_);
+    size_t best_length = 0, best_distance = 0;
+
+    /* Run-length probe: repeat of the previous pixel. */
+    if (pos_ >= rle_distance) {
+      best_length = MatchLength(data + pos_ - rle_distance, data + pos_, limit);
+      best_distance = rle_distance;
+    }
+
+    /* Single hash probe. */
+    uint32_t h = Hash(Load32(data + pos_));
+    size_t candidate = hash_[h];
+    size_t absolute = window_base_ + pos_;
+    hash_[h] = absolute + 1;
+    if (best_length < limit and candidate > window_base_ and
+        absolute + 1 - candidate <= kMaxDistance) {
+      size_t offset = candidate - 1 - window_base_;
+      size_t length = MatchLength(data + offset, data + pos_, limit);
+      if (length > best_length) {
+        best_length = length;
+        best_distance = pos_ - offset;
+      }
+    }
+
+    if (best_length >= kMinMatch) {
+      EmitMatch(best_length, best_distance);
+      pos_ += best_length;
+    } else {
+      EmitLiteral(data[pos_]);
+      ++pos_;
+    }
+  }
+}
+
+void Encoder::EmitLiteral(unsigned char value) {
+  const Code &code = GetTables().literal[value];
+  PutBits(code.bits, code.count);
+}
+
+void Encoder::EmitMatch(size_t length, size_t distance) {
+  const auto &tables = GetTables();
+  const Code &code = tables.length[length];
+  PutBits(code.bits, code.count);
+  size_t d = distance - 1;
+  unsigned symbol = tables.distance_code[d < 256 ? d : 256 + (d >> 7)];
+  unsigned extra = Tables::DistanceExtra(symbol);
+  /* The 5-bit fixed distance code is the symbol itself, bit-reversed. */
+  uint32_t base = symbol < 4 ? symbol : (2u + (symbol & 1)) << extra;
+  PutBits(Tables::Reverse(symbol, 5), 5);
+  PutBits(uint32_t(d - base), extra);
+}
+
+void Encoder::PutBits(uint32_t bits, unsigned count) {
+  bit_buffer_ |= uint64_t(bits) << bit_count_;
+  bit_count_ += count;
+  if (bit_count_ >= 32) {
+    uint32_t word = uint32_t(bit_buffer_);
+    idat_.insert(idat_.end(), {uint8_t(word), uint8_t(word >> 8),
+                               uint8_t(word >> 16), uint8_t(word >> 24)});
+    bit_buffer_ >>= 32;
+    bit_count_ -= 32;
+  }
+}
+
+void Encoder::FlushBits() {
+  while (bit_count_ > 0) {
+    idat_.push_back(uint8_t(bit_buffer_));
+    bit_buffer_ >>= 8;
+    bit_count_ = bit_count_ > 8 ? bit_count_ - 8 : 0;
+  }
+  bit_buffer_ = 0;
+}
+
+void Encoder::FlushIdat(bool force) {
+  if (idat_.size() >= options_.idat_size or (force and not idat_.empty())) {
+    WriteChunk("IDAT", idat_.data(), idat_.size());
+    idat_.clear();
+  }
+}
+
+void Encoder::Finish() {
+  if (rows_added_ != height_) {
+    throw std::logic_error("fast_png: missing rows.");
+  }
+  while (pos_ < window_.size()) {
+    EmitLiteral(window_[pos_++]);
+  }
+  const auto &tables = GetTables();
+  PutBits(tables.end_of_block.bits, tables.end_of_block.count);
+  /* Final empty fixed-Huffman block. */
+  PutBits(0x3, 3);
+  PutBits(tables.end_of_block.bits, tables.end_of_block.count);
+  FlushBits();
+  idat_.insert(idat_.end(), {uint8_t(adler_ >> 24), uint8_t(adler_ >> 16),
+                             uint8_t(adler_ >> 8), uint8_t(adler_)});
+  FlushIdat(true);
+  WriteChunk("IEND", nullptr, 0);
+}
+
+void Encoder::WriteChunk(const char *type, const unsigned char *data,
+                         size_t size) {
+  unsigned char header[8] = {uint8_t(size >> 24), uint8_t(size >> 16),
+                             uint8_t(size >> 8),  uint8_t(size),
+                             uint8_t(type[0]),    uint8_t(type[1]),
+                             uint8_t(type[2]),    uint8_t(type[3])};
+  uint32_t crc = Crc32(0, header + 4, 4);
+  if (size > 0) {
+    crc = Crc32(crc, data, size);
+  }
+  unsigned char footer[4] = {uint8_t(crc >> 24), uint8_t(crc >> 16),
+                             uint8_t(crc >> 8), uint8_t(crc)};
+  sink_(header, sizeof(header));
+  if (size > 0) {
+    sink_(data, size);
+  }
+  sink_(footer, sizeof(footer));
+}
+
+std::vector<unsigned char> Encode(const unsigned char *pixels, unsigned width,
+                                  unsigned height, unsigned channels,
+                                  const Options &options,
+                                  const std::vector<PaletteEntry> &palette) {
+  std::vector<unsigned char> out;
+  Encoder encoder(
+      [&out](const unsigned char *data, size_t size) {
+        out.insert(out.end(), data, data + size);
+      },
+      width, height, channels, options, palette);
+  size_t row_bytes = size_t(width) * channels;
+  for (unsigned y = 0; y < height; ++y) {
+    encoder.AddRow(pixels + y * row_bytes);
+  }
+  encoder.Finish();
+  return out;
+}
+
+}  // namespace fast_png
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FAST_PNG_H
+#define FAST_PNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * A fast PNG encoder specialized for 8-bit images (RGBA, RGB or 8-bit
+ * palette), in the spirit of fpng. It trades a little compression for speed:
+ *
+ *   - every scanline uses the same filter (Up or Paeth) instead of trying all
+ *     five per row;
+ *   - the LZ77 matcher does one run-length probe (distance = one pixel) and a
+ *     single hash probe per position, with no chains and no lazy matching;
+ *   - symbols are coded with the fixed deflate Huffman tables, precomputed
+ *     once, so there is no per-image tree construction;
+ *   - Adler-32 is computed with SSE2 when available and CRC-32 uses
+ *     slicing-by-8.
+ *
+ * The output is a standard zlib/PNG stream readable by any decoder.
+ *
+ * The encoder consumes one scanline at a time and hands finished bytes to a
+ * sink as soon as a full IDAT chunk is ready, so callers never need to hold
+ * the whole image or the whole compressed file in memory.
+ */
+namespace fast_png {
+
+enum class Filter {
+  kUp,
+  kPaeth,
+};
+
+struct Options {
+  Filter filter = Filter::kUp;
+  /* Compressed bytes per IDAT chunk. */
+  size_t idat_size = 1 << 18;
+};
+
+struct PaletteEntry {
+  uint8_t r, g, b, a;
+};
+
+class Encoder {
+ public:
+  using Sink = std::function<void(const unsigned char *data, size_t size)>;
+
+  /*
+   * channels is 4 (RGBA), 3 (RGB) or 1 (indexes into palette, which must
+   * then hold between 1 and 256 entries). Throws std::invalid_argument on
+   * unsupported parameters.
+   */
+  Encoder(Sink sink, unsigned width, unsigned height, unsigned channels,
+          const Options &options = Options(),
+          const std::vector<PaletteEntry> &palette = {});
+
+  /* Appends one scanline of width * channels bytes. */
+  void AddRow(const unsigned char *row);
+
+  /* Flushes the remaining data and writes IEND. Must follow the last row. */
+  void Finish();
+
+ private:
+  void FilterRow(const unsigned char *row);
+  void Compress(size_t end);
+  void EmitLiteral(unsigned char value);
+  void EmitMatch(size_t length, size_t distance);
+  void PutBits(uint32_t bits, unsigned count);
+  void FlushBits();
+  void FlushIdat(bool force);
+  void WriteChunk(const char *type, const unsigned char *data, size_t size);
+
+  Sink sink_;
+  unsigned width_, height_, channels_;
+  unsigned rows_added_ = 0;
+  Options options_;
+  size_t row_bytes_;
+
+  std::vector<unsigned char> previous_row_;
+
+  /* Filtered bytes; window_[0] sits at absolute offset window_base_. */
+  std::vector<unsigned char> window_;
+  size_t window_base_ = 0;
+  size_t pos_ = 0;
+  std::vector<size_t> hash_;
+
+  uint64_t bit_buffer_ = 0;
+  unsigned bit_count_ = 0;
+  std::vector<unsigned char> idat_;
+  uint32_t adler_ = 1;
+};
+
+/* Encodes a whole image held in memory. */
+std::vector<unsigned char> Encode(const unsigned char *pixels, unsigned width,
+                                  unsigned height, unsigned channels,
+                                  const Options &options = Options(),
+                                  const std::vector<PaletteEntry> &palette = {});
+
+uint32_t Crc32(uint32_t crc, const unsigned char *data, size_t size);
+uint32_t Adler32(uint32_t adler, const unsigned char *data, size_t size);
+
+}  // namespace fast_png
+
+#endif
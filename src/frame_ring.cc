@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "frame_ring.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+
+namespace frame_ring {
+
+/*
+ * Shared layout: the ring header, slot_count slot headers, then the pixel
+ * storage of each slot, page aligned. Every field is fixed size so processes
+ * built separately agree on it.
+ */
+struct RingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t futex;      // incremented on every publish, consumers wait on it
+  uint64_t slot_size;  // pixel bytes per slot
+  uint64_t published;  // frames published so far; frame ids are 0-based
+  uint64_t data_offset;
+  uint8_t padding[24];
+};
+
+struct SlotHeader {
+  uint64_t sequence;  // odd while the producer writes the slot
+  uint64_t frame_id;
+  uint32_t width, height;
+  uint64_t size;
+  uint8_t padding[32];
+};
+
+static_assert(sizeof(RingHeader) == 64, "RingHeader must stay 64 bytes.");
+static_assert(sizeof(SlotHeader) == 64, "SlotHeader must stay 64 bytes.");
+
+namespace {
+
+const uint32_t kMagic = 0x4d465247;  // "MFRG"
+const uint32_t kVersion = 1;
+const size_t kPageSize = 4096;
+
+size_t RoundUpToPage(size_t size) {
+  return (size + kPageSize - 1) / kPageSize * kPageSize;
+}
+
+SlotHeader *Slots(RingHeader *header) {
+  return reinterpret_cast<SlotHeader *>(header + 1);
+}
+
+const SlotHeader *Slots(const RingHeader *header) {
+  return reinterpret_cast<const SlotHeader *>(header + 1);
+}
+
+unsigned char *SlotPixels(RingHeader *header, uint64_t index) {
+  return reinterpret_cast<unsigned char *>(header) + header->data_offset +
+         index * header->slot_size;
+}
+
+const unsigned char *SlotPixels(const RingHeader *header, uint64_t index) {
+  return reinterpret_cast<const unsigned char *>(header) +
+         header->data_offset + index * header->slot_size;
+}
+
+template <typename T>
+T Load(const T *value) {
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+void Store(T *value, T desired) {
+  __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+}
+
+/* Shared (not FUTEX_PRIVATE) operations, since the word is in shared memory. */
+long FutexWait(const uint32_t *word, uint32_t expected, const timespec *timeout) {
+  return syscall(SYS_futex, word, FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+void FutexWakeAll(uint32_t *word) {
+  syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+}  // namespace
+
+Producer::Producer(const std::string &name, unsigned slot_count,
+                   size_t max_frame_size)
+    : name_(name) {
+  if (slot_count == 0) {
+    throw std::runtime_error("A frame ring needs at least one slot.");
+  }
+  size_t slot_size = RoundUpToPage(max_frame_size);
+  size_t data_offset =
+      RoundUpToPage(sizeof(RingHeader) + slot_count * sizeof(SlotHeader));
+  mapping_size_ = data_offset + slot_count * slot_size;
+
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+  if (fd < 0) {
+    throw std::runtime_error(name + ": could not create shared memory.");
+  }
+  struct stat info;
+  bool reuse = false;
+  if (fstat(fd, &info) == 0 and size_t(info.st_size) == mapping_size_) {
+    void *existing = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+    if (existing != MAP_FAILED) {
+      auto header = static_cast<RingHeader *>(existing);
+      reuse = Load(&header->magic) == kMagic and header->version == kVersion and
+              header->slot_count == slot_count and
+              header->slot_size == slot_size;
+      mapping_ = existing;
+    }
+  }
+  if (not reuse) {
+    /* A ring of another geometry: start over with a fresh object, since
+     * consumers still mapping the old one must not see it resized. */
+    if (mapping_ != nullptr) {
+      munmap(mapping_, mapping_size_);
+      mapping_ = nullptr;
+    }
+    close(fd);
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 or ftruncate(fd, off_t(mapping_size_)) != 0) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      throw std::runtime_error(name + ": could not create shared memory.");
+    }
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    if (mapping_ == MAP_FAILED) {
+      mapping_ = nullptr;
+      close(fd);
+      throw std::runtime_error(name + ": could not map shared memory.");
+    }
+  }
+  close(fd);
+
+  header_ = static_cast<RingHeader *>(mapping_);
+  if (not reuse) {
+    /* ftruncate zero-filled everything; the magic goes last. */
+    header_->version = kVersion;
+    header_->slot_count = slot_count;
+    header_->slot_size = slot_size;
+    header_->data_offset = data_offset;
+    Store(&header_->magic, kMagic);
+  }
+}
+
+Producer::~Producer() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+unsigned char *Producer::BeginFrame(uint32_t width, uint32_t height) {
+  if (uint64_t(width) * height * 4 > header_->slot_size) {
+    throw std::runtime_error(name_ + ": frame larger than the ring slots.");
+  }
+  uint64_t index = header_->published % header_->slot_count;
+  slot_ = &Slots(header_)[index];
+  width_ = width;
+  height_ = height;
+  /*
+   * Odd: consumers treat the slot as being written from now on. A producer
+   * that died before publishing may have left it odd already, in a ring
+   * reused since; forcing the parity keeps the counter in step.
+   */
+  Store(&slot_->sequence, slot_->sequence | 1);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return SlotPixels(header_, index);
+}
+
+uint64_t Producer::Publish() {
+  uint64_t id = header_->published;
+  slot_->frame_id = id;
+  slot_->width = width_;
+  slot_->height = height_;
+  slot_->size = uint64_t(width_) * height_ * 4;
+  Store(&slot_->sequence, (slot_->sequence | 1) + 1);
+  Store(&header_->published, id + 1);
+  __atomic_add_fetch(&header_->futex, 1, __ATOMIC_RELEASE);
+  FutexWakeAll(&header_->futex);
+  slot_ = nullptr;
+  return id;
+}
+
+Consumer::Consumer(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    throw std::runtime_error(name + ": no such frame ring.");
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 or size_t(info.st_size) < sizeof(RingHeader)) {
+    close(fd);
+    throw std::runtime_error(name + ": not a frame ring.");
+  }
+  mapping_size_ = size_t(info.st_size);
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    throw std::runtime_error(name + ": could not map shared memory.");
+  }
+  header_ = static_cast<const RingHeader *>(mapping_);
+  if (Load(&header_->magic) != kMagic or header_->version != kVersion or
+      header_->data_offset + header_->slot_count * header_->slot_size >
+          mapping_size_) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    throw std::runtime_error(name + ": not a frame ring.");
+  }
+}
+
+Consumer::~Consumer() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+bool Consumer::Acquire(Frame *frame, int timeout_ms) {
+  timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  for (;;) {
+    /* Read the futex word first so a publish in between is not missed. */
+    uint32_t futex = Load(&header_->futex);
+    uint64_t published = Load(&header_->published);
+    if (published > next_id_) {
+      uint64_t id = published - 1;
+      const SlotHeader &slot = Slots(header_)[id % header_->slot_count];
+      uint64_t sequence = Load(&slot.sequence);
+      if (sequence % 2 == 0 and slot.frame_id == id) {
+        frame->id = id;
+        frame->width = slot.width;
+        frame->height = slot.height;
+        frame->size = slot.size;
+        frame->pixels = SlotPixels(header_, id % header_->slot_count);
+        frame->sequence = sequence;
+        if (Valid(*frame)) {
+          next_id_ = id + 1;
+          return true;
+        }
+      }
+      /*
+       * Overwritten by a newer frame meanwhile, whose publish has changed
+       * the futex word so the wait below returns at once, or left odd by a
+       * producer that died: then wait for the next publish, within the
+       * deadline, instead of spinning.
+       */
+    }
+
+    const timespec *timeout = nullptr;
+    timespec remaining;
+    if (timeout_ms >= 0) {
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+      remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+      if (remaining.tv_nsec < 0) {
+        remaining.tv_sec -= 1;
+        remaining.tv_nsec += 1000000000L;
+      }
+      if (remaining.tv_sec < 0) {
+        return false;
+      }
+      timeout = &remaining;
+    }
+    if (FutexWait(&header_->futex, futex, timeout) != 0 and
+        errno == ETIMEDOUT) {
+      return false;
+    }
+  }
+}
+
+bool Consumer::Valid(const Frame &frame) const {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  const SlotHeader &slot = Slots(header_)[frame.id % header_->slot_count];
+  return Load(&slot.sequence) == frame.sequence;
+}
+
+uint64_t Consumer::published() const { return Load(&header_->published); }
+
+void Unlink(const std::string &name) { shm_unlink(name.c_str()); }
+
+}  // namespace frame_ring
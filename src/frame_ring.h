@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * A ring of RGBA8 frames in POSIX shared memory, for handing rendered images
+ * to other processes without encoding, files or copies.
+ *
+ * One producer writes frames straight into a slot of the ring and publishes
+ * them; any number of consumers map the same object read-only and look at the
+ * newest frame in place. Publishing bumps a futex word in the shared header,
+ * which consumers sleep on. Each slot is guarded by a sequence counter (a
+ * seqlock): it is odd while the producer writes the slot, so a consumer can
+ * tell whether a frame was overwritten while it was reading it. The producer
+ * never waits for consumers; a consumer that falls behind skips frames.
+ *
+ * The object is named like a shm_open name, e.g. "/mandelbrot", and lives in
+ * /dev/shm until Unlink is called.
+ */
+namespace frame_ring {
+
+struct RingHeader;
+struct SlotHeader;
+
+/* A frame as seen by a consumer. pixels points into the shared mapping. */
+struct Frame {
+  uint64_t id = 0;
+  uint32_t width = 0, height = 0;
+  const unsigned char *pixels = nullptr;
+  size_t size = 0;
+  uint64_t sequence = 0;
+};
+
+class Producer {
+ public:
+  /*
+   * Creates the ring, or reuses an existing one with the same geometry so
+   * attached consumers keep working. Throws std::runtime_error on failure.
+   */
+  Producer(const std::string &name, unsigned slot_count, size_t max_frame_size);
+  ~Producer();
+
+  Producer(const Producer &) = delete;
+  Producer &operator=(const Producer &) = delete;
+
+  /*
+   * Claims the next slot and returns width * height * 4 bytes to write the
+   * frame into. Must be followed by Publish.
+   */
+  unsigned char *BeginFrame(uint32_t width, uint32_t height);
+
+  /* Makes the frame started by BeginFrame visible and wakes consumers. */
+  uint64_t Publish();
+
+ private:
+  std::string name_;
+  void *mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  RingHeader *header_ = nullptr;
+  SlotHeader *slot_ = nullptr;
+  uint32_t width_ = 0, height_ = 0;
+};
+
+class Consumer {
+ public:
+  /* Attaches to an existing ring. Throws std::runtime_error on failure. */
+  explicit Consumer(const std::string &name);
+  ~Consumer();
+
+  Consumer(const Consumer &) = delete;
+  Consumer &operator=(const Consumer &) = delete;
+
+  /*
+   * Waits up to timeout_ms (negative waits forever) for a frame newer than
+   * the last one returned and points frame at the newest one. Returns false
+   * on timeout.
+   */
+  bool Acquire(Frame *frame, int timeout_ms = -1);
+
+  /*
+   * Whether frame is still intact. Call after reading its pixels: false
+   * means the producer overwrote the slot meanwhile and the data is torn.
+   */
+  bool Valid(const Frame &frame) const;
+
+  /* Frames published since the ring was created. */
+  uint64_t published() const;
+
+ private:
+  void *mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  const RingHeader *header_ = nullptr;
+  uint64_t next_id_ = 0;
+};
+
+/* Removes the shared memory object; mappings stay valid until unmapped. */
+void Unlink(const std::string &name);
+
+}  // namespace frame_ring
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Reference consumer of the shared-memory frame ring, and a harness for it.
+ *
+ *   frame_ring_consumer [--ring=/mandelbrot] [--frames=N] [--timeout=MS]
+ *                       [--dump=frame.pam] [--unlink]
+ *     attaches to the ring published by `mandelbrot --shm=...` and reports
+ *     every frame it receives, optionally saving the last one.
+ *
+ *   frame_ring_consumer --self-test
+ *     forks a producer that publishes synthetic frames as fast as it can and
+ *     checks every frame the consumer sees, counting skipped and torn frames;
+ *     then kills a producer mid-frame and checks that a new one reusing the
+ *     ring still reaches consumers.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "frame_ring.h"
+
+namespace {
+
+struct Options {
+  std::string ring = "/mandelbrot";
+  unsigned frames = 1;
+  int timeout_ms = 5000;
+  std::string dump;
+  bool unlink = false;
+  bool self_test = false;
+};
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&arg](const char *prefix) {
+      size_t length = std::strlen(prefix);
+      return arg.compare(0, length, prefix) == 0 ? arg.substr(length)
+                                                 : std::string();
+    };
+    if (not value("--ring=").empty()) {
+      options.ring = value("--ring=");
+    } else if (not value("--frames=").empty()) {
+      options.frames = std::stoul(value("--frames="));
+    } else if (not value("--timeout=").empty()) {
+      options.timeout_ms = std::stoi(value("--timeout="));
+    } else if (not value("--dump=").empty()) {
+      options.dump = value("--dump=");
+    } else if (arg == "--unlink") {
+      options.unlink = true;
+    } else if (arg == "--self-test") {
+      options.self_test = true;
+    } else {
+      throw std::runtime_error(arg + ": unknown option.");
+    }
+  }
+  return options;
+}
+
+void DumpPam(const frame_ring::Frame &frame, const std::string &filename) {
+  FILE *file = std::fopen(filename.c_str(), "wb");
+  if (file == nullptr) {
+    throw std::runtime_error(filename + ": could not open for writing.");
+  }
+  std::fprintf(file,
+               "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\n"
+               "TUPLTYPE RGB_ALPHA\nENDHDR\n",
+               frame.width, frame.height);
+  bool ok = std::fwrite(frame.pixels, 1, frame.size, file) == frame.size;
+  if (std::fclose(file) != 0 or not ok) {
+    throw std::runtime_error(filename + ": write error.");
+  }
+}
+
+int Consume(const Options &options) {
+  frame_ring::Consumer consumer(options.ring);
+  frame_ring::Frame frame;
+  for (unsigned n = 0; n < options.frames; ++n) {
+    if (not consumer.Acquire(&frame, options.timeout_ms)) {
+      std::cerr << "timed out waiting for a frame" << std::endl;
+      return 1;
+    }
+    if (not options.dump.empty()) {
+      DumpPam(frame, options.dump);
+    }
+    bool valid = consumer.Valid(frame);
+    std::cout << "frame " << frame.id << ": " << frame.width << "x"
+              << frame.height << (valid ? "" : " (overwritten while reading)")
+              << std::endl;
+  }
+  if (options.unlink) {
+    frame_ring::Unlink(options.ring);
+  }
+  return 0;
+}
+
+/* Byte i of frame id holds (id + i) mod 251, so torn frames show up. */
+unsigned char Pattern(uint64_t id, size_t i) {
+  return static_cast<unsigned char>((id + i) % 251);
+}
+
+/*
+ * A producer that dies between BeginFrame and Publish leaves its slot odd.
+ * A producer reusing the ring must still publish frames consumers can read,
+ * and a consumer must honor its timeout rather than spin on the slot.
+ */
+bool CrashAndReuseTest() {
+  const std::string name =
+      "/frame_ring_crash_test_" + std::to_string(getpid());
+  const unsigned kWidth = 64, kHeight = 64, kSlots = 3;
+  const size_t kFrameSize = size_t(kWidth) * kHeight * 4;
+
+  frame_ring::Unlink(name);
+  pid_t child = fork();
+  if (child < 0) {
+    throw std::runtime_error("fork failed.");
+  }
+  if (child == 0) {
+    frame_ring::Producer producer(name, kSlots, kFrameSize);
+    producer.BeginFrame(kWidth, kHeight);
+    producer.Publish();
+    producer.BeginFrame(kWidth, kHeight);
+    _exit(0);  // dies mid-frame, never publishing
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+
+  frame_ring::Producer producer(name, kSlots, kFrameSize);
+  frame_ring::Consumer consumer(name);
+  frame_ring::Frame frame;
+  bool passed = WIFEXITED(status) and WEXITSTATUS(status) == 0 and
+                consumer.Acquire(&frame, 1000) and frame.id == 0;
+  /* Twice around the ring, through the slot the dead producer left odd. */
+  for (uint64_t id = 1; passed and id <= 2 * kSlots; ++id) {
+    unsigned char *pixels = producer.BeginFrame(kWidth, kHeight);
+    for (size_t i = 0; i < kFrameSize; ++i) {
+      pixels[i] = Pattern(id, i);
+    }
+    producer.Publish();
+    passed = consumer.Acquire(&frame, 1000) and frame.id == id and
+             frame.pixels[kFrameSize - 1] == Pattern(id, kFrameSize - 1) and
+             consumer.Valid(frame);
+  }
+  auto start = std::chrono::steady_clock::now();
+  bool timed_out = not consumer.Acquire(&frame, 100);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  passed = passed and timed_out and seconds < 1.0;
+  frame_ring::Unlink(name);
+
+  std::cout << "producer killed mid-frame, ring reused: "
+            << (passed ? "frames delivered, timeout honored"
+                       : "consumer stuck or frames lost")
+            << std::endl;
+  return passed;
+}
+
+int SelfTest() {
+  const std::string name = "/frame_ring_self_test_" + std::to_string(getpid());
+  const unsigned kWidth = 640, kHeight = 480, kFrames = 2000;
+
+  /* Created before forking so the consumer can attach right away. */
+  frame_ring::Unlink(name);
+  frame_ring::Producer producer(name, 3, kWidth * kHeight * 4);
+  pid_t child = fork();
+  if (child < 0) {
+    throw std::runtime_error("fork failed.");
+  }
+  if (child == 0) {
+    for (uint64_t id = 0; id < kFrames; ++id) {
+      unsigned char *pixels = producer.BeginFrame(kWidth, kHeight);
+      for (size_t i = 0; i < size_t(kWidth) * kHeight * 4; ++i) {
+        pixels[i] = Pattern(id, i);
+      }
+      producer.Publish();
+    }
+    _exit(0);
+  }
+
+  frame_ring::Consumer consumer(name);
+  frame_ring::Frame frame;
+  unsigned seen = 0, torn = 0, bad = 0;
+  uint64_t last = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (consumer.Acquire(&frame, 5000)) {
+    ++seen;
+    bool match = frame.width == kWidth and frame.height == kHeight;
+    for (size_t i = 0; match and i < frame.size; i += 4093) {
+      match = frame.pixels[i] == Pattern(frame.id, i);
+    }
+    if (not consumer.Valid(frame)) {
+      ++torn;  // expected now and then: the producer never waits
+    } else if (not match) {
+      ++bad;
+    }
+    last = frame.id;
+    if (last == kFrames - 1) {
+      break;
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  int status = 0;
+  waitpid(child, &status, 0);
+  frame_ring::Unlink(name);
+
+  std::cout << "published " << consumer.published() << " frames in "
+            << seconds << " s, consumer saw " << seen << " (last " << last
+            << "), " << torn << " overwritten while reading, " << bad
+            << " corrupt" << std::endl;
+  bool passed = last == kFrames - 1 and bad == 0 and WIFEXITED(status) and
+                WEXITSTATUS(status) == 0;
+  passed = CrashAndReuseTest() and passed;
+  std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+  return passed ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  try {
+    Options options = ParseOptions(argc, argv);
+    return options.self_test ? SelfTest() : Consume(options);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
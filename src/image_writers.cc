@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "image_writers.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "async_writer.h"
+#include "fast_png.h"
+#include "lodepng.h"
+
+using namespace std::string_literals;
+
+namespace image_writers {
+
+namespace {
+
+const size_t kChunkSize = 1 << 16;
+
+/* Files at least this large are written with O_DIRECT, past the page cache. */
+const uint64_t kDirectWriteSize = uint64_t(64) << 20;
+
+/*
+ * Accumulates bytes into a fixed-size chunk. Full chunks go to stdout, or to
+ * an async_writer::FileWriter for regular files, so disk writes overlap the
+ * encoding. expected_size, when known, is used to preallocate the file.
+ */
+class ChunkedWriter {
+ public:
+  explicit ChunkedWriter(const std::string &filename,
+                         uint64_t expected_size = 0)
+      : filename_(filename) {
+    if (filename == "-") {
+      file_ = stdout;
+    } else {
+      async_writer::Options options;
+      options.expected_size = expected_size;
+      options.direct = expected_size >= kDirectWriteSize;
+      async_.reset(new async_writer::FileWriter(filename, options));
+    }
+  }
+
+  void Put(unsigned char byte) {
+    if (used_ == kChunkSize) {
+      Flush();
+    }
+    chunk_[used_++] = byte;
+  }
+
+  void Put(const void *data, size_t size) {
+    auto bytes = static_cast<const unsigned char *>(data);
+    while (size > 0) {
+      if (used_ == kChunkSize) {
+        Flush();
+      }
+      size_t n = std::min(size, kChunkSize - used_);
+      std::memcpy(chunk_ + used_, bytes, n);
+      used_ += n;
+      bytes += n;
+      size -= n;
+    }
+  }
+
+  void PutBigEndian32(uint32_t value) {
+    Put(value >> 24);
+    Put(value >> 16);
+    Put(value >> 8);
+    Put(value);
+  }
+
+  void Flush() {
+    if (async_) {
+      async_->Write(chunk_, used_);
+    } else if (used_ > 0 and std::fwrite(chunk_, 1, used_, file_) != used_) {
+      throw std::runtime_error(filename_ + ": write error.");
+    }
+    used_ = 0;
+  }
+
+  void Close() {
+    Flush();
+    if (async_) {
+      async_->Close();
+    } else if (std::fflush(file_) != 0) {
+      throw std::runtime_error(filename_ + ": write error.");
+    }
+  }
+
+ private:
+  std::string filename_;
+  FILE *file_ = nullptr;
+  std::unique_ptr<async_writer::FileWriter> async_;
+  unsigned char chunk_[kChunkSize];
+  size_t used_ = 0;
+};
+
+/*
+ * Scratch state reused by every PNG written from this thread: the lodepng
+ * arena serves all encoder allocations, and the output vector keeps its
+ * capacity, so repeated frames of the same size do not go back to the heap.
+ */
+struct PngScratch {
+  lodepng::Arena arena;
+  lodepng::State state;
+  std::vector<unsigned char> png;
+
+  PngScratch() { state.encoder.arena = &arena; }
+};
+
+void WritePng(const unsigned char *rgba, unsigned width, unsigned height,
+              const std::string &filename) {
+  static thread_local PngScratch scratch;
+  auto &png = scratch.png;
+  png.clear();
+  unsigned error = lodepng::encode(png, rgba, width, height, scratch.state);
+  if (error) {
+    throw std::runtime_error("Encoding error: "s + lodepng_error_text(error));
+  }
+  ChunkedWriter writer(filename, png.size());
+  writer.Put(png.data(), png.size());
+  writer.Close();
+}
+
+void WriteFastPng(const unsigned char *rgba, unsigned width,
+                  unsigned height, const std::string &filename) {
+  ChunkedWriter writer(filename);
+  fast_png::Encoder encoder(
+      [&writer](const unsigned char *data, size_t size) {
+        writer.Put(data, size);
+      },
+      width, height, 4);
+  for (unsigned y = 0; y < height; ++y) {
+    encoder.AddRow(rgba + size_t(y) * width * 4);
+  }
+  encoder.Finish();
+  writer.Close();
+}
+
+/* See https://qoiformat.org/qoi-specification.pdf */
+void WriteQoi(const unsigned char *rgba, unsigned width, unsigned height,
+              const std::string &filename) {
+  const unsigned char kOpIndex = 0x00, kOpDiff = 0x40, kOpLuma = 0x80,
+                      kOpRun = 0xc0, kOpRgb = 0xfe, kOpRgba = 0xff;
+  struct Rgba {
+    unsigned char r, g, b, a;
+    bool operator==(const Rgba &o) const {
+      return r == o.r and g == o.g and b == o.b and a == o.a;
+    }
+  };
+
+  ChunkedWriter writer(filename);
+  writer.Put("qoif", 4);
+  writer.PutBigEndian32(width);
+  writer.PutBigEndian32(height);
+  writer.Put(4);  // channels
+  writer.Put(0);  // sRGB with linear alpha
+
+  Rgba index[64] = {};
+  Rgba prev = {0, 0, 0, 255};
+  unsigned run = 0;
+  size_t pixel_count = size_t(width) * height;
+  for (size_t i = 0; i < pixel_count; ++i) {
+    const unsigned char *p = rgba + 4 * i;
+    Rgba px = {p[0], p[1], p[2], p[3]};
+    if (px == prev) {
+      ++run;
+      if (run == 62 or i + 1 == pixel_count) {
+        writer.Put(kOpRun | (run - 1));
+        run = 0;
+      }
+      continue;
+    }
+    if (run > 0) {
+      writer.Put(kOpRun | (run - 1));
+      run = 0;
+    }
+    unsigned hash = (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+    if (index[hash] == px) {
+      writer.Put(kOpIndex | hash);
+    } else {
+      index[hash] = px;
+      if (px.a == prev.a) {
+        signed char vr = px.r - prev.r;
+        signed char vg = px.g - prev.g;
+        signed char vb = px.b - prev.b;
+        signed char vg_r = vr - vg;
+        signed char vg_b = vb - vg;
+        if (vr > -3 and vr < 2 and vg > -3 and vg < 2 and vb > -3 and
+            vb < 2) {
+          writer.Put(kOpDiff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+        } else if (vg_r > -9 and vg_r < 8 and vg > -33 and vg < 32 and
+                   vg_b > -9 and vg_b < 8) {
+          writer.Put(kOpLuma | (vg + 32));
+          writer.Put((vg_r + 8) << 4 | (vg_b + 8));
+        } else {
+          writer.Put(kOpRgb);
+          writer.Put(&px, 3);
+        }
+      } else {
+        writer.Put(kOpRgba);
+        writer.Put(&px, 4);
+      }
+    }
+    prev = px;
+  }
+  static const unsigned char kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+  writer.Put(kEndMarker, sizeof(kEndMarker));
+  writer.Close();
+}
+
+void WritePnm(const unsigned char *rgba, unsigned width, unsigned height,
+              bool with_alpha, const std::string &filename) {
+  unsigned channels = with_alpha ? 4 : 3;
+  ChunkedWriter writer(filename, uint64_t(width) * height * channels);
+  std::string header;
+  if (with_alpha) {
+    header = "P7\nWIDTH "s + std::to_string(width) + "\nHEIGHT " +
+             std::to_string(height) +
+             "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+  } else {
+    header = "P6\n"s + std::to_string(width) + " " + std::to_string(height) +
+             "\n255\n";
+  }
+  writer.Put(header.data(), header.size());
+  if (with_alpha) {
+    writer.Put(rgba, size_t(width) * height * 4);
+  } else {
+    for (size_t i = 0; i < size_t(width) * height; ++i) {
+      writer.Put(rgba + 4 * i, 3);
+    }
+  }
+  writer.Close();
+}
+
+void WriteRaw(const unsigned char *rgba, unsigned width, unsigned height,
+              const std::string &filename) {
+  ChunkedWriter writer(filename, uint64_t(width) * height * 4);
+  writer.Put(rgba, size_t(width) * height * 4);
+  writer.Close();
+}
+
+}  // namespace
+
+struct PngStream::Impl {
+  ChunkedWriter writer;
+  fast_png::Encoder encoder;
+  unsigned width;
+
+  Impl(const std::string &filename, unsigned width, unsigned height)
+      : writer(filename),
+        encoder(
+            [this](const unsigned char *data, size_t size) {
+              writer.Put(data, size);
+            },
+            width, height, 4),
+        width(width) {}
+};
+
+PngStream::PngStream(const std::string &filename, unsigned width,
+                     unsigned height)
+    : impl_(new Impl(filename, width, height)) {}
+
+PngStream::~PngStream() = default;
+
+void PngStream::AddRows(const unsigned char *rgba, unsigned row_count) {
+  for (unsigned y = 0; y < row_count; ++y) {
+    impl_->encoder.AddRow(rgba + size_t(y) * impl_->width * 4);
+  }
+}
+
+void PngStream::Finish() {
+  impl_->encoder.Finish();
+  impl_->writer.Close();
+}
+
+bool ParseFormat(const std::string &name, Format *format) {
+  if (name == "png") {
+    *format = Format::kPng;
+  } else if (name == "fastpng") {
+    *format = Format::kFastPng;
+  } else if (name == "qoi") {
+    *format = Format::kQoi;
+  } else if (name == "ppm") {
+    *format = Format::kPpm;
+  } else if (name == "pam") {
+    *format = Format::kPam;
+  } else if (name == "raw" or name == "rgba") {
+    *format = Format::kRaw;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+Format FormatFromFilename(const std::string &filename) {
+  Format format = Format::kPng;
+  auto dot = filename.rfind('.');
+  if (dot != std::string::npos) {
+    ParseFormat(filename.substr(dot + 1), &format);
+  }
+  return format;
+}
+
+const char *FormatExtension(Format format) {
+  switch (format) {
+    case Format::kPng:
+    case Format::kFastPng:
+      return ".png";
+    case Format::kQoi:
+      return ".qoi";
+    case Format::kPpm:
+      return ".ppm";
+    case Format::kPam:
+      return ".pam";
+    case Format::kRaw:
+      return ".rgba";
+  }
+  return "";
+}
+
+void WriteImage(Format format, const unsigned char *rgba, unsigned width,
+                unsigned height, const std::string &filename) {
+  switch (format) {
+    case Format::kPng:
+      WritePng(rgba, width, height, filename);
+      break;
+    case Format::kFastPng:
+      WriteFastPng(rgba, width, height, filename);
+      break;
+    case Format::kQoi:
+      WriteQoi(rgba, width, height, filename);
+      break;
+    case Format::kPpm:
+      WritePnm(rgba, width, height, false, filename);
+      break;
+    case Format::kPam:
+      WritePnm(rgba, width, height, true, filename);
+      break;
+    case Format::kRaw:
+      WriteRaw(rgba, width, height, filename);
+      break;
+  }
+}
+
+}  // namespace image_writers
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef IMAGE_WRITERS_H
+#define IMAGE_WRITERS_H
+
+#include <memory>
+#include <string>
+
+/*
+ * Writers for the rendered image. The input is always the RGBA8 layout
+ * produced by the compute shaders (4 bytes per pixel), so the writers can be
+ * handed the mapped device memory directly.
+ *
+ * PNG goes through lodepng, which encodes the whole frame in memory. Every
+ * other format streams pixels into a small fixed-size chunk that is flushed
+ * to the output, so no full-frame intermediate buffer is built.
+ */
+namespace image_writers {
+
+enum class Format {
+  kPng,      /* Deflate-compressed PNG (lodepng). */
+  kFastPng,  /* PNG from the specialized fast_png encoder, one row at a time. */
+  kQoi,      /* "Quite OK Image" lossless format, much cheaper than deflate. */
+  kPpm,      /* Binary PPM (P6), RGB only. */
+  kPam,      /* Binary PAM (P7), RGB_ALPHA. */
+  kRaw,      /* Headerless RGBA8, typically written to stdout. */
+};
+
+/* Parses a format name ("png", "fastpng", "qoi", "ppm", "pam" or "raw"). */
+bool ParseFormat(const std::string &name, Format *format);
+
+/* Returns the format matching the extension of filename, PNG if unknown. */
+Format FormatFromFilename(const std::string &filename);
+
+/* Returns the canonical file extension for format, including the dot. */
+const char *FormatExtension(Format format);
+
+/*
+ * Writes width * height RGBA8 pixels to filename in the given format.
+ * A filename of "-" writes to stdout. Throws std::runtime_error on failure.
+ */
+void WriteImage(Format format, const unsigned char *rgba, unsigned width,
+                unsigned height, const std::string &filename);
+
+/*
+ * Writes an RGBA8 image as PNG (fast_png) while it is still being produced:
+ * rows are added top to bottom in bands of any size and compressed to the
+ * output right away, so the whole image is never held in memory.
+ */
+class PngStream {
+ public:
+  PngStream(const std::string &filename, unsigned width, unsigned height);
+  ~PngStream();
+
+  /* Appends row_count rows of width * 4 bytes. */
+  void AddRows(const unsigned char *rgba, unsigned row_count);
+
+  /* Must follow the last row. Throws std::runtime_error on failure. */
+  void Finish();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace image_writers
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "kernels.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include "colorize.spv.h"
+#include "fixed128.spv.h"
+#include "histogram.spv.h"
+#include "prefix_sum.spv.h"
+#include "shader.spv.h"
+#include "tiles.spv.h"
+
+namespace kernels {
+
+namespace {
+
+Features MakeFeatures(Layout layout, Precision precision = Precision::kFloat,
+                      Pass pass = Pass::kRender) {
+  Features features;
+  features.layout = layout;
+  features.precision = precision;
+  features.pass = pass;
+  return features;
+}
+
+/* Every variant built from shaders/; keep in step with the .comp files. */
+const Kernel kKernels[] = {
+    {"shader", kShaderSpirv, sizeof(kShaderSpirv), 32,
+     MakeFeatures(Layout::kImage)},
+    {"tiles", kTilesSpirv, sizeof(kTilesSpirv), 16,
+     MakeFeatures(Layout::kTiles)},
+    {"fixed128", kFixed128Spirv, sizeof(kFixed128Spirv), 16,
+     MakeFeatures(Layout::kImage, Precision::kFixed128)},
+    {"histogram", kHistogramSpirv, sizeof(kHistogramSpirv), 256,
+     MakeFeatures(Layout::kImage, Precision::kFloat, Pass::kHistogram)},
+    {"prefix_sum", kPrefixSumSpirv, sizeof(kPrefixSumSpirv), 256,
+     MakeFeatures(Layout::kImage, Precision::kFloat, Pass::kPrefixSum)},
+    {"colorize", kColorizeSpirv, sizeof(kColorizeSpirv), 256,
+     MakeFeatures(Layout::kImage, Precision::kFloat, Pass::kColorize)},
+};
+
+bool operator==(const Features &a, const Features &b) {
+  return a.layout == b.layout and a.precision == b.precision and
+         a.pass == b.pass;
+}
+
+}  // namespace
+
+bool operator<(const Specialization &a, const Specialization &b) {
+  return std::make_tuple(a.max_iterations, a.coloring, a.interior_check,
+                         a.periodicity, a.family, a.exponent, a.julia_x,
+                         a.julia_y, a.histogram, a.supersampling) <
+         std::make_tuple(b.max_iterations, b.coloring, b.interior_check,
+                         b.periodicity, b.family, b.exponent, b.julia_x,
+                         b.julia_y, b.histogram, b.supersampling);
+}
+
+void PackSpecialization(const Specialization &specialization,
+                        uint32_t values[kSpecializationConstants]) {
+  values[0] = specialization.max_iterations;
+  values[1] = static_cast<uint32_t>(specialization.coloring);
+  values[2] = specialization.interior_check ? 1 : 0;
+  values[3] = specialization.periodicity ? 1 : 0;
+  values[4] = static_cast<uint32_t>(specialization.family);
+  values[5] = specialization.exponent;
+  std::memcpy(&values[6], &specialization.julia_x, sizeof(float));
+  std::memcpy(&values[7], &specialization.julia_y, sizeof(float));
+  values[8] = specialization.histogram ? 1 : 0;
+  values[9] = specialization.supersampling;
+}
+
+std::vector<const Kernel *> All() {
+  std::vector<const Kernel *> all;
+  for (const auto &kernel : kKernels) {
+    all.push_back(&kernel);
+  }
+  return all;
+}
+
+const Kernel &Find(const Features &features) {
+  for (const auto &kernel : kKernels) {
+    if (kernel.features == features) {
+      return kernel;
+    }
+  }
+  throw std::runtime_error(
+      "No compute kernel was built for the requested features.");
+}
+
+}  // namespace kernels
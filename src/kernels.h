@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The compute kernels, compiled from the shaders in shaders/ at build time and
+ * embedded in the binary (see cmake/embed_spirv.cmake). A kernel is picked
+ * by the features it implements, so the renderer never touches the file
+ * system for SPIR-V and cannot run with a stale shader.
+ *
+ * Options that would otherwise be branches in the inner loop are
+ * specialization constants instead: each job's pipeline is built from the
+ * same SPIR-V with its Specialization, and the driver compiles the unused
+ * paths away.
+ */
+namespace kernels {
+
+/* How the kernel finds its pixels: one fixed image or a batch of tiles. */
+enum class Layout { kImage, kTiles };
+
+/*
+ * Arithmetic used by the escape-time loop: float, or 128-bit fixed point
+ * emulated with 64-bit integers for zooms too deep for float. The latter
+ * needs the shaderInt64 device feature.
+ */
+enum class Precision { kFloat, kFixed128 };
+
+/*
+ * What a kernel computes: the pixels of the image or tiles, or one of the
+ * passes that turn an image's iteration counts into histogram-equalized
+ * colors (see shaders/histogram.glsl).
+ */
+enum class Pass { kRender, kHistogram, kPrefixSum, kColorize };
+
+/* Bins of the histogram passes; mirrors BINS in shaders/histogram.glsl. */
+const uint32_t kHistogramBins = 4096;
+
+enum class Coloring : uint32_t { kCosinePalette = 0, kGrayscale = 1 };
+
+/* The iterated formula; values match FAMILY in shaders/escape_time.glsl. */
+enum class Family : uint32_t {
+  kMandelbrot = 0,   // z^2 + c
+  kMultibrot = 1,    // z^exponent + c
+  kJulia = 2,        // z^2 + julia, starting from z = c
+  kBurningShip = 3,  // (|Re z| + i |Im z|)^2 + c
+};
+
+/* Exponents the Multibrot kernels are built for. */
+const uint32_t kMinExponent = 3, kMaxExponent = 6;
+
+/* What a kernel's SPIR-V implements; one registry entry per combination. */
+struct Features {
+  Layout layout = Layout::kImage;
+  Precision precision = Precision::kFloat;
+  Pass pass = Pass::kRender;
+};
+
+/*
+ * The specialization constants shared by every kernel, in constant_id
+ * order. Kernels that take their iteration cap from elsewhere (the tiles)
+ * ignore max_iterations.
+ */
+struct Specialization {
+  uint32_t max_iterations = 128;
+  Coloring coloring = Coloring::kCosinePalette;
+  /* Skip the loop for points in the main cardioid and the period-2 bulb. */
+  bool interior_check = false;
+  /* Stop iterating once the orbit is found to be periodic. */
+  bool periodicity = false;
+  Family family = Family::kMandelbrot;
+  /* Multibrot only, in [kMinExponent, kMaxExponent]. */
+  uint32_t exponent = kMinExponent;
+  /* Julia only: the constant added at every step. */
+  float julia_x = 0.0f, julia_y = 0.0f;
+  /*
+   * Image kernels write iteration counts for the histogram passes, which
+   * color them by rank instead of by count / max_iterations.
+   */
+  bool histogram = false;
+  /*
+   * Image kernels evaluate supersampling^2 samples per pixel on a rotated
+   * grid and store their average, so only final pixels are read back.
+   */
+  uint32_t supersampling = 1;
+};
+
+/* Orders specializations, to key pipeline caches. */
+bool operator<(const Specialization &a, const Specialization &b);
+
+const uint32_t kSpecializationConstants = 10;
+
+/*
+ * Lays out specialization as the data of a VkSpecializationInfo: constant
+ * i is the 32-bit word values[i] (booleans as VkBool32, floats as their
+ * bits).
+ */
+void PackSpecialization(const Specialization &specialization,
+                        uint32_t values[kSpecializationConstants]);
+
+struct Kernel {
+  /* The shader source, without its directory and extension. */
+  const char *name;
+  const uint32_t *code;
+  /* Size of code in bytes, as vk::ShaderModuleCreateInfo takes it. */
+  size_t code_size;
+  /*
+   * The kernel's local_size_x, and local_size_y for the render kernels;
+   * the histogram passes are one-dimensional.
+   */
+  uint32_t workgroup_size;
+  Features features;
+};
+
+/* Every embedded kernel. */
+std::vector<const Kernel *> All();
+
+/*
+ * Returns the kernel implementing exactly features. Throws
+ * std::runtime_error when no variant was built for them.
+ */
+const Kernel &Find(const Features &features);
+
+}  // namespace kernels
+
+#endif
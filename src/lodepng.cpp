@@ -34,6 +34,13 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef LODEPNG_COMPILE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif /*LODEPNG_COMPILE_THREADS*/
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1310) /*Visual Studio: A few warning types are not desired here.*/
 #pragma warning( disable : 4244 ) /*implicit conversions: not warned by gcc -Wall -Wextra and requires too much casts*/
 #pragma warning( disable : 4996 ) /*VS does not like fopen, but fopen_s is not standard C so unusable here*/
@@ -60,11 +67,180 @@ lodepng source code. Don't forget to remove "static" if you copypaste them
 from here.*/
 
 #ifdef LODEPNG_COMPILE_ALLOCATORS
+#ifdef LODEPNG_COMPILE_ENCODER
+/*
+Scratch arena used by lodepng_encode when the caller provides one in the encoder
+settings. Memory is handed out by bumping a pointer through large blocks. Each
+allocation is preceded by a header holding its size, so realloc can copy. The
+most recent allocation can grow or be freed in place. Any other free is a no-op:
+all memory is reclaimed at once by lodepng_arena_reset at the start of the next
+encode. When a frame needed more than one block, reset merges them into a single
+block sized for the high-water mark. From then on frames of the same size do not
+touch the heap at all.
+*/
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define LODEPNG_THREAD_LOCAL thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define LODEPNG_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define LODEPNG_THREAD_LOCAL __thread
+#else
+#define LODEPNG_THREAD_LOCAL
+#endif
+
+#define LODEPNG_ARENA_ALIGN 16
+#define LODEPNG_ARENA_MIN_BLOCK 65536
+
+struct LodePNGArenaBlock
+{
+  LodePNGArenaBlock* next;
+  size_t size; /*usable bytes after the block header*/
+  size_t used;
+  size_t last; /*offset of the header of the most recent allocation*/
+};
+
+/*the arena that lodepng_malloc and friends serve from, if any*/
+static LODEPNG_THREAD_LOCAL LodePNGArena* lodepng_current_arena = 0;
+
+static size_t lodepng_arena_round(size_t size)
+{
+  return (size + (LODEPNG_ARENA_ALIGN - 1)) & ~(size_t)(LODEPNG_ARENA_ALIGN - 1);
+}
+
+static unsigned char* lodepng_arena_block_data(LodePNGArenaBlock* block)
+{
+  return (unsigned char*)block + lodepng_arena_round(sizeof(LodePNGArenaBlock));
+}
+
+static LodePNGArenaBlock* lodepng_arena_new_block(LodePNGArena* arena, size_t size)
+{
+  LodePNGArenaBlock* block = (LodePNGArenaBlock*)malloc(lodepng_arena_round(sizeof(LodePNGArenaBlock)) + size);
+  if(!block) return 0;
+  block->next = arena->blocks;
+  block->size = size;
+  block->used = 0;
+  block->last = 0;
+  arena->blocks = block;
+  ++arena->heap_allocations;
+  return block;
+}
+
+static int lodepng_arena_owns(const LodePNGArena* arena, const void* ptr)
+{
+  LodePNGArenaBlock* block;
+  for(block = arena->blocks; block; block = block->next)
+  {
+    unsigned char* data = lodepng_arena_block_data(block);
+    if((const unsigned char*)ptr >= data && (const unsigned char*)ptr < data + block->size) return 1;
+  }
+  return 0;
+}
+
+/*whether ptr is the most recent allocation of the current block, which can be resized in place*/
+static int lodepng_arena_is_last(const LodePNGArena* arena, const void* ptr)
+{
+  LodePNGArenaBlock* block = arena->blocks;
+  return block && block->used > 0
+      && (const unsigned char*)ptr == lodepng_arena_block_data(block) + block->last + LODEPNG_ARENA_ALIGN;
+}
+
+static void* lodepng_arena_alloc(LodePNGArena* arena, size_t size)
+{
+  LodePNGArenaBlock* block = arena->blocks;
+  size_t needed = LODEPNG_ARENA_ALIGN + lodepng_arena_round(size);
+  unsigned char* header;
+  if(!block || block->size - block->used < needed)
+  {
+    size_t blocksize = block ? block->size * 2 : LODEPNG_ARENA_MIN_BLOCK;
+    if(blocksize < needed) blocksize = needed;
+    block = lodepng_arena_new_block(arena, blocksize);
+    if(!block) return 0;
+  }
+  header = lodepng_arena_block_data(block) + block->used;
+  *(size_t*)header = size;
+  block->last = block->used;
+  block->used += needed;
+  arena->used += needed;
+  if(arena->used > arena->high_water) arena->high_water = arena->used;
+  return header + LODEPNG_ARENA_ALIGN;
+}
+
+static void lodepng_arena_free(LodePNGArena* arena, void* ptr)
+{
+  if(lodepng_arena_is_last(arena, ptr))
+  {
+    LodePNGArenaBlock* block = arena->blocks;
+    arena->used -= block->used - block->last;
+    block->used = block->last;
+  }
+}
+
+static void* lodepng_arena_realloc(LodePNGArena* arena, void* ptr, size_t new_size)
+{
+  size_t old_size;
+  void* result;
+  if(!ptr) return lodepng_arena_alloc(arena, new_size);
+  old_size = *(size_t*)((unsigned char*)ptr - LODEPNG_ARENA_ALIGN);
+  if(lodepng_arena_is_last(arena, ptr))
+  {
+    LodePNGArenaBlock* block = arena->blocks;
+    size_t needed = LODEPNG_ARENA_ALIGN + lodepng_arena_round(new_size);
+    if(block->size - block->last >= needed)
+    {
+      arena->used += needed - (block->used - block->last);
+      if(arena->used > arena->high_water) arena->high_water = arena->used;
+      block->used = block->last + needed;
+      *(size_t*)((unsigned char*)ptr - LODEPNG_ARENA_ALIGN) = new_size;
+      return ptr;
+    }
+  }
+  result = lodepng_arena_alloc(arena, new_size);
+  if(result) memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+  return result;
+}
+
+void lodepng_arena_init(LodePNGArena* arena)
+{
+  arena->blocks = 0;
+  arena->used = 0;
+  arena->high_water = 0;
+  arena->heap_allocations = 0;
+}
+
+void lodepng_arena_cleanup(LodePNGArena* arena)
+{
+  while(arena->blocks)
+  {
+    LodePNGArenaBlock* next = arena->blocks->next;
+    free(arena->blocks);
+    arena->blocks = next;
+  }
+  arena->used = 0;
+}
+
+void lodepng_arena_reset(LodePNGArena* arena)
+{
+  LodePNGArenaBlock* block;
+  if(arena->blocks && arena->blocks->next)
+  {
+    /*the last frame spilled over several blocks: replace them with one that fits it*/
+    size_t high_water = arena->high_water;
+    lodepng_arena_cleanup(arena);
+    lodepng_arena_new_block(arena, lodepng_arena_round(high_water + high_water / 8));
+  }
+  for(block = arena->blocks; block; block = block->next) block->used = block->last = 0;
+  arena->used = 0;
+}
+#endif /*LODEPNG_COMPILE_ENCODER*/
+
 static void* lodepng_malloc(size_t size)
 {
 #ifdef LODEPNG_MAX_ALLOC
   if(size > LODEPNG_MAX_ALLOC) return 0;
 #endif
+#ifdef LODEPNG_COMPILE_ENCODER
+  if(lodepng_current_arena) return lodepng_arena_alloc(lodepng_current_arena, size);
+#endif /*LODEPNG_COMPILE_ENCODER*/
   return malloc(size);
 }
 
@@ -73,11 +249,24 @@ static void* lodepng_realloc(void* ptr, size_t new_size)
 #ifdef LODEPNG_MAX_ALLOC
   if(new_size > LODEPNG_MAX_ALLOC) return 0;
 #endif
+#ifdef LODEPNG_COMPILE_ENCODER
+  if(lodepng_current_arena && (!ptr || lodepng_arena_owns(lodepng_current_arena, ptr)))
+  {
+    return lodepng_arena_realloc(lodepng_current_arena, ptr, new_size);
+  }
+#endif /*LODEPNG_COMPILE_ENCODER*/
   return realloc(ptr, new_size);
 }
 
 static void lodepng_free(void* ptr)
 {
+#ifdef LODEPNG_COMPILE_ENCODER
+  if(lodepng_current_arena && ptr && lodepng_arena_owns(lodepng_current_arena, ptr))
+  {
+    lodepng_arena_free(lodepng_current_arena, ptr);
+    return;
+  }
+#endif /*LODEPNG_COMPILE_ENCODER*/
   free(ptr);
 }
 #else /*LODEPNG_COMPILE_ALLOCATORS*/
@@ -469,6 +658,34 @@ static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bits
   }
   return result;
 }
+
+/*64-bit window of the bit stream used by the Huffman decoder*/
+typedef unsigned long long BitWindow;
+
+/*
+Returns the bits of the stream starting at bit position bitpointer, first bit in
+the lowest position. At least 56 bits are valid, enough for a whole length/distance
+pair with its extra bits. Bytes past the end of the input read as zero, so callers
+must compare the bit pointer with the input length after consuming bits.
+*/
+static BitWindow peekBits(const unsigned char* bitstream, size_t bytelength, size_t bitpointer)
+{
+  size_t p = bitpointer >> 3;
+  BitWindow result = 0;
+  if(p + 8 <= bytelength)
+  {
+    result = (BitWindow)bitstream[p] | ((BitWindow)bitstream[p + 1] << 8)
+           | ((BitWindow)bitstream[p + 2] << 16) | ((BitWindow)bitstream[p + 3] << 24)
+           | ((BitWindow)bitstream[p + 4] << 32) | ((BitWindow)bitstream[p + 5] << 40)
+           | ((BitWindow)bitstream[p + 6] << 48) | ((BitWindow)bitstream[p + 7] << 56);
+  }
+  else
+  {
+    unsigned i;
+    for(i = 0; i != 8 && p + i < bytelength; ++i) result |= (BitWindow)bitstream[p + i] << (8 * i);
+  }
+  return result >> (bitpointer & 7);
+}
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -516,11 +733,13 @@ Huffman tree struct, containing multiple representations of the tree
 */
 typedef struct HuffmanTree
 {
-  unsigned* tree2d;
   unsigned* tree1d;
   unsigned* lengths; /*the lengths of the codes of the 1d-tree*/
   unsigned maxbitlen; /*maximum number of bits a single code can get*/
   unsigned numcodes; /*number of symbols in the alphabet = number of codes*/
+  /*decoder lookup tables, indexed by the next FIRSTBITS bits of the stream, see HuffmanTree_makeTable*/
+  unsigned char* table_len;
+  unsigned short* table_value;
 } HuffmanTree;
 
 /*function used for debug purposes to draw the tree in ascii art with C++*/
@@ -538,78 +757,151 @@ static void HuffmanTree_draw(HuffmanTree* tree)
 
 static void HuffmanTree_init(HuffmanTree* tree)
 {
-  tree->tree2d = 0;
   tree->tree1d = 0;
   tree->lengths = 0;
+  tree->table_len = 0;
+  tree->table_value = 0;
 }
 
 static void HuffmanTree_cleanup(HuffmanTree* tree)
 {
-  lodepng_free(tree->tree2d);
   lodepng_free(tree->tree1d);
   lodepng_free(tree->lengths);
+  lodepng_free(tree->table_len);
+  lodepng_free(tree->table_value);
+}
+
+#ifdef LODEPNG_COMPILE_DECODER
+/*number of bits resolved by the primary decoding table*/
+#define FIRSTBITS 9u
+/*marks table entries of symbols that cannot occur, e.g. in a tree with a single code*/
+#define INVALIDSYMBOL 65535u
+
+static unsigned reverseBits(unsigned bits, unsigned num)
+{
+  unsigned i, result = 0;
+  for(i = 0; i < num; ++i) result |= ((bits >> (num - i - 1u)) & 1u) << i;
+  return result;
 }
 
-/*the tree representation used by the decoder. return value is error*/
-static unsigned HuffmanTree_make2DTree(HuffmanTree* tree)
+/*
+The representation used by the decoder: instead of walking a tree one bit at a
+time, the next FIRSTBITS bits of the stream (lowest bit first) index a primary
+table giving the symbol and its code length directly. Codes longer than FIRSTBITS
+share a primary entry holding the maximum length of that group (> FIRSTBITS) and
+the offset of a secondary table, indexed by the following bits.
+return value is error.
+*/
+static unsigned HuffmanTree_makeTable(HuffmanTree* tree)
 {
-  unsigned nodefilled = 0; /*up to which node it is filled*/
-  unsigned treepos = 0; /*position in the tree (1 of the numcodes columns)*/
-  unsigned n, i;
+  static const unsigned headsize = 1u << FIRSTBITS;
+  static const unsigned mask = (1u << FIRSTBITS) - 1u;
+  size_t i, numpresent, pointer, size;
+  unsigned* maxlens = (unsigned*)lodepng_malloc(headsize * sizeof(unsigned));
+  if(!maxlens) return 83; /*alloc fail*/
 
-  tree->tree2d = (unsigned*)lodepng_malloc(tree->numcodes * 2 * sizeof(unsigned));
-  if(!tree->tree2d) return 83; /*alloc fail*/
+  /*compute the maximum code length of every group of long codes sharing the same first bits*/
+  for(i = 0; i != headsize; ++i) maxlens[i] = 0;
+  for(i = 0; i != tree->numcodes; ++i)
+  {
+    unsigned l = tree->lengths[i];
+    unsigned index;
+    if(l <= FIRSTBITS) continue;
+    index = reverseBits(tree->tree1d[i] >> (l - FIRSTBITS), FIRSTBITS);
+    maxlens[index] = LODEPNG_MAX(maxlens[index], l);
+  }
+  size = headsize;
+  for(i = 0; i != headsize; ++i)
+  {
+    if(maxlens[i] > FIRSTBITS) size += (size_t)1u << (maxlens[i] - FIRSTBITS);
+  }
+  tree->table_len = (unsigned char*)lodepng_malloc(size * sizeof(*tree->table_len));
+  tree->table_value = (unsigned short*)lodepng_malloc(size * sizeof(*tree->table_value));
+  if(!tree->table_len || !tree->table_value)
+  {
+    lodepng_free(maxlens);
+    return 83; /*alloc fail*/
+  }
+  /*16 marks entries not filled in yet*/
+  for(i = 0; i != size; ++i) tree->table_len[i] = 16;
 
-  /*
-  convert tree1d[] to tree2d[][]. In the 2D array, a value of 32767 means
-  uninited, a value >= numcodes is an address to another bit, a value < numcodes
-  is a code. The 2 rows are the 2 possible bit values (0 or 1), there are as
-  many columns as codes - 1.
-  A good huffman tree has N * 2 - 1 nodes, of which N - 1 are internal nodes.
-  Here, the internal nodes are stored (what their 0 and 1 option point to).
-  There is only memory for such good tree currently, if there are more nodes
-  (due to too long length codes), error 55 will happen
-  */
-  for(n = 0; n < tree->numcodes * 2; ++n)
+  /*point the primary entries of long codes to their secondary tables*/
+  pointer = headsize;
+  for(i = 0; i != headsize; ++i)
   {
-    tree->tree2d[n] = 32767; /*32767 here means the tree2d isn't filled there yet*/
+    unsigned l = maxlens[i];
+    if(l <= FIRSTBITS) continue;
+    tree->table_len[i] = (unsigned char)l;
+    tree->table_value[i] = (unsigned short)pointer;
+    pointer += (size_t)1u << (l - FIRSTBITS);
   }
+  lodepng_free(maxlens);
 
-  for(n = 0; n < tree->numcodes; ++n) /*the codes*/
+  /*fill in the symbols*/
+  numpresent = 0;
+  for(i = 0; i != tree->numcodes; ++i)
   {
-    for(i = 0; i != tree->lengths[n]; ++i) /*the bits for this code*/
+    unsigned l = tree->lengths[i];
+    unsigned reverse, j;
+    if(l == 0) continue;
+    reverse = reverseBits(tree->tree1d[i], l);
+    ++numpresent;
+    if(l <= FIRSTBITS)
     {
-      unsigned char bit = (unsigned char)((tree->tree1d[n] >> (tree->lengths[n] - i - 1)) & 1);
-      /*oversubscribed, see comment in lodepng_error_text*/
-      if(treepos > 2147483647 || treepos + 2 > tree->numcodes) return 55;
-      if(tree->tree2d[2 * treepos + bit] == 32767) /*not yet filled in*/
+      /*short code: fill every entry whose low l bits match*/
+      unsigned num = 1u << (FIRSTBITS - l);
+      for(j = 0; j != num; ++j)
       {
-        if(i + 1 == tree->lengths[n]) /*last bit*/
-        {
-          tree->tree2d[2 * treepos + bit] = n; /*put the current code in it*/
-          treepos = 0;
-        }
-        else
-        {
-          /*put address of the next step in here, first that address has to be found of course
-          (it's just nodefilled + 1)...*/
-          ++nodefilled;
-          /*addresses encoded with numcodes added to it*/
-          tree->tree2d[2 * treepos + bit] = nodefilled + tree->numcodes;
-          treepos = nodefilled;
-        }
+        unsigned index = reverse | (j << l);
+        if(tree->table_len[index] != 16) return 55; /*oversubscribed, see comment in lodepng_error_text*/
+        tree->table_len[index] = (unsigned char)l;
+        tree->table_value[index] = (unsigned short)i;
+      }
+    }
+    else
+    {
+      /*long code: fill the matching entries of the secondary table of its group*/
+      unsigned index = reverse & mask;
+      unsigned maxlen = tree->table_len[index];
+      unsigned start = tree->table_value[index];
+      unsigned num;
+      if(maxlen < l) return 55; /*oversubscribed*/
+      num = 1u << (maxlen - l);
+      for(j = 0; j != num; ++j)
+      {
+        unsigned index2 = start + ((reverse >> FIRSTBITS) | (j << (l - FIRSTBITS)));
+        if(tree->table_len[index2] != 16) return 55; /*oversubscribed, another long code has the same bits*/
+        tree->table_len[index2] = (unsigned char)l;
+        tree->table_value[index2] = (unsigned short)i;
       }
-      else treepos = tree->tree2d[2 * treepos + bit] - tree->numcodes;
     }
   }
 
-  for(n = 0; n < tree->numcodes * 2; ++n)
+  if(numpresent < 2)
   {
-    if(tree->tree2d[n] == 32767) tree->tree2d[n] = 0; /*remove possible remaining 32767's*/
+    /*With a single code deflate still uses 1 bit, and a tree without codes can exist
+    if its symbols are never used (e.g. distances). Not all entries are filled then:
+    make them decode to an invalid symbol so that reading them is an error.*/
+    for(i = 0; i != size; ++i)
+    {
+      if(tree->table_len[i] == 16)
+      {
+        tree->table_len[i] = (i < headsize) ? 1 : (FIRSTBITS + 1);
+        tree->table_value[i] = INVALIDSYMBOL;
+      }
+    }
+  }
+  else
+  {
+    /*A complete tree fills every entry. Unfilled ones mean some bit sequences cannot be decoded.*/
+    for(i = 0; i != size; ++i)
+    {
+      if(tree->table_len[i] == 16) return 55;
+    }
   }
-
   return 0;
 }
+#endif /*LODEPNG_COMPILE_DECODER*/
 
 /*
 Second step for the ...makeFromLengths and ...makeFromFrequencies functions.
@@ -652,8 +944,7 @@ static unsigned HuffmanTree_makeFromLengths2(HuffmanTree* tree)
   uivector_cleanup(&blcount);
   uivector_cleanup(&nextcode);
 
-  if(!error) return HuffmanTree_make2DTree(tree);
-  else return error;
+  return error;
 }
 
 /*
@@ -670,7 +961,12 @@ static unsigned HuffmanTree_makeFromLengths(HuffmanTree* tree, const unsigned* b
   for(i = 0; i != numcodes; ++i) tree->lengths[i] = bitlen[i];
   tree->numcodes = (unsigned)numcodes; /*number of symbols*/
   tree->maxbitlen = maxbitlen;
+#ifdef LODEPNG_COMPILE_DECODER
+  CERROR_TRY_RETURN(HuffmanTree_makeFromLengths2(tree));
+  return HuffmanTree_makeTable(tree);
+#else /*LODEPNG_COMPILE_DECODER*/
   return HuffmanTree_makeFromLengths2(tree);
+#endif /*LODEPNG_COMPILE_DECODER*/
 }
 
 #ifdef LODEPNG_COMPILE_ENCODER
@@ -948,6 +1244,27 @@ static unsigned generateFixedDistanceTree(HuffmanTree* tree)
 
 #ifdef LODEPNG_COMPILE_DECODER
 
+/*
+decodes one symbol from the lowest bits of the window with the lookup tables.
+*length receives the number of bits the symbol used. Returns INVALIDSYMBOL if the
+bits do not correspond to a symbol of the tree.
+*/
+static unsigned huffmanDecodeWindow(const HuffmanTree* codetree, BitWindow window, unsigned* length)
+{
+  unsigned index = (unsigned)(window & ((1u << FIRSTBITS) - 1u));
+  unsigned l = codetree->table_len[index];
+  unsigned value = codetree->table_value[index];
+  if(l > FIRSTBITS)
+  {
+    /*long code: the primary entry points to a secondary table indexed by the following bits*/
+    index = value + (unsigned)((window >> FIRSTBITS) & ((1u << (l - FIRSTBITS)) - 1u));
+    l = codetree->table_len[index];
+    value = codetree->table_value[index];
+  }
+  *length = l;
+  return value;
+}
+
 /*
 returns the code, or (unsigned)(-1) if error happened
 inbitlength is the length of the complete buffer, in bits (so its byte length times 8)
@@ -955,21 +1272,12 @@ inbitlength is the length of the complete buffer, in bits (so its byte length ti
 static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
                                     const HuffmanTree* codetree, size_t inbitlength)
 {
-  unsigned treepos = 0, ct;
-  for(;;)
-  {
-    if(*bp >= inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
-    /*
-    decode the symbol from the tree. The "readBitFromStream" code is inlined in
-    the expression below because this is the biggest bottleneck while decoding
-    */
-    ct = codetree->tree2d[(treepos << 1) + READBIT(*bp, in)];
-    ++(*bp);
-    if(ct < codetree->numcodes) return ct; /*the symbol is decoded, return it*/
-    else treepos = ct - codetree->numcodes; /*symbol not yet decoded, instead move tree position*/
-
-    if(treepos >= codetree->numcodes) return (unsigned)(-1); /*error: it appeared outside the codetree*/
-  }
+  unsigned length;
+  unsigned value = huffmanDecodeWindow(codetree, peekBits(in, inbitlength >> 3, *bp), &length);
+  (*bp) += length;
+  /*error: end of input memory reached without endcode, or a code not in the tree*/
+  if(*bp > inbitlength || value == INVALIDSYMBOL) return (unsigned)(-1);
+  return value;
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
 
@@ -1136,8 +1444,32 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 }
 
 /*inflate a block with dynamic of fixed Huffman tree*/
+/*
+Optional progress reports of the inflater, used by the pipelined PNG decoder to
+consume scanlines while they are still being decompressed. report is called with
+the output produced so far whenever it grew by at least step bytes since the last
+report, and at the end of every block. It can stop the inflater by returning an
+error code.
+*/
+typedef struct InflateProgress
+{
+  unsigned (*report)(void* context, const unsigned char* data, size_t size);
+  void* context;
+  size_t step;
+  size_t limit; /*a report is also made as soon as the output grows past this size*/
+  size_t next; /*output size that triggers the next report*/
+} InflateProgress;
+
+static unsigned inflateReport(InflateProgress* progress, const ucvector* out, size_t pos)
+{
+  progress->next = pos + progress->step;
+  if(pos <= progress->limit && progress->next > progress->limit + 1) progress->next = progress->limit + 1;
+  return progress->report(progress->context, out->data, pos);
+}
+
 static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size_t* bp,
-                                    size_t* pos, size_t inlength, unsigned btype)
+                                    size_t* pos, size_t inlength, unsigned btype,
+                                    InflateProgress* progress)
 {
   unsigned error = 0;
   HuffmanTree tree_ll; /*the huffman tree for literal and length codes*/
@@ -1152,38 +1484,61 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
   while(!error) /*decode all symbols until end reached, breaks at end code*/
   {
+    /*one 64-bit window holds at least 56 bits: several literals of at most 15 bits
+    are decoded from it before the stream is read again*/
+    BitWindow window = peekBits(in, inlength, *bp);
+    unsigned shift, len;
     /*code_ll is literal, length or end code*/
-    unsigned code_ll = huffmanDecodeSymbol(in, bp, &tree_ll, inbitlength);
-    if(code_ll <= 255) /*literal symbol*/
+    unsigned code_ll = huffmanDecodeWindow(&tree_ll, window, &len);
+    shift = len;
+    while(code_ll <= 255 && shift <= 56 - 15)
     {
       /*ucvector_push_back would do the same, but for some reason the two lines below run 10% faster*/
       if(!ucvector_resize(out, (*pos) + 1)) ERROR_BREAK(83 /*alloc fail*/);
       out->data[*pos] = (unsigned char)code_ll;
       ++(*pos);
+      code_ll = huffmanDecodeWindow(&tree_ll, window >> shift, &len);
+      shift += len;
+    }
+    if(error) break;
+    (*bp) += shift;
+    /*error: end of input memory reached without endcode*/
+    if(*bp > inbitlength) ERROR_BREAK(10);
+
+    if(code_ll <= 255) /*literal symbol that did not fit the loop above*/
+    {
+      if(!ucvector_resize(out, (*pos) + 1)) ERROR_BREAK(83 /*alloc fail*/);
+      out->data[*pos] = (unsigned char)code_ll;
+      ++(*pos);
     }
     else if(code_ll >= FIRST_LENGTH_CODE_INDEX && code_ll <= LAST_LENGTH_CODE_INDEX) /*length code*/
     {
       unsigned code_d, distance;
       unsigned numextrabits_l, numextrabits_d; /*extra bits for length and distance*/
-      size_t start, forward, backward, length;
+      size_t start, backward, length;
+
+      /*the length extra bits, distance code and distance extra bits take at most
+      5 + 15 + 13 bits, so they all come from one window*/
+      window = peekBits(in, inlength, *bp);
 
       /*part 1: get length base*/
       length = LENGTHBASE[code_ll - FIRST_LENGTH_CODE_INDEX];
 
       /*part 2: get extra bits and add the value of that to length*/
       numextrabits_l = LENGTHEXTRA[code_ll - FIRST_LENGTH_CODE_INDEX];
-      if((*bp + numextrabits_l) > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-      length += readBitsFromStream(bp, in, numextrabits_l);
+      length += (size_t)(window & ((1u << numextrabits_l) - 1u));
+      shift = numextrabits_l;
 
       /*part 3: get distance code*/
-      code_d = huffmanDecodeSymbol(in, bp, &tree_d, inbitlength);
+      code_d = huffmanDecodeWindow(&tree_d, window >> shift, &len);
+      shift += len;
       if(code_d > 29)
       {
-        if(code_d == (unsigned)(-1)) /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
+        if(code_d == INVALIDSYMBOL)
         {
-          /*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
+          /*return error code 10 or 11 depending on the situation that happened
           (10=no endcode, 11=wrong jump outside of tree)*/
-          error = (*bp) > inlength * 8 ? 10 : 11;
+          error = (*bp) + shift > inbitlength ? 10 : 11;
         }
         else error = 18; /*error: invalid distance code (30-31 are never used)*/
         break;
@@ -1192,8 +1547,10 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
       /*part 4: get extra bits from distance*/
       numextrabits_d = DISTANCEEXTRA[code_d];
-      if((*bp + numextrabits_d) > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-      distance += readBitsFromStream(bp, in, numextrabits_d);
+      distance += (unsigned)((window >> shift) & ((1u << numextrabits_d) - 1u));
+      shift += numextrabits_d;
+      (*bp) += shift;
+      if(*bp > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
 
       /*part 5: fill in all the out[n] values based on the length and dist*/
       start = (*pos);
@@ -1201,12 +1558,28 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
       backward = start - distance;
 
       if(!ucvector_resize(out, (*pos) + length)) ERROR_BREAK(83 /*alloc fail*/);
-      if (distance < length) {
-        for(forward = 0; forward < length; ++forward)
+      if(distance == 1)
+      {
+        /*run of a single byte*/
+        memset(out->data + *pos, out->data[backward], length);
+        *pos += length;
+      }
+      else if(distance < length)
+      {
+        /*overlapping copy of a repeating pattern: copy it in non-overlapping pieces
+        of distance bytes, each piece reading what the previous one wrote*/
+        size_t remaining = length;
+        while(remaining > 0)
         {
-          out->data[(*pos)++] = out->data[backward++];
+          size_t n = remaining < distance ? remaining : distance;
+          memcpy(out->data + *pos, out->data + backward, n);
+          *pos += n;
+          backward += n;
+          remaining -= n;
         }
-      } else {
+      }
+      else
+      {
         memcpy(out->data + *pos, out->data + backward, length);
         *pos += length;
       }
@@ -1215,13 +1588,13 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
     {
       break; /*end code, break the loop*/
     }
-    else /*if(code == (unsigned)(-1))*/ /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
+    else /*INVALIDSYMBOL or one of the unused codes 286-287*/
     {
-      /*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
-      (10=no endcode, 11=wrong jump outside of tree)*/
-      error = ((*bp) > inlength * 8) ? 10 : 11;
+      error = 11; /*wrong jump outside of tree*/
       break;
     }
+
+    if(progress && *pos >= progress->next) error = inflateReport(progress, out, *pos);
   }
 
   HuffmanTree_cleanup(&tree_ll);
@@ -1233,7 +1606,7 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 static unsigned inflateNoCompression(ucvector* out, const unsigned char* in, size_t* bp, size_t* pos, size_t inlength)
 {
   size_t p;
-  unsigned LEN, NLEN, n, error = 0;
+  unsigned LEN, NLEN, error = 0;
 
   /*go to first boundary of byte*/
   while(((*bp) & 0x7) != 0) ++(*bp);
@@ -1251,7 +1624,9 @@ static unsigned inflateNoCompression(ucvector* out, const unsigned char* in, siz
 
   /*read the literal data: LEN bytes are now stored in the out buffer*/
   if(p + LEN > inlength) return 23; /*error: reading outside of in buffer*/
-  for(n = 0; n < LEN; ++n) out->data[(*pos)++] = in[p++];
+  memcpy(out->data + *pos, in + p, LEN);
+  *pos += LEN;
+  p += LEN;
 
   (*bp) = p * 8;
 
@@ -1260,7 +1635,8 @@ static unsigned inflateNoCompression(ucvector* out, const unsigned char* in, siz
 
 static unsigned lodepng_inflatev(ucvector* out,
                                  const unsigned char* in, size_t insize,
-                                 const LodePNGDecompressSettings* settings)
+                                 const LodePNGDecompressSettings* settings,
+                                 InflateProgress* progress)
 {
   /*bit pointer in the "in" data, current byte is bp >> 3, current bit is bp & 0x7 (from lsb to msb of the byte)*/
   size_t bp = 0;
@@ -1280,8 +1656,9 @@ static unsigned lodepng_inflatev(ucvector* out,
 
     if(BTYPE == 3) return 20; /*error: invalid BTYPE*/
     else if(BTYPE == 0) error = inflateNoCompression(out, in, &bp, &pos, insize); /*no compression*/
-    else error = inflateHuffmanBlock(out, in, &bp, &pos, insize, BTYPE); /*compression, BTYPE 01 or 10*/
+    else error = inflateHuffmanBlock(out, in, &bp, &pos, insize, BTYPE, progress); /*compression, BTYPE 01 or 10*/
 
+    if(!error && progress) error = inflateReport(progress, out, pos);
     if(error) return error;
   }
 
@@ -1295,7 +1672,7 @@ unsigned lodepng_inflate(unsigned char** out, size_t* outsize,
   unsigned error;
   ucvector v;
   ucvector_init_buffer(&v, *out, *outsize);
-  error = lodepng_inflatev(&v, in, insize, settings);
+  error = lodepng_inflatev(&v, in, insize, settings, 0);
   *out = v.data;
   *outsize = v.size;
   return error;
@@ -1348,23 +1725,43 @@ static size_t searchCodeIndex(const unsigned* array, size_t array_size, size_t v
   return left;
 }
 
-static void addLengthDistance(uivector* values, size_t length, size_t distance)
+/*
+The LZ77 output is a compact token stream: one unsigned per literal or per
+length/distance pair (a pair used to take four entries). A token holds:
+  bits  0-8:  lit/len symbol (0-255 literal, 257-285 length code)
+  bits  9-13: extra length bits
+  bits 14-18: distance code
+  bits 19-31: extra distance bits
+Symbol frequencies for the dynamic Huffman trees are counted while the tokens are
+produced, so deflateDynamic does not need a second pass over the stream.
+*/
+#define LZ77_TOKEN_SYMBOL(token) ((token) & 511u)
+#define LZ77_TOKEN_LENGTH_EXTRA(token) (((token) >> 9) & 31u)
+#define LZ77_TOKEN_DISTANCE_CODE(token) (((token) >> 14) & 31u)
+#define LZ77_TOKEN_DISTANCE_EXTRA(token) ((token) >> 19)
+
+/*frequencies_ll may be NULL if no frequencies are needed (fixed trees)*/
+static unsigned addLiteral(uivector* values, unsigned char value, unsigned* frequencies_ll)
 {
-  /*values in encoded vector are those used by deflate:
-  0-255: literal bytes
-  256: end
-  257-285: length/distance pair (length code, followed by extra length bits, distance code, extra distance bits)
-  286-287: invalid*/
+  if(frequencies_ll) ++frequencies_ll[value];
+  return uivector_push_back(values, value);
+}
 
+static unsigned addLengthDistance(uivector* values, size_t length, size_t distance,
+                                  unsigned* frequencies_ll, unsigned* frequencies_d)
+{
   unsigned length_code = (unsigned)searchCodeIndex(LENGTHBASE, 29, length);
   unsigned extra_length = (unsigned)(length - LENGTHBASE[length_code]);
   unsigned dist_code = (unsigned)searchCodeIndex(DISTANCEBASE, 30, distance);
   unsigned extra_distance = (unsigned)(distance - DISTANCEBASE[dist_code]);
+  unsigned symbol = length_code + FIRST_LENGTH_CODE_INDEX;
 
-  uivector_push_back(values, length_code + FIRST_LENGTH_CODE_INDEX);
-  uivector_push_back(values, extra_length);
-  uivector_push_back(values, dist_code);
-  uivector_push_back(values, extra_distance);
+  if(frequencies_ll)
+  {
+    ++frequencies_ll[symbol];
+    ++frequencies_d[dist_code];
+  }
+  return uivector_push_back(values, symbol | (extra_length << 9) | (dist_code << 14) | (extra_distance << 19));
 }
 
 /*3 bytes of data get encoded into two bytes. The hash cannot use more than 3
@@ -1479,7 +1876,7 @@ sliding window (of windowsize) is used, and all past bytes in that window can be
 the "dictionary". A brute force search through all possible distances would be slow, and
 this hash technique is one out of several ways to speed this up.
 */
-static unsigned encodeLZ77(uivector* out, Hash* hash,
+static unsigned encodeLZ77(uivector* out, unsigned* frequencies_ll, unsigned* frequencies_d, Hash* hash,
                            const unsigned char* in, size_t inpos, size_t insize, unsigned windowsize,
                            unsigned minmatch, unsigned nicematch, unsigned lazymatching)
 {
@@ -1606,7 +2003,7 @@ static unsigned encodeLZ77(uivector* out, Hash* hash,
         if(length > lazylength + 1)
         {
           /*push the previous character as literal*/
-          if(!uivector_push_back(out, in[pos - 1])) ERROR_BREAK(83 /*alloc fail*/);
+          if(!addLiteral(out, in[pos - 1], frequencies_ll)) ERROR_BREAK(83 /*alloc fail*/);
         }
         else
         {
@@ -1623,17 +2020,17 @@ static unsigned encodeLZ77(uivector* out, Hash* hash,
     /*encode it as length/distance pair or literal value*/
     if(length < 3) /*only lengths of 3 or higher are supported as length/distance pair*/
     {
-      if(!uivector_push_back(out, in[pos])) ERROR_BREAK(83 /*alloc fail*/);
+      if(!addLiteral(out, in[pos], frequencies_ll)) ERROR_BREAK(83 /*alloc fail*/);
     }
     else if(length < minmatch || (length == 3 && offset > 4096))
     {
       /*compensate for the fact that longer offsets have more extra bits, a
       length of only 3 may be not worth it then*/
-      if(!uivector_push_back(out, in[pos])) ERROR_BREAK(83 /*alloc fail*/);
+      if(!addLiteral(out, in[pos], frequencies_ll)) ERROR_BREAK(83 /*alloc fail*/);
     }
     else
     {
-      addLengthDistance(out, length, offset);
+      if(!addLengthDistance(out, length, offset, frequencies_ll, frequencies_d)) ERROR_BREAK(83 /*alloc fail*/);
       for(i = 1; i < length; ++i)
       {
         ++pos;
@@ -1706,19 +2103,20 @@ static void writeLZ77data(size_t* bp, ucvector* out, const uivector* lz77_encode
   size_t i = 0;
   for(i = 0; i != lz77_encoded->size; ++i)
   {
-    unsigned val = lz77_encoded->data[i];
+    unsigned token = lz77_encoded->data[i];
+    unsigned val = LZ77_TOKEN_SYMBOL(token);
     addHuffmanSymbol(bp, out, HuffmanTree_getCode(tree_ll, val), HuffmanTree_getLength(tree_ll, val));
     if(val > 256) /*for a length code, 3 more things have to be added*/
     {
       unsigned length_index = val - FIRST_LENGTH_CODE_INDEX;
       unsigned n_length_extra_bits = LENGTHEXTRA[length_index];
-      unsigned length_extra_bits = lz77_encoded->data[++i];
+      unsigned length_extra_bits = LZ77_TOKEN_LENGTH_EXTRA(token);
 
-      unsigned distance_code = lz77_encoded->data[++i];
+      unsigned distance_code = LZ77_TOKEN_DISTANCE_CODE(token);
 
       unsigned distance_index = distance_code;
       unsigned n_distance_extra_bits = DISTANCEEXTRA[distance_index];
-      unsigned distance_extra_bits = lz77_encoded->data[++i];
+      unsigned distance_extra_bits = LZ77_TOKEN_DISTANCE_EXTRA(token);
 
       addBitsToStream(bp, out, length_extra_bits, n_length_extra_bits);
       addHuffmanSymbol(bp, out, HuffmanTree_getCode(tree_d, distance_code),
@@ -1729,7 +2127,8 @@ static void writeLZ77data(size_t* bp, ucvector* out, const uivector* lz77_encode
 }
 
 /*Deflate for a block of type "dynamic", that is, with freely, optimally, created huffman trees*/
-static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
+/*lz77_encoded is scratch space for the tokens of the block, reused across blocks*/
+static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash, uivector* lz77_encoded,
                                const unsigned char* data, size_t datapos, size_t dataend,
                                const LodePNGCompressSettings* settings, unsigned final)
 {
@@ -1746,8 +2145,6 @@ static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
   the code length code lengths ("clcl").
   */
 
-  /*The lz77 encoded data, represented with integers since there will also be length and distance codes in it*/
-  uivector lz77_encoded;
   HuffmanTree tree_ll; /*tree for lit,len values*/
   HuffmanTree tree_d; /*tree for distance codes*/
   HuffmanTree tree_cl; /*tree for encoding the code lengths representing tree_ll and tree_d*/
@@ -1773,7 +2170,6 @@ static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
   size_t numcodes_ll, numcodes_d, i;
   unsigned HLIT, HDIST, HCLEN;
 
-  uivector_init(&lz77_encoded);
   HuffmanTree_init(&tree_ll);
   HuffmanTree_init(&tree_d);
   HuffmanTree_init(&tree_cl);
@@ -1788,31 +2184,27 @@ static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
   allow breaking out of it to the cleanup phase on error conditions.*/
   while(!error)
   {
+    if(!uivector_resizev(&frequencies_ll, 286, 0)) ERROR_BREAK(83 /*alloc fail*/);
+    if(!uivector_resizev(&frequencies_d, 30, 0)) ERROR_BREAK(83 /*alloc fail*/);
+    /*at most one token per input byte: reserve the block upfront instead of growing while matching.
+    After the first block this is a no-op, the tokens of the previous block are simply overwritten.*/
+    lz77_encoded->size = 0;
+    if(!uivector_reserve(lz77_encoded, datasize * sizeof(unsigned))) ERROR_BREAK(83 /*alloc fail*/);
+
+    /*the frequencies of lit, len and dist codes are counted while encoding*/
     if(settings->use_lz77)
     {
-      error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings->windowsize,
-                         settings->minmatch, settings->nicematch, settings->lazymatching);
+      error = encodeLZ77(lz77_encoded, frequencies_ll.data, frequencies_d.data, hash, data, datapos, dataend,
+                         settings->windowsize, settings->minmatch, settings->nicematch, settings->lazymatching);
       if(error) break;
     }
     else
     {
-      if(!uivector_resize(&lz77_encoded, datasize)) ERROR_BREAK(83 /*alloc fail*/);
-      for(i = datapos; i < dataend; ++i) lz77_encoded.data[i - datapos] = data[i]; /*no LZ77, but still will be Huffman compressed*/
-    }
-
-    if(!uivector_resizev(&frequencies_ll, 286, 0)) ERROR_BREAK(83 /*alloc fail*/);
-    if(!uivector_resizev(&frequencies_d, 30, 0)) ERROR_BREAK(83 /*alloc fail*/);
-
-    /*Count the frequencies of lit, len and dist codes*/
-    for(i = 0; i != lz77_encoded.size; ++i)
-    {
-      unsigned symbol = lz77_encoded.data[i];
-      ++frequencies_ll.data[symbol];
-      if(symbol > 256)
+      if(!uivector_resize(lz77_encoded, datasize)) ERROR_BREAK(83 /*alloc fail*/);
+      for(i = datapos; i < dataend; ++i)
       {
-        unsigned dist = lz77_encoded.data[i + 2];
-        ++frequencies_d.data[dist];
-        i += 3;
+        lz77_encoded->data[i - datapos] = data[i]; /*no LZ77, but still will be Huffman compressed*/
+        ++frequencies_ll.data[data[i]];
       }
     }
     frequencies_ll.data[256] = 1; /*there will be exactly 1 end code, at the end of the block*/
@@ -1949,7 +2341,7 @@ static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
     }
 
     /*write the compressed data symbols*/
-    writeLZ77data(bp, out, &lz77_encoded, &tree_ll, &tree_d);
+    writeLZ77data(bp, out, lz77_encoded, &tree_ll, &tree_d);
     /*error: the length of the end code 256 must be larger than 0*/
     if(HuffmanTree_getLength(&tree_ll, 256) == 0) ERROR_BREAK(64);
 
@@ -1960,7 +2352,6 @@ static unsigned deflateDynamic(ucvector* out, size_t* bp, Hash* hash,
   }
 
   /*cleanup*/
-  uivector_cleanup(&lz77_encoded);
   HuffmanTree_cleanup(&tree_ll);
   HuffmanTree_cleanup(&tree_d);
   HuffmanTree_cleanup(&tree_cl);
@@ -2000,7 +2391,7 @@ static unsigned deflateFixed(ucvector* out, size_t* bp, Hash* hash,
   {
     uivector lz77_encoded;
     uivector_init(&lz77_encoded);
-    error = encodeLZ77(&lz77_encoded, hash, data, datapos, dataend, settings->windowsize,
+    error = encodeLZ77(&lz77_encoded, 0, 0, hash, data, datapos, dataend, settings->windowsize,
                        settings->minmatch, settings->nicematch, settings->lazymatching);
     if(!error) writeLZ77data(bp, out, &lz77_encoded, &tree_ll, &tree_d);
     uivector_cleanup(&lz77_encoded);
@@ -2029,6 +2420,7 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
   size_t i, blocksize, numdeflateblocks;
   size_t bp = 0; /*the bit pointer*/
   Hash hash;
+  uivector lz77_encoded; /*the tokens of one block, one per literal or length/distance pair (see LZ77_TOKEN_SYMBOL)*/
 
   if(settings->btype > 2) return 61;
   else if(settings->btype == 0) return deflateNoCompression(out, in, insize);
@@ -2046,6 +2438,7 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
 
   error = hash_init(&hash, settings->windowsize);
   if(error) return error;
+  uivector_init(&lz77_encoded);
 
   for(i = 0; i != numdeflateblocks && !error; ++i)
   {
@@ -2055,9 +2448,10 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
     if(end > insize) end = insize;
 
     if(settings->btype == 1) error = deflateFixed(out, &bp, &hash, in, start, end, settings, final);
-    else if(settings->btype == 2) error = deflateDynamic(out, &bp, &hash, in, start, end, settings, final);
+    else if(settings->btype == 2) error = deflateDynamic(out, &bp, &hash, &lz77_encoded, in, start, end, settings, final);
   }
 
+  uivector_cleanup(&lz77_encoded);
   hash_cleanup(&hash);
 
   return error;
@@ -2131,10 +2525,9 @@ static unsigned adler32(const unsigned char* data, unsigned len)
 
 #ifdef LODEPNG_COMPILE_DECODER
 
-unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const unsigned char* in,
-                                 size_t insize, const LodePNGDecompressSettings* settings)
+/*checks the 2-byte zlib header in front of the deflate data. return value is error*/
+static unsigned readZlibHeader(const unsigned char* in, size_t insize)
 {
-  unsigned error = 0;
   unsigned CM, CINFO, FDICT;
 
   if(insize < 2) return 53; /*error, size of zlib data too small*/
@@ -2162,6 +2555,14 @@ unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const uns
       "The additional flags shall not specify a preset dictionary."*/
     return 26;
   }
+  return 0;
+}
+
+unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const unsigned char* in,
+                                 size_t insize, const LodePNGDecompressSettings* settings)
+{
+  unsigned error = readZlibHeader(in, insize);
+  if(error) return error;
 
   error = inflate(out, outsize, in + 2, insize - 2, settings);
   if(error) return error;
@@ -4577,18 +4978,16 @@ static unsigned readChunk_pHYs(LodePNGInfo* info, const unsigned char* data, siz
 }
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-/*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
-static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
-                          LodePNGState* state,
-                          const unsigned char* in, size_t insize)
+/*
+reads the header and all chunks of a PNG, concatenating the data of the IDAT chunks
+into idat, which must be initialized. Errors are stored in state->error.
+*/
+static void readChunks(ucvector* idat, unsigned* w, unsigned* h, LodePNGState* state,
+                       const unsigned char* in, size_t insize)
 {
   unsigned char IEND = 0;
   const unsigned char* chunk;
   size_t i;
-  ucvector idat; /*the data from idat chunks*/
-  ucvector scanlines;
-  size_t predict;
-  size_t outsize = 0;
 
   /*for unknown chunk order*/
   unsigned unknown = 0;
@@ -4596,9 +4995,6 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
   unsigned critical_pos = 1; /*1 = after IHDR, 2 = after PLTE, 3 = after IDAT*/
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-  /*provide some proper output values if error will happen*/
-  *out = 0;
-
   state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
   if(state->error) return;
 
@@ -4607,7 +5003,6 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
     CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
   }
 
-  ucvector_init(&idat);
   chunk = &in[33]; /*first byte of the first chunk after the header*/
 
   /*loop through the chunks, ignoring unknown chunks and stopping at IEND chunk.
@@ -4643,11 +5038,11 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
     /*IDAT chunk, containing compressed image data*/
     if(lodepng_chunk_type_equals(chunk, "IDAT"))
     {
-      size_t oldsize = idat.size;
+      size_t oldsize = idat->size;
       size_t newsize;
       if(lodepng_addofl(oldsize, chunkLength, &newsize)) CERROR_BREAK(state->error, 95);
-      if(!ucvector_resize(&idat, newsize)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
-      for(i = 0; i != chunkLength; ++i) idat.data[oldsize + i] = data[i];
+      if(!ucvector_resize(idat, newsize)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
+      for(i = 0; i != chunkLength; ++i) idat->data[oldsize + i] = data[i];
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
       critical_pos = 3;
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
@@ -4743,27 +5138,58 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 
     if(!IEND) chunk = lodepng_chunk_next_const(chunk);
   }
+}
 
-  ucvector_init(&scanlines);
-  /*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
-  If the decompressed size does not match the prediction, the image must be corrupt.*/
-  if(state->info_png.interlace_method == 0)
+/*predicts the size of the decompressed IDAT data: the scanlines with their filter bytes*/
+static size_t predictScanlinesSize(unsigned w, unsigned h, const LodePNGInfo* info_png)
+{
+  size_t predict;
+  if(info_png->interlace_method == 0)
   {
-    predict = lodepng_get_raw_size_idat(*w, *h, &state->info_png.color);
+    predict = lodepng_get_raw_size_idat(w, h, &info_png->color);
   }
   else
   {
     /*Adam-7 interlaced: predicted size is the sum of the 7 sub-images sizes*/
-    const LodePNGColorMode* color = &state->info_png.color;
+    const LodePNGColorMode* color = &info_png->color;
     predict = 0;
-    predict += lodepng_get_raw_size_idat((*w + 7) >> 3, (*h + 7) >> 3, color);
-    if(*w > 4) predict += lodepng_get_raw_size_idat((*w + 3) >> 3, (*h + 7) >> 3, color);
-    predict += lodepng_get_raw_size_idat((*w + 3) >> 2, (*h + 3) >> 3, color);
-    if(*w > 2) predict += lodepng_get_raw_size_idat((*w + 1) >> 2, (*h + 3) >> 2, color);
-    predict += lodepng_get_raw_size_idat((*w + 1) >> 1, (*h + 1) >> 2, color);
-    if(*w > 1) predict += lodepng_get_raw_size_idat((*w + 0) >> 1, (*h + 1) >> 1, color);
-    predict += lodepng_get_raw_size_idat((*w + 0), (*h + 0) >> 1, color);
+    predict += lodepng_get_raw_size_idat((w + 7) >> 3, (h + 7) >> 3, color);
+    if(w > 4) predict += lodepng_get_raw_size_idat((w + 3) >> 3, (h + 7) >> 3, color);
+    predict += lodepng_get_raw_size_idat((w + 3) >> 2, (h + 3) >> 3, color);
+    if(w > 2) predict += lodepng_get_raw_size_idat((w + 1) >> 2, (h + 3) >> 2, color);
+    predict += lodepng_get_raw_size_idat((w + 1) >> 1, (h + 1) >> 2, color);
+    if(w > 1) predict += lodepng_get_raw_size_idat((w + 0) >> 1, (h + 1) >> 1, color);
+    predict += lodepng_get_raw_size_idat((w + 0), (h + 0) >> 1, color);
   }
+  return predict;
+}
+
+/*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
+static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
+                          LodePNGState* state,
+                          const unsigned char* in, size_t insize)
+{
+  size_t i;
+  ucvector idat; /*the data from idat chunks*/
+  ucvector scanlines;
+  size_t predict;
+  size_t outsize = 0;
+
+  /*provide some proper output values if error will happen*/
+  *out = 0;
+
+  ucvector_init(&idat);
+  readChunks(&idat, w, h, state, in, insize);
+  if(state->error)
+  {
+    ucvector_cleanup(&idat);
+    return;
+  }
+
+  ucvector_init(&scanlines);
+  /*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
+  If the decompressed size does not match the prediction, the image must be corrupt.*/
+  predict = predictScanlinesSize(*w, *h, &state->info_png);
   if(!state->error && !ucvector_reserve(&scanlines, predict)) state->error = 83; /*alloc fail*/
   if(!state->error)
   {
@@ -4787,11 +5213,292 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
   ucvector_cleanup(&scanlines);
 }
 
+#ifdef LODEPNG_COMPILE_THREADS
+/*
+Pipelined decoding of non-interlaced images, used by lodepng_decode when
+decoder.num_threads is more than 1. The stages overlap:
+*) the calling thread inflates the IDAT data, reporting its progress every 64 KiB
+*) a second thread unfilters every scanline as soon as it is complete
+*) if a color conversion is needed, the other threads convert bands of rows that
+   are completely unfiltered, in parallel
+Bands are a multiple of 8 rows, so each band starts at a byte even with pixels
+smaller than a byte, and no two stages ever write the same byte.
+The result, including the error code, is the same as with the serial decoder: the
+inflater always runs to the end, and its errors come before those of the unfiltering,
+which come before those of the conversion.
+*/
+struct DecodePipeline
+{
+  std::mutex mutex;
+  std::condition_variable changed;
+  unsigned error; /*error of the inflate or unfilter stage, the unfilter and conversion stages stop when it is set*/
+
+  /*inflate stage*/
+  const unsigned char* scanlines; /*stable until overflow: the buffer is reserved so that it doesn't move before*/
+  size_t inflated; /*bytes of scanlines available*/
+  size_t predict;
+  unsigned inflate_done;
+  unsigned overflow; /*the inflater went past predict, it no longer reports*/
+
+  /*unfilter stage*/
+  unsigned rows_unfiltered;
+  unsigned unfilter_done;
+
+  /*conversion stage*/
+  unsigned next_band;
+  unsigned convert_error;
+};
+
+static unsigned pipelineReportInflated(void* context, const unsigned char* data, size_t size)
+{
+  DecodePipeline* p = (DecodePipeline*)context;
+  std::unique_lock<std::mutex> lock(p->mutex);
+  if(p->overflow) return 0;
+  if(size > p->predict)
+  {
+    /*More data than the image has: it is corrupt, but as in the serial decoder the inflater
+    goes on, and may still end with its own error or a wrong checksum. The scanlines are all
+    there, so let the unfilter stage finish with them before the buffer can be reallocated.*/
+    p->scanlines = data;
+    p->inflated = p->predict;
+    p->overflow = 1;
+    p->changed.notify_all();
+    while(!p->unfilter_done) p->changed.wait(lock);
+    return 0;
+  }
+  p->scanlines = data;
+  p->inflated = size;
+  p->changed.notify_all();
+  return 0;
+}
+
+static void pipelineUnfilter(DecodePipeline* p, unsigned char* raw,
+                             unsigned w, unsigned h, unsigned bpp, unsigned band_rows)
+{
+  size_t bytewidth = (bpp + 7) / 8;
+  size_t linebits = (size_t)w * bpp;
+  size_t linebytes = (linebits + 7) / 8;
+  /*rows that don't end at a byte are unfiltered into a temporary row, then their padding bits removed*/
+  unsigned padded = linebits != linebytes * 8;
+  std::vector<unsigned char> rows(padded ? 2 * linebytes : 0);
+  const unsigned char* prevline = 0;
+  const unsigned char* in = 0;
+  size_t available = 0;
+  unsigned y, error = 0;
+
+  for(y = 0; y < h; ++y)
+  {
+    size_t inindex = (1 + linebytes) * y;
+    size_t inend = inindex + 1 + linebytes;
+    unsigned char* recon;
+    if(inend > available)
+    {
+      std::unique_lock<std::mutex> lock(p->mutex);
+      while(!p->error && !p->inflate_done && p->inflated < inend) p->changed.wait(lock);
+      /*if the data ended early, the inflate stage reports the error*/
+      if(p->error || p->inflated < inend) break;
+      in = p->scanlines;
+      available = p->inflated;
+    }
+
+    recon = padded ? &rows[(y & 1) * linebytes] : &raw[linebytes * y];
+    error = unfilterScanline(recon, &in[inindex + 1], prevline, bytewidth, in[inindex], linebytes);
+    if(error) break;
+    if(padded)
+    {
+      size_t x, ibp = 0, obp = linebits * y;
+      /*raw is zeroed, see setBitOfReversedStream0*/
+      for(x = 0; x < linebits; ++x) setBitOfReversedStream0(&obp, raw, readBitFromReversedStream(&ibp, recon));
+    }
+    prevline = recon;
+
+    if((y + 1) % band_rows == 0 || y + 1 == h)
+    {
+      std::lock_guard<std::mutex> lock(p->mutex);
+      p->rows_unfiltered = y + 1;
+      p->changed.notify_all();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(p->mutex);
+  if(error && !p->error) p->error = error;
+  p->unfilter_done = 1;
+  p->changed.notify_all();
+}
+
+static void pipelineConvert(DecodePipeline* p, unsigned char* out, const unsigned char* raw,
+                            const LodePNGColorMode* mode_out, const LodePNGColorMode* mode_in,
+                            unsigned w, unsigned h, unsigned band_rows)
+{
+  size_t outbpp = lodepng_get_bpp(mode_out);
+  size_t inbpp = lodepng_get_bpp(mode_in);
+  for(;;)
+  {
+    unsigned start, rows, error;
+    {
+      std::unique_lock<std::mutex> lock(p->mutex);
+      start = p->next_band * band_rows;
+      if(p->error || p->convert_error || start >= h) return;
+      ++p->next_band;
+      rows = h - start < band_rows ? h - start : band_rows;
+      while(!p->error && !p->unfilter_done && p->rows_unfiltered < start + rows) p->changed.wait(lock);
+      if(p->error || p->rows_unfiltered < start + rows) return;
+    }
+    /*start is a multiple of 8 rows, so both offsets are whole bytes*/
+    error = lodepng_convert(out + (size_t)start * w * outbpp / 8, raw + (size_t)start * w * inbpp / 8,
+                            mode_out, mode_in, w, rows);
+    if(error)
+    {
+      /*only the conversion stops: an unfilter error of a later row takes precedence, as in the serial decoder*/
+      std::lock_guard<std::mutex> lock(p->mutex);
+      if(!p->convert_error) p->convert_error = error;
+      return;
+    }
+  }
+}
+
+static unsigned decodePipelined(unsigned char** out, unsigned* w, unsigned* h,
+                                LodePNGState* state,
+                                const unsigned char* in, size_t insize)
+{
+  DecodePipeline p;
+  ucvector idat, scanlines;
+  InflateProgress progress;
+  unsigned char* raw = 0;
+  unsigned convert, supported, band_rows, converters, i;
+  unsigned error = 0;
+  std::vector<std::thread> threads;
+
+  ucvector_init(&idat);
+  readChunks(&idat, w, h, state, in, insize);
+  if(state->error)
+  {
+    ucvector_cleanup(&idat);
+    return state->error;
+  }
+
+  convert = state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+  /*an unsupported conversion is only reported once the image decoded, as in the serial decoder*/
+  supported = state->info_raw.colortype == LCT_RGB || state->info_raw.colortype == LCT_RGBA
+              || state->info_raw.bitdepth == 8;
+  if(!supported) convert = 0;
+
+  p.error = 0;
+  p.scanlines = 0;
+  p.inflated = 0;
+  p.predict = predictScanlinesSize(*w, *h, &state->info_png);
+  p.inflate_done = 0;
+  p.overflow = 0;
+  p.rows_unfiltered = 0;
+  p.unfilter_done = 0;
+  p.next_band = 0;
+  p.convert_error = 0;
+
+  /*Room for the largest overshoot before a report can stop the other stages (a stored block),
+  so the buffer the unfilter stage reads never moves under it.*/
+  ucvector_init(&scanlines);
+  if(!ucvector_reserve(&scanlines, p.predict + 65536 + 1024)) error = 83; /*alloc fail*/
+
+  if(!error)
+  {
+    size_t rawsize = lodepng_get_raw_size(*w, *h, &state->info_png.color);
+    raw = (unsigned char*)lodepng_malloc(rawsize);
+    if(!raw) error = 83; /*alloc fail*/
+    else memset(raw, 0, rawsize);
+  }
+  if(!error && convert)
+  {
+    *out = (unsigned char*)lodepng_malloc(lodepng_get_raw_size(*w, *h, &state->info_raw));
+    if(!*out) error = 83; /*alloc fail*/
+  }
+  if(error)
+  {
+    lodepng_free(raw);
+    ucvector_cleanup(&scanlines);
+    ucvector_cleanup(&idat);
+    state->error = error;
+    return error;
+  }
+
+  /*about 4 bands per converting thread, for balance*/
+  converters = convert ? LODEPNG_MAX(1u, state->decoder.num_threads - 2u) : 0;
+  band_rows = *h / (4 * LODEPNG_MAX(1u, converters));
+  band_rows = LODEPNG_MAX(8u, (band_rows + 7u) & ~7u);
+
+  threads.push_back(std::thread(pipelineUnfilter, &p, raw, *w, *h,
+                                lodepng_get_bpp(&state->info_png.color), band_rows));
+  for(i = 0; i != converters; ++i)
+  {
+    threads.push_back(std::thread(pipelineConvert, &p, *out, raw, &state->info_raw,
+                                  &state->info_png.color, *w, *h, band_rows));
+  }
+
+  /*same checks in the same order as zlib_decompress and decodeGeneric*/
+  progress.report = pipelineReportInflated;
+  progress.context = &p;
+  progress.step = 65536;
+  progress.limit = p.predict;
+  progress.next = 0;
+  error = readZlibHeader(idat.data, idat.size);
+  if(!error) error = lodepng_inflatev(&scanlines, idat.data + 2, idat.size - 2, &state->decoder.zlibsettings, &progress);
+  if(!error && !state->decoder.zlibsettings.ignore_adler32)
+  {
+    unsigned ADLER32 = lodepng_read32bitInt(&idat.data[idat.size - 4]);
+    unsigned checksum = adler32(scanlines.data, (unsigned)scanlines.size);
+    if(checksum != ADLER32) error = 58; /*error, adler checksum not correct, data must be corrupted*/
+  }
+  if(!error && scanlines.size != p.predict) error = 91; /*decompressed size doesn't match prediction*/
+  {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    if(error) p.error = error;
+    p.inflate_done = 1;
+    p.changed.notify_all();
+  }
+
+  for(i = 0; i != threads.size(); ++i) threads[i].join();
+  error = p.error ? p.error : p.convert_error;
+  ucvector_cleanup(&scanlines);
+  ucvector_cleanup(&idat);
+
+  if(convert) lodepng_free(raw);
+  else *out = raw;
+  if(error)
+  {
+    lodepng_free(*out);
+    *out = 0;
+    state->error = error;
+    return error;
+  }
+  /*as in lodepng_decode: the unconverted image is returned, without setting state->error*/
+  if(!supported && state->decoder.color_convert
+     && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color)) return 56;
+  if(!state->decoder.color_convert)
+  {
+    /*as in lodepng_decode: info_raw reflects the colortype of the returned image*/
+    state->error = lodepng_color_mode_copy(&state->info_raw, &state->info_png.color);
+  }
+  return state->error;
+}
+#endif /*LODEPNG_COMPILE_THREADS*/
+
 unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
                         LodePNGState* state,
                         const unsigned char* in, size_t insize)
 {
   *out = 0;
+#ifdef LODEPNG_COMPILE_THREADS
+  if(state->decoder.num_threads > 1 && !state->decoder.zlibsettings.custom_zlib
+     && !state->decoder.zlibsettings.custom_inflate)
+  {
+    /*only non-interlaced images have scanlines that are final as soon as they are inflated*/
+    state->error = lodepng_inspect(w, h, state, in, insize);
+    if(state->error) return state->error;
+    if(state->info_png.interlace_method == 0)
+    {
+      return decodePipelined(out, w, h, state, in, insize);
+    }
+  }
+#endif /*LODEPNG_COMPILE_THREADS*/
   decodeGeneric(out, w, h, state, in, insize);
   if(state->error) return state->error;
   if(!state->decoder.color_convert || lodepng_color_mode_equal(&state->info_raw, &state->info_png.color))
@@ -4889,6 +5596,7 @@ void lodepng_decoder_settings_init(LodePNGDecoderSettings* settings)
   settings->ignore_crc = 0;
   settings->ignore_critical = 0;
   settings->ignore_end = 0;
+  settings->num_threads = 0;
   lodepng_decompress_settings_init(&settings->zlibsettings);
 }
 
@@ -5706,9 +6414,9 @@ static unsigned addUnknownChunks(ucvector* out, unsigned char* data, size_t data
 }
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-unsigned lodepng_encode(unsigned char** out, size_t* outsize,
-                        const unsigned char* image, unsigned w, unsigned h,
-                        LodePNGState* state)
+static unsigned lodepng_encode_impl(unsigned char** out, size_t* outsize,
+                                    const unsigned char* image, unsigned w, unsigned h,
+                                    LodePNGState* state)
 {
   LodePNGInfo info;
   ucvector outv;
@@ -5948,6 +6656,26 @@ unsigned lodepng_encode24_file(const char* filename, const unsigned char* image,
 }
 #endif /*LODEPNG_COMPILE_DISK*/
 
+unsigned lodepng_encode(unsigned char** out, size_t* outsize,
+                        const unsigned char* image, unsigned w, unsigned h,
+                        LodePNGState* state)
+{
+#ifdef LODEPNG_COMPILE_ALLOCATORS
+  unsigned error;
+  LodePNGArena* previous = lodepng_current_arena;
+  if(state->encoder.arena)
+  {
+    lodepng_arena_reset(state->encoder.arena);
+    lodepng_current_arena = state->encoder.arena;
+  }
+  error = lodepng_encode_impl(out, outsize, image, w, h, state);
+  lodepng_current_arena = previous;
+  return error;
+#else /*LODEPNG_COMPILE_ALLOCATORS*/
+  return lodepng_encode_impl(out, outsize, image, w, h, state);
+#endif /*LODEPNG_COMPILE_ALLOCATORS*/
+}
+
 void lodepng_encoder_settings_init(LodePNGEncoderSettings* settings)
 {
   lodepng_compress_settings_init(&settings->zlibsettings);
@@ -5956,6 +6684,7 @@ void lodepng_encoder_settings_init(LodePNGEncoderSettings* settings)
   settings->auto_convert = 1;
   settings->force_palette = 0;
   settings->predefined_filters = 0;
+  settings->arena = 0;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
   settings->add_id = 0;
   settings->text_compression = 1;
@@ -6170,6 +6899,18 @@ State& State::operator=(const State& other)
   return *this;
 }
 
+#ifdef LODEPNG_COMPILE_ENCODER
+Arena::Arena()
+{
+  lodepng_arena_init(this);
+}
+
+Arena::~Arena()
+{
+  lodepng_arena_cleanup(this);
+}
+#endif /*LODEPNG_COMPILE_ENCODER*/
+
 #ifdef LODEPNG_COMPILE_DECODER
 
 unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h, const unsigned char* in,
@@ -6262,7 +7003,8 @@ unsigned encode(std::vector<unsigned char>& out,
   if(buffer)
   {
     out.insert(out.end(), &buffer[0], &buffer[buffersize]);
-    lodepng_free(buffer);
+    /*with an arena, the buffer lives in the arena until the next encode*/
+    if(!state.encoder.arena) lodepng_free(buffer);
   }
   return error;
 }
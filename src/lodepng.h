@@ -81,6 +81,13 @@ source files with custom allocators.*/
 #endif
 #endif
 
+/*multithreaded pipelined decoding, see num_threads in LodePNGDecoderSettings. Needs C++11 threads.*/
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#ifndef LODEPNG_NO_COMPILE_THREADS
+#define LODEPNG_COMPILE_THREADS
+#endif
+#endif
+
 #ifdef LODEPNG_COMPILE_CPP
 #include <vector>
 #include <string>
@@ -528,6 +535,13 @@ typedef struct LodePNGDecoderSettings
 
   unsigned color_convert; /*whether to convert the PNG to the color type you want. Default: yes*/
 
+  /*Threads used to decode a non-interlaced PNG: with more than 1, inflate, unfilter and
+  color conversion run as a pipeline on separate threads, with the conversion split in
+  bands over num_threads - 2 threads. 0 or 1 decodes on the calling thread. The image and
+  the error code are the same either way, also for corrupt files. Only has an effect when
+  compiled with LODEPNG_COMPILE_THREADS. Default: 0*/
+  unsigned num_threads;
+
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
   unsigned read_text_chunks; /*if false but remember_unknown_chunks is true, they're stored in the unknown chunks*/
   /*store all bytes from unknown chunks in the LodePNGInfo (off by default, useful for a png editor)*/
@@ -585,6 +599,34 @@ unsigned lodepng_auto_choose_color(LodePNGColorMode* mode_out,
                                    const unsigned char* image, unsigned w, unsigned h,
                                    const LodePNGColorMode* mode_in);
 
+/*
+Reusable scratch memory for the encoder. When LodePNGEncoderSettings.arena points
+to an arena, every allocation made by lodepng_encode (filtered scanlines, LZ77
+symbols, hash tables, chunk output, ...) is served from it instead of the heap.
+The arena is reset at the start of each encode, so after the first frame,
+encoding images of the same size performs no heap allocations.
+
+The output buffer of lodepng_encode then also lives in the arena: it stays valid
+until the next encode that uses the same arena, and must NOT be freed by the
+caller. The C++ lodepng::encode wrapper copies it out and handles this.
+
+The arena is only used with the built-in allocators (LODEPNG_COMPILE_ALLOCATORS),
+and must not be shared by encodes running concurrently on different threads.
+*/
+typedef struct LodePNGArenaBlock LodePNGArenaBlock;
+typedef struct LodePNGArena
+{
+  LodePNGArenaBlock* blocks; /*most recent block first*/
+  size_t used; /*bytes handed out since the last reset*/
+  size_t high_water; /*largest value of used so far*/
+  size_t heap_allocations; /*number of blocks ever obtained from the heap*/
+} LodePNGArena;
+
+void lodepng_arena_init(LodePNGArena* arena);
+void lodepng_arena_cleanup(LodePNGArena* arena);
+/*Reclaims all memory handed out so far. Called by lodepng_encode itself.*/
+void lodepng_arena_reset(LodePNGArena* arena);
+
 /*Settings for the encoder.*/
 typedef struct LodePNGEncoderSettings
 {
@@ -609,6 +651,9 @@ typedef struct LodePNGEncoderSettings
   /*force creating a PLTE chunk if colortype is 2 or 6 (= a suggested palette).
   If colortype is 3, PLTE is _always_ created.*/
   unsigned force_palette;
+
+  /*optional scratch arena for all allocations made while encoding, not owned. Default: NULL*/
+  LodePNGArena* arena;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
   /*add LodePNG identifier and version as a text chunk, for debugging*/
   unsigned add_id;
@@ -830,6 +875,19 @@ class State : public LodePNGState
     State& operator=(const State& other);
 };
 
+#ifdef LODEPNG_COMPILE_ENCODER
+/* A LodePNGArena that is cleaned up on destruction. Set state.encoder.arena to use it. */
+class Arena : public LodePNGArena
+{
+  public:
+    Arena();
+    ~Arena();
+  private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+};
+#endif /*LODEPNG_COMPILE_ENCODER*/
+
 #ifdef LODEPNG_COMPILE_DECODER
 /* Same as other lodepng::decode, but using a State for more settings and information. */
 unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h,
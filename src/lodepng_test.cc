@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Checks of the changes made to the bundled lodepng, on streams the encoder
+ * never produces.
+ *
+ *   lodepng_test
+ *     decodes corrupt deflate streams and checks the error codes, then checks
+ *     that the threaded PNG decoder returns the same image and error code as
+ *     the serial one on damaged files; exits with a non-zero status if any
+ *     check fails.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "lodepng.h"
+
+namespace {
+
+/* Deflate bit stream: values lowest bit first, Huffman codes highest first. */
+class BitWriter {
+ public:
+  void Bits(unsigned value, unsigned count) {
+    for (unsigned i = 0; i < count; ++i) {
+      Bit((value >> i) & 1);
+    }
+  }
+
+  void Code(unsigned code, unsigned length) {
+    for (unsigned i = length; i-- > 0;) {
+      Bit((code >> i) & 1);
+    }
+  }
+
+  /* Room for the decoder to read ahead of the end of the block. */
+  std::vector<unsigned char> Finish() const {
+    std::vector<unsigned char> bytes = bytes_;
+    bytes.resize(bytes.size() + 64, 0);
+    return bytes;
+  }
+
+ private:
+  void Bit(unsigned bit) {
+    if (position_ % 8 == 0) {
+      bytes_.push_back(0);
+    }
+    bytes_.back() |= bit << (position_ % 8);
+    ++position_;
+  }
+
+  std::vector<unsigned char> bytes_;
+  size_t position_ = 0;
+};
+
+/*
+ * The header of a dynamic block whose literal/length code lengths are given
+ * and whose single distance code has length 1. The code lengths are themselves
+ * coded with 2-bit codes for the lengths 0, 1, 8 and 10, the only ones allowed.
+ */
+void DynamicHeader(BitWriter *out, const std::vector<unsigned> &lengths) {
+  static const unsigned kOrder[19] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                      11, 4,  12, 3, 13, 2, 14, 1, 15};
+  out->Bits(1, 1);  // BFINAL
+  out->Bits(2, 2);  // BTYPE: dynamic Huffman codes
+  out->Bits(unsigned(lengths.size()) - 257, 5);
+  out->Bits(0, 5);   // one distance code
+  out->Bits(15, 4);  // all 19 code length code lengths
+  for (unsigned symbol : kOrder) {
+    bool used = symbol == 0 or symbol == 1 or symbol == 8 or symbol == 10;
+    out->Bits(used ? 2 : 0, 3);
+  }
+  /* Canonical codes of the code length alphabet: 0, 1, 8, 10 in order. */
+  auto code = [out](unsigned length) {
+    out->Code(length == 0 ? 0 : length == 1 ? 1 : length == 8 ? 2 : 3, 2);
+  };
+  for (unsigned length : lengths) {
+    code(length);
+  }
+  code(1);
+}
+
+bool Expect(const char *name, const std::vector<unsigned char> &stream,
+            unsigned expected) {
+  unsigned char *out = nullptr;
+  size_t outsize = 0;
+  unsigned error = lodepng_inflate(&out, &outsize, stream.data(),
+                                   stream.size(),
+                                   &lodepng_default_decompress_settings);
+  free(out);
+  bool passed = error == expected;
+  std::cout << name << ": error " << error << " (expected " << expected
+            << ")" << (passed ? "" : " FAIL") << std::endl;
+  return passed;
+}
+
+/*
+ * Literal/length codes: 255 of 8 bits leave room for 4 codes of 10 bits, which
+ * the 29 length symbols oversubscribe. Their codes wrap around and overlap each
+ * other and the short codes, so the tree must be rejected as oversubscribed.
+ */
+bool OverlappingLongCodes() {
+  std::vector<unsigned> lengths(286, 0);
+  for (unsigned symbol = 0; symbol < 254; ++symbol) {
+    lengths[symbol] = 8;
+  }
+  lengths[256] = 8;
+  for (unsigned symbol = 257; symbol < 286; ++symbol) {
+    lengths[symbol] = 10;
+  }
+  BitWriter overlapping;
+  DynamicHeader(&overlapping, lengths);
+  bool passed = Expect("overlapping long codes", overlapping.Finish(), 55);
+
+  /*
+   * The same tree with only the 4 long codes that fit is complete, and decodes
+   * a block holding a literal, the longest code and the end code.
+   */
+  for (unsigned symbol = 261; symbol < 286; ++symbol) {
+    lengths[symbol] = 0;
+  }
+  BitWriter complete;
+  DynamicHeader(&complete, lengths);
+  complete.Code(7, 8);      // literal 7
+  complete.Code(1020, 10);  // length 3 (symbol 257)
+  complete.Code(0, 1);      // distance 1
+  complete.Code(254, 8);    // end of block (symbol 256)
+  return Expect("complete tree", complete.Finish(), 0) and passed;
+}
+
+std::vector<unsigned char> Encode(unsigned width, unsigned height,
+                                  LodePNGColorType type, unsigned depth) {
+  lodepng::State state;
+  state.info_raw.colortype = state.info_png.color.colortype = type;
+  state.info_raw.bitdepth = state.info_png.color.bitdepth = depth;
+  state.encoder.auto_convert = 0;
+  if (type == LCT_PALETTE) {
+    for (unsigned i = 0; i < 1u << depth; ++i) {
+      lodepng_palette_add(&state.info_png.color, i * 7, i * 13, i * 31, 255);
+      lodepng_palette_add(&state.info_raw, i * 7, i * 13, i * 31, 255);
+    }
+  }
+  std::vector<unsigned char> pixels(
+      (size_t(width) * height * lodepng_get_bpp(&state.info_raw) + 7) / 8);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = (unsigned char)((i * 2654435761u >> 13) % 7 * 37 + i / 97 % 3);
+  }
+  std::vector<unsigned char> png;
+  lodepng::encode(png, pixels, width, height, state);
+  return png;
+}
+
+unsigned Decode(const std::vector<unsigned char> &png, unsigned threads,
+                LodePNGColorType type, unsigned depth,
+                std::vector<unsigned char> *image) {
+  lodepng::State state;
+  state.info_raw.colortype = type;
+  state.info_raw.bitdepth = depth;
+  state.decoder.num_threads = threads;
+  state.decoder.ignore_crc = 1;  // so that damaged IDAT data reaches inflate
+  unsigned width, height;
+  image->clear();
+  return lodepng::decode(*image, width, height, state, png);
+}
+
+/*
+ * Damaged copies of a few images (flipped bits, truncation), decoded to a
+ * supported and an unsupported (16-bit grey) color type.
+ */
+bool ThreadedDecodeMatchesSerial() {
+  const struct {
+    unsigned width, height;
+    LodePNGColorType type;
+    unsigned depth;
+  } kImages[] = {{333, 257, LCT_RGBA, 8},
+                 {1000, 91, LCT_PALETTE, 4},
+                 {7, 1000, LCT_GREY, 1}};
+  const struct {
+    LodePNGColorType type;
+    unsigned depth;
+  } kOutputs[] = {{LCT_RGBA, 8}, {LCT_GREY, 16}};
+  unsigned cases = 0, differences = 0;
+  srand(1);
+  for (const auto &image : kImages) {
+    std::vector<unsigned char> png =
+        Encode(image.width, image.height, image.type, image.depth);
+    for (unsigned variant = 0; variant < 40; ++variant) {
+      std::vector<unsigned char> damaged = png;
+      if (variant >= 30) {
+        damaged.resize(40 + rand() % (png.size() - 40));
+      } else if (variant > 0) {
+        for (unsigned flip = 0; flip <= variant % 4; ++flip) {
+          damaged[40 + rand() % (png.size() - 52)] ^= 1 << (rand() % 8);
+        }
+      }
+      for (const auto &output : kOutputs) {
+        std::vector<unsigned char> serial, threaded;
+        unsigned serial_error =
+            Decode(damaged, 0, output.type, output.depth, &serial);
+        unsigned threaded_error =
+            Decode(damaged, 4, output.type, output.depth, &threaded);
+        ++cases;
+        if (serial_error != threaded_error or serial != threaded) {
+          ++differences;
+        }
+      }
+    }
+  }
+  bool passed = differences == 0;
+  std::cout << "threaded decoder: " << differences << " of " << cases
+            << " damaged files differ from the serial decoder"
+            << (passed ? "" : " FAIL") << std::endl;
+  return passed;
+}
+
+}  // namespace
+
+int main() {
+  bool passed = OverlappingLongCodes();
+  passed = ThreadedDecodeMatchesSerial() and passed;
+  std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -20,29 +20,318 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vulkan/vulkan.hpp>
+#include "async_log.h"
+#include "cpu_renderer.h"
+#include "device_memory.h"
+#include "device_profile.h"
+#include "distributed.h"
+#include "frame_ring.h"
+#include "image_writers.h"
+#include "kernels.h"
 #include "lodepng.h"
 #include "vulkan_ext.h"
+#include "warm_up.h"
 
 using namespace std::string_literals;
 
 const char *kAppShortName = "Mandelbrot";
 
+/* A pixel of the image buffer, as packUnorm4x8 stores it (little-endian). */
 struct Pixel {
-  float r, g, b, a;
+  unsigned char r, g, b, a;
+};
+
+/* Mirrors `struct Tile` in shaders/tiles.comp (std430). */
+struct TileDescriptor {
+  float min_x, min_y;
+  float span_x, span_y;
+  uint32_t width, height;
+  uint32_t max_iterations;
+  uint32_t output_offset;
+};
+
+/* Mirrors the push constants of shaders/shader.comp. */
+struct FloatView {
+  float corner_x, corner_y;
+  float span_x, span_y;
+};
+
+/*
+ * Mirrors the push constants of shaders/fixed128.comp: 128-bit fixed point
+ * with 120 fractional bits, low word first.
+ */
+struct Fixed128View {
+  uint64_t min_x[2], min_y[2];
+  uint64_t step_x[2], step_y[2];
 };
 
 const int kWidth = 3200;
 const int kHeight = 2400;
-const int kWorkgroupSize = 32;
-const size_t buffer_size = sizeof(Pixel) * kWidth * kHeight;
+
+/* The default view rendered by shaders/shader.comp. */
+const float kViewSpan = 2.0f + 1.7f * 0.2f;
+const float kViewMinX = -0.445f - 0.5f * kViewSpan;
+const float kViewMinY = 0.0f - 0.5f * kViewSpan;
+
+/* Span of the default view of the other fractal families, which are larger. */
+const double kFamilyViewSpan = 3.4;
+
+/* value, |value| < 128, as the two words of a Fixed128View number. */
+void ToFixed128(double value, uint64_t words[2]) {
+  /* The high word holds value's bits down to 2^-56, the low word the rest. */
+  double high = std::floor(std::ldexp(value, 56));
+  words[1] = static_cast<uint64_t>(static_cast<int64_t>(high));
+  words[0] = static_cast<uint64_t>(
+      std::ldexp(value - std::ldexp(high, -56), 120));
+}
+
+/* Frames kept in the shared-memory ring, so consumers can lag a little. */
+const unsigned kFrameRingSlots = 3;
 
 const char kValidationLayer[] = "VK_LAYER_LUNARG_standard_validation";
 const char kDebugReportExtension[] = "VK_EXT_debug_report";
+const char kPhysicalDeviceProperties2Extension[] =
+    "VK_KHR_get_physical_device_properties2";
+const char kPushDescriptorExtension[] = "VK_KHR_push_descriptor";
+const char kMemoryBudgetExtension[] = "VK_EXT_memory_budget";
+
+/* Descriptor sets preallocated for devices without push descriptors. */
+const uint32_t kPooledDescriptorSets = 8;
+
+/*
+ * Storage buffer bindings of the one descriptor set layout all kernels
+ * share; a kernel may use fewer. A single layout lets every pipeline be
+ * created at startup, before the job that binds its buffers.
+ */
+const uint32_t kStorageBufferBindings = 3;
+
+/*
+ * Workgroups of the histogram pass. Each one strides over the whole image,
+ * so a few hundred keep the device busy while their flushes of shared bins
+ * into the global histogram stay cheap.
+ */
+const uint32_t kHistogramWorkgroups = 256;
+
+/*
+ * Largest --supersample: 16 samples per pixel, which takes the counts of
+ * histogram coloring to 64 bytes per pixel, more than many devices can bind
+ * (see CheckHistogramCountsSize()).
+ */
+const uint32_t kMaxSupersampling = 4;
+
+/* The passes of histogram coloring, in the order they are recorded. */
+const kernels::Pass kHistogramPasses[] = {
+    kernels::Pass::kHistogram, kernels::Pass::kPrefixSum,
+    kernels::Pass::kColorize};
+
+/*
+ * kDebug enables the validation layers and reports every driver and layer
+ * message synchronously. kProduction skips validation and hands warnings
+ * and errors to a background logger, rate-limited per message ID.
+ */
+enum class Profile { kDebug, kProduction };
+
+struct Options {
+  Profile profile = Profile::kDebug;
+
+  /* When non-zero, render the view as a grid of tiles in a single batch. */
+  uint32_t tile_columns = 0;
+  uint32_t tile_rows = 0;
+
+  /* Output file ("-" for stdout) and its format. */
+  std::string output = "mandelbrot.png";
+  image_writers::Format format = image_writers::Format::kPng;
+
+  /* Time every output format on the rendered frame. */
+  bool benchmark_writers = false;
+
+  /* Compare loader and device-table call overhead on the rendered frame. */
+  bool benchmark_submit = false;
+
+  /* Options compiled into the kernel's pipeline; see kernels.h. */
+  kernels::Specialization specialization;
+
+  /*
+   * Threads creating pipelines in the background from startup on; 0 creates
+   * each one when a job first needs it. The job's own pipeline is always
+   * started first; warm_up_variants adds every other combination of
+   * coloring and early-outs, for every kernel.
+   */
+  unsigned warm_up_threads = std::thread::hardware_concurrency();
+  bool warm_up_variants = false;
+
+  /* Start up, wait for the pipelines and report their readiness only. */
+  bool health_check = false;
+
+  /* Report device memory blocks and sub-allocations after the render. */
+  bool memory_stats = false;
+
+  /*
+   * Share of the memory heap's budget a tiled render may fill, less what
+   * is in use already; the tiles are rendered in batches that fit.
+   */
+  double memory_fraction = 0.8;
+
+  /* Use VK_KHR_push_descriptor for buffer bindings when available. */
+  bool push_descriptors = true;
+
+  /*
+   * Device profile file: read to skip enumerating the installation, or
+   * written after probing it. Empty to always probe.
+   */
+  std::string device_profile;
+
+  /* Report how long each startup step takes. */
+  bool startup_timing = false;
+
+  /*
+   * Shared-memory ring to publish the frame to (see frame_ring.h). The file
+   * is then only written if --output was given as well.
+   */
+  std::string shm_name;
+  bool write_file = true;
+
+  /*
+   * Distributed CPU rendering (see distributed.h): either coordinate a render
+   * of width x height pixels, or work for the coordinator at worker_address.
+   */
+  bool coordinator = false;
+  distributed::CoordinatorOptions coordinator_options;
+  uint32_t width = kWidth, height = kHeight;
+  uint32_t band_rows = 64;
+  std::string worker_address;
+  uint32_t worker_threads = 0;
+
+  /*
+   * View of the image: view_span wide at zoom 1, scaled down zoom times
+   * around the center. Families other than Mandelbrot default to a wider
+   * view of their whole set.
+   */
+  double center_x = kViewMinX + 0.5 * kViewSpan;
+  double center_y = kViewMinY + 0.5 * kViewSpan;
+  double zoom = 1.0;
+  double view_span = kViewSpan;
+
+  /* CPU kernel (see cpu_renderer.h); kAuto picks the precision per job. */
+  cpu_renderer::Precision cpu_precision = cpu_renderer::Precision::kAuto;
+  unsigned cpu_lanes = 0;
+
+  /* Time every CPU kernel on the default view, without touching Vulkan. */
+  bool benchmark_cpu = false;
+
+  /* Check the rendered image against a high-precision CPU render. */
+  bool validate = false;
+};
+
+/* The fractal of options.specialization, for the CPU renderer. */
+cpu_renderer::Fractal CpuFractal(const Options &options) {
+  const auto &specialization = options.specialization;
+  cpu_renderer::Fractal fractal;
+  fractal.family = static_cast<cpu_renderer::Family>(specialization.family);
+  fractal.exponent = specialization.exponent;
+  /* The kernels see the Julia constant as floats. */
+  fractal.julia_x = specialization.julia_x;
+  fractal.julia_y = specialization.julia_y;
+  return fractal;
+}
+
+cpu_renderer::View RenderView(const Options &options) {
+  double span = options.view_span / options.zoom;
+  return {options.center_x - 0.5 * span, options.center_y - 0.5 * span, span,
+          span};
+}
+
+/*
+ * Renders a quarter-size frame of the default view with every precision and
+ * lane count, and reports the throughput in Mpix/s.
+ */
+void BenchmarkCpuKernels(const Options &options) {
+  using cpu_renderer::Precision;
+  const unsigned kBenchWidth = kWidth / 4, kBenchHeight = kHeight / 4;
+  cpu_renderer::View view = {kViewMinX, kViewMinY, kViewSpan, kViewSpan};
+  std::vector<unsigned char> rgba(size_t(kBenchWidth) * kBenchHeight * 4);
+  unsigned max_iterations = options.specialization.max_iterations;
+  std::cerr << "CPU kernel benchmark (" << kBenchWidth << "x" << kBenchHeight
+            << ", " << max_iterations << " iterations, "
+            << cpu_renderer::InstructionSet() << "), Mpix/s by lanes:"
+            << std::endl
+            << "  " << std::setw(14) << std::left << "" << std::right;
+  for (auto lanes : cpu_renderer::kLaneCounts) {
+    std::cerr << std::setw(9) << lanes;
+  }
+  std::cerr << std::endl << std::fixed << std::setprecision(2);
+  for (auto precision :
+       {Precision::kFloat, Precision::kDouble, Precision::kFixed64,
+        Precision::kDoubleDouble, Precision::kFixed128, Precision::kFloat128}) {
+    if (not cpu_renderer::IsAvailable(precision)) {
+      continue;
+    }
+    std::cerr << "  " << std::setw(14) << std::left
+              << cpu_renderer::PrecisionName(precision) << std::right;
+    for (auto lanes : cpu_renderer::kLaneCounts) {
+      auto start = std::chrono::steady_clock::now();
+      cpu_renderer::RenderRows(view, kBenchWidth, kBenchHeight,
+                               max_iterations, 0, kBenchHeight, rgba.data(),
+                               options.worker_threads, precision, lanes,
+                               CpuFractal(options));
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cerr << std::setw(9)
+                << kBenchWidth * kBenchHeight / elapsed.count() / 1e6;
+    }
+    std::cerr << std::endl;
+  }
+  auto view_precision = options.cpu_precision != Precision::kAuto
+                            ? options.cpu_precision
+                            : cpu_renderer::ChoosePrecision(
+                                  RenderView(options), options.width,
+                                  options.height, max_iterations);
+  std::cerr << "A " << options.width << "x" << options.height
+            << " render of the view would use "
+            << cpu_renderer::PrecisionName(view_precision) << "." << std::endl;
+}
+
+void RunDistributed(const Options &options) {
+  if (not options.worker_address.empty()) {
+    distributed::RunWorker(options.worker_address, options.worker_threads);
+    return;
+  }
+  distributed::RenderJob job;
+  job.view = RenderView(options);
+  job.width = options.width;
+  job.height = options.height;
+  job.max_iterations = options.specialization.max_iterations;
+  job.band_rows = options.band_rows;
+  job.precision = options.cpu_precision;
+  job.lanes = options.cpu_lanes;
+  job.fractal = CpuFractal(options);
+  if (job.precision == cpu_renderer::Precision::kAuto) {
+    job.precision = cpu_renderer::ChoosePrecision(
+        job.view, job.width, job.height, job.max_iterations);
+  }
+  std::cerr << "CPU kernel: " << cpu_renderer::PrecisionName(job.precision)
+            << " (" << cpu_renderer::InstructionSet() << ")." << std::endl;
+  distributed::RunCoordinator(job, options.coordinator_options,
+                              options.output);
+}
 
 class MandelbrotApp {
  public:
@@ -50,28 +339,338 @@ class MandelbrotApp {
 
   ~MandelbrotApp() = default;
 
-  void Run() {
-    ProbeInstallation();
-    CreateInstance();
-    RegisterDebugReportCallback();
-    GetPhysicalDevice();
-    FindQueueFamily();
-    CreateLogicalDevice();
-    GetQueue();
+  void Run(const Options &options) {
+    options_ = options;
+    if (options_.profile == Profile::kProduction) {
+      log_.reset(new async_log::Logger(std::cerr));
+    }
+    auto start = std::chrono::steady_clock::now();
+    profile_cached_ = not options_.device_profile.empty() and
+                      device_profile::Load(options_.device_profile, &profile_);
+    if (profile_cached_) {
+      Timed("create instance", &MandelbrotApp::CreateProfiledInstance);
+    } else {
+      Timed("probe installation", &MandelbrotApp::ProbeInstallation);
+      Timed("create instance", &MandelbrotApp::CreateInstance);
+    }
+    Timed("init extensions", &MandelbrotApp::InitExtensions);
+    Timed("debug report", &MandelbrotApp::RegisterDebugReportCallback);
+    if (profile_cached_) {
+      Timed("profiled device", &MandelbrotApp::FindProfiledDevice);
+    }
+    if (not profile_cached_) {
+      Timed("physical device", &MandelbrotApp::GetPhysicalDevice);
+      Timed("queue family", &MandelbrotApp::FindQueueFamily);
+    }
+    Timed("logical device", &MandelbrotApp::CreateLogicalDevice);
+    Timed("get queue", &MandelbrotApp::GetQueue);
+    if (not options_.device_profile.empty() and not profile_cached_) {
+      Timed("save device profile", &MandelbrotApp::SaveDeviceProfile);
+    }
+    Timed("memory allocator", &MandelbrotApp::CreateAllocator);
+    Timed("start pipeline warm-up", &MandelbrotApp::StartPipelineWarmUp);
+    if (options_.health_check) {
+      CheckPipelineHealth();
+      return;
+    }
+    if (options_.startup_timing) {
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cerr << "[startup] total: " << elapsed.count() << " ms (device "
+                << (options_.device_profile.empty()
+                        ? "profile off"
+                        : profile_cached_ ? "profile hit" : "profile miss")
+                << ")" << std::endl;
+    }
+    if (options_.tile_columns > 0) {
+      Timed("render tiles", &MandelbrotApp::RenderTiles);
+    } else {
+      Timed("render image", &MandelbrotApp::RenderImage);
+    }
+    if (options_.startup_timing) {
+      std::cerr << "[startup] " << PipelineHealthReport() << std::endl;
+    }
+    if (options_.memory_stats) {
+      PrintMemoryStats();
+    }
+  }
+
+  /* Runs one step of Run(), reporting its duration with --startup-timing. */
+  void Timed(const char *step_name, void (MandelbrotApp::*step)()) {
+    auto start = std::chrono::steady_clock::now();
+    (this->*step)();
+    if (options_.startup_timing) {
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cerr << "[startup] " << step_name << ": " << elapsed.count()
+                << " ms" << std::endl;
+    }
+  }
+
+  void RenderImage() {
+    buffer_size_ = sizeof(Pixel) * kWidth * kHeight;
     CreateBuffer();
     AllocateDeviceMemory();
-    BindDeviceMemory();
-    CreateDescriptorSetLayout();
-    CreateDescriptorPool();
-    CreateDescriptorSets();
-    ConnectBufferWithDescriptorSets();
-    CreateShaderModule("shaders/comp.spv");
-    CreatePipeline();
+    auto image = vk::DescriptorBufferInfo(*buffer_, 0, buffer_size_);
+    if (options_.specialization.histogram) {
+      CreateHistogramBuffers();
+      BindBuffers({image,
+                   vk::DescriptorBufferInfo(*counts_buffer_, 0, VK_WHOLE_SIZE),
+                   vk::DescriptorBufferInfo(*histogram_buffer_, 0,
+                                            VK_WHOLE_SIZE)});
+    } else {
+      /*
+       * The kernel only writes counts with histogram coloring, but the
+       * binding is still statically used, so it must be valid.
+       */
+      BindBuffers({image, image});
+    }
+    const auto &kernel = kernels::Find(JobFeatures());
+    pipeline_ = Pipeline(kernel, options_.specialization);
+    if (options_.specialization.histogram) {
+      histogram_passes_.clear();
+      for (auto pass : kHistogramPasses) {
+        histogram_passes_.push_back(
+            Pipeline(kernels::Find(HistogramPassFeatures(pass)),
+                     options_.specialization));
+      }
+    }
+    SetViewPushConstants(kernel.features.precision);
     CreateCommandPool();
     CreateCommandBuffers();
-    FillCommandBuffer();
+    FillCommandBuffer(
+        (uint32_t)std::ceil(kWidth / float(kernel.workgroup_size)),
+        (uint32_t)std::ceil(kHeight / float(kernel.workgroup_size)), 1);
     SubmitAndWait();
-    SaveRenderedImage("mandelbrot.png");
+    if (options_.validate) {
+      ValidateImage(kernel);
+    }
+    if (not options_.shm_name.empty()) {
+      PublishRenderedImage();
+    }
+    if (options_.write_file) {
+      SaveRenderedImage(options_.output);
+    }
+    if (options_.benchmark_writers) {
+      BenchmarkWriters();
+    }
+    if (options_.benchmark_submit) {
+      BenchmarkSubmit();
+    }
+  }
+
+  /* The view of the image, in the kernel's arithmetic. */
+  void SetViewPushConstants(kernels::Precision precision) {
+    auto view = RenderView(options_);
+    if (precision == kernels::Precision::kFloat) {
+      FloatView constants = {float(view.min_x), float(view.min_y),
+                             float(view.span_x), float(view.span_y)};
+      push_constants_.assign(reinterpret_cast<const char *>(&constants),
+                             reinterpret_cast<const char *>(&constants + 1));
+      return;
+    }
+    /* Sample offsets come in 1/SAMPLES of a pixel; so does the step. */
+    uint32_t samples = options_.specialization.supersampling *
+                       options_.specialization.supersampling;
+    Fixed128View constants;
+    ToFixed128(view.min_x, constants.min_x);
+    ToFixed128(view.min_y, constants.min_y);
+    ToFixed128(view.span_x / (double(kWidth) * samples), constants.step_x);
+    ToFixed128(view.span_y / (double(kHeight) * samples), constants.step_y);
+    push_constants_.assign(reinterpret_cast<const char *>(&constants),
+                           reinterpret_cast<const char *>(&constants + 1));
+  }
+
+  /*
+   * Renders every kValidationStride-th pixel of every kValidationStride-th
+   * row on the CPU in the most precise arithmetic available and compares it
+   * with the frame. Colors may be off by a rounding step; a different
+   * iteration count is a mismatch. Throws when over 1% of them mismatch.
+   */
+  void ValidateImage(const kernels::Kernel &kernel) {
+    using cpu_renderer::Precision;
+    const unsigned kValidationStride = 4;
+    const int kTolerance = 2;
+    auto precision = Precision::kDoubleDouble;
+    for (auto candidate : {Precision::kFixed128, Precision::kFloat128}) {
+      if (cpu_renderer::IsAvailable(candidate)) {
+        precision = candidate;
+      }
+    }
+    /* Pixel (x, y) of the smaller image samples (x, y) * stride of ours. */
+    unsigned width = kWidth / kValidationStride;
+    unsigned height = kHeight / kValidationStride;
+    std::vector<unsigned char> reference(size_t(width) * height * 4);
+    cpu_renderer::RenderRows(RenderView(options_), width, height,
+                             options_.specialization.max_iterations, 0, height,
+                             reference.data(), 0, precision, 0,
+                             CpuFractal(options_));
+    auto pixel_data = static_cast<Pixel *>(buffer_memory_.mapped);
+    size_t mismatches = 0;
+    for (unsigned y = 0; y < height; ++y) {
+      for (unsigned x = 0; x < width; ++x) {
+        const auto &pixel = pixel_data[size_t(y * kValidationStride) * kWidth +
+                                       x * kValidationStride];
+        const unsigned char *expected = &reference[(size_t(y) * width + x) * 4];
+        const int channels[3] = {pixel.r, pixel.g, pixel.b};
+        for (int i = 0; i < 3; ++i) {
+          if (std::abs(channels[i] - expected[i]) > kTolerance) {
+            ++mismatches;
+            break;
+          }
+        }
+      }
+    }
+    double percent = 100.0 * mismatches / (size_t(width) * height);
+    std::cerr << "Validation of " << kernel.name << " against "
+              << cpu_renderer::PrecisionName(precision) << ": " << mismatches
+              << " of " << width * height << " sampled pixels differ ("
+              << percent << "%)." << std::endl;
+    if (percent > 1.0) {
+      throw std::runtime_error("Validation failed.");
+    }
+  }
+
+  /*
+   * Renders the tiles with a dispatch and a submit per batch. The tile
+   * descriptors live in a storage buffer, the kernel picks its tile with
+   * gl_WorkGroupID.z, and all tiles of a batch write into one packed output
+   * arena. Batches are as large as the memory budget allows (all tiles when
+   * it is ample), and are halved whenever the device runs out of memory.
+   */
+  void RenderTiles() {
+    BuildTileDescriptors();
+    const auto &kernel = kernels::Find(JobFeatures());
+    CreateCommandPool();
+    CreateCommandBuffers();
+    auto prefix = options_.output == "-"
+                      ? "mandelbrot"s
+                      : options_.output.substr(0, options_.output.rfind('.'));
+    size_t batch_size = TilesPerBatch();
+    for (size_t first = 0; first < tiles_.size();) {
+      size_t count = std::min(batch_size, tiles_.size() - first);
+      try {
+        RenderTileBatch(kernel, first, count);
+      } catch (const vk::SystemError &error) {
+        if (not IsOutOfMemory(error) or count == 1) {
+          throw;
+        }
+        ReleaseTileBatch();
+        batch_size = count / 2;
+        std::cerr << "Out of memory for " << count << " tiles; retrying "
+                  << batch_size << " at a time." << std::endl;
+        continue;
+      }
+      SaveRenderedTiles(prefix + "_tile", first, count);
+      ReleaseTileBatch();
+      first += count;
+    }
+  }
+
+  /* Renders tiles_[first, first + count) into a fresh arena. */
+  void RenderTileBatch(const kernels::Kernel &kernel, size_t first,
+                       size_t count) {
+    batch_tiles_.assign(tiles_.begin() + first,
+                        tiles_.begin() + first + count);
+    uint32_t base = batch_tiles_.front().output_offset;
+    uint32_t max_width = 0, max_height = 0, pixels = 0;
+    for (auto &tile : batch_tiles_) {
+      tile.output_offset -= base;
+      pixels += tile.width * tile.height;
+      max_width = std::max(max_width, tile.width);
+      max_height = std::max(max_height, tile.height);
+    }
+    buffer_size_ = sizeof(Pixel) * pixels;
+    CreateBuffer();
+    AllocateDeviceMemory();
+    CreateTileDescriptorBuffer();
+    BindBuffers(
+        {vk::DescriptorBufferInfo(*buffer_, 0, buffer_size_),
+         vk::DescriptorBufferInfo(*tile_buffer_, 0, tile_buffer_size_)});
+    pipeline_ = Pipeline(kernel, options_.specialization);
+    FillCommandBuffer(
+        (uint32_t)std::ceil(max_width / float(kernel.workgroup_size)),
+        (uint32_t)std::ceil(max_height / float(kernel.workgroup_size)),
+        batch_tiles_.size());
+    SubmitAndWait();
+  }
+
+  /* Frees the arena of the last batch, so the next one can reuse it. */
+  void ReleaseTileBatch() {
+    buffer_.reset();
+    tile_buffer_.reset();
+    if (buffer_memory_.size > 0) {
+      allocator_->Free(buffer_memory_);
+      buffer_memory_ = device_memory::Allocation();
+    }
+  }
+
+  static bool IsOutOfMemory(const vk::SystemError &error) {
+    return error.code().value() == VK_ERROR_OUT_OF_DEVICE_MEMORY or
+           error.code().value() == VK_ERROR_OUT_OF_HOST_MEMORY;
+  }
+
+  /*
+   * Budget and current usage of the heap buffers with these memory
+   * properties live in, host-visible ones by default. With
+   * VK_EXT_memory_budget these cover every process on the device; without
+   * it, the budget is the heap size and only our own blocks in that heap
+   * count as used.
+   */
+  struct HeapBudget {
+    vk::DeviceSize budget;
+    vk::DeviceSize usage;
+    bool reported;
+  };
+
+  HeapBudget QueryHeapBudget(
+      const vk::MemoryPropertyFlags &properties =
+          vk::MemoryPropertyFlagBits::eHostCoherent |
+          vk::MemoryPropertyFlagBits::eHostVisible) {
+    auto memory_properties = physical_device_.getMemoryProperties();
+    uint32_t memory_type_index = FindMemoryType(~0, properties);
+    uint32_t heap = memory_properties.memoryTypes[memory_type_index].heapIndex;
+    HeapBudget budget = {memory_properties.memoryHeaps[heap].size,
+                         allocator_->HeapBlockBytes(heap), false};
+#ifdef VK_EXT_memory_budget
+    if (memory_budget_) {
+      auto heap_budgets = VkPhysicalDeviceMemoryBudgetPropertiesEXT();
+      heap_budgets.sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+      auto properties = VkPhysicalDeviceMemoryProperties2KHR();
+      properties.sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+      properties.pNext = &heap_budgets;
+      vkGetPhysicalDeviceMemoryProperties2KHR(
+          static_cast<VkPhysicalDevice>(physical_device_), &properties);
+      budget = {heap_budgets.heapBudget[heap], heap_budgets.heapUsage[heap],
+                true};
+    }
+#endif
+    return budget;
+  }
+
+  /*
+   * How many tiles fit in memory_fraction of the heap budget, less what is
+   * in use, in one storage buffer binding and in one dispatch. At least one.
+   */
+  size_t TilesPerBatch() {
+    auto budget = QueryHeapBudget();
+    double allowed = options_.memory_fraction * budget.budget -
+                     static_cast<double>(budget.usage);
+    allowed = std::min(allowed, double(profile_.max_storage_buffer_range));
+    /* tiles_[0] is the largest tile, see BuildTileDescriptors(). */
+    double tile_bytes =
+        sizeof(Pixel) * double(tiles_[0].width) * tiles_[0].height;
+    size_t batch_size = allowed > tile_bytes ? size_t(allowed / tile_bytes) : 1;
+    auto max_count = physical_device_.getProperties()
+                         .limits.maxComputeWorkGroupCount[2];
+    batch_size = std::min({batch_size, tiles_.size(), size_t(max_count)});
+    std::cerr << "Memory heap: " << (budget.usage >> 20) << " of "
+              << (budget.budget >> 20) << " MiB in use ("
+              << (budget.reported ? kMemoryBudgetExtension : "heap size")
+              << "); " << batch_size << " tiles per batch." << std::endl;
+    return batch_size;
   }
 
   void ProbeInstallation() {
@@ -83,10 +682,11 @@ class MandelbrotApp {
       std::cerr << "  " << layer_property.layerName << "\t\t"
                 << layer_property.description << std::endl;
       if (std::string(layer_property.layerName) == kValidationLayer) {
-        enabled_layers_.push_back(kValidationLayer);
+        profile_.validation_layer = true;
       }
     }
-    if (enabled_layers_.empty()) {
+    if (not profile_.validation_layer and
+        options_.profile == Profile::kDebug) {
       std::cerr << "WARNING: " << kValidationLayer << " layer not available." << std::endl;
     }
     std::vector<vk::ExtensionProperties> extension_props =
@@ -96,15 +696,48 @@ class MandelbrotApp {
     for (const auto &extension_prop : extension_props) {
       std::cerr << "  " << extension_prop.extensionName << std::endl;
       if (std::string(extension_prop.extensionName) == kDebugReportExtension) {
-        enabled_extensions_.push_back(kDebugReportExtension);
+        profile_.debug_report = true;
+      }
+      if (std::string(extension_prop.extensionName) ==
+          kPhysicalDeviceProperties2Extension) {
+        profile_.physical_device_properties2 = true;
       }
     }
-    if (enabled_extensions_.empty()) {
+    if (not profile_.debug_report) {
       std::cerr << "WARNING: " << kDebugReportExtension << " extension not available." << std::endl;
     }
   }
 
+  /*
+   * Creates the instance with the layers and extensions recorded in the
+   * device profile, without enumerating them. Probes again if that fails.
+   */
+  void CreateProfiledInstance() {
+    try {
+      CreateInstance();
+    } catch (const vk::SystemError &e) {
+      std::cerr << "Device profile " << options_.device_profile
+                << " is stale (" << e.what() << "); probing again."
+                << std::endl;
+      profile_cached_ = false;
+      profile_ = device_profile::Profile();
+      ProbeInstallation();
+      CreateInstance();
+    }
+  }
+
   void CreateInstance() {
+    enabled_layers_.clear();
+    enabled_extensions_.clear();
+    if (profile_.validation_layer and options_.profile == Profile::kDebug) {
+      enabled_layers_.push_back(kValidationLayer);
+    }
+    if (profile_.debug_report) {
+      enabled_extensions_.push_back(kDebugReportExtension);
+    }
+    if (profile_.physical_device_properties2) {
+      enabled_extensions_.push_back(kPhysicalDeviceProperties2Extension);
+    }
     auto app_info = vk::ApplicationInfo();
     app_info.setPApplicationName(kAppShortName)
         .setApplicationVersion(1)
@@ -118,17 +751,24 @@ class MandelbrotApp {
         .setEnabledExtensionCount(enabled_extensions_.size())
         .setPpEnabledExtensionNames(enabled_extensions_.data());
     instance_ = vk::createInstanceUnique(inst_info);
+  }
+
+  void InitExtensions() {
     vkExtInitInstance(*instance_);
   }
 
   void RegisterDebugReportCallback() {
+    vk::DebugReportFlagsEXT flags =
+        vk::DebugReportFlagBitsEXT::eWarning |
+        vk::DebugReportFlagBitsEXT::ePerformanceWarning |
+        vk::DebugReportFlagBitsEXT::eError;
+    if (options_.profile == Profile::kDebug) {
+      flags |= vk::DebugReportFlagBitsEXT::eInformation;
+    }
     auto create_info = vk::DebugReportCallbackCreateInfoEXT();
-    create_info
-        .setFlags(vk::DebugReportFlagBitsEXT::eInformation |
-                  vk::DebugReportFlagBitsEXT::eWarning |
-                  vk::DebugReportFlagBitsEXT::ePerformanceWarning |
-                  vk::DebugReportFlagBitsEXT::eError)
-        .setPfnCallback(DebugReportCallback);
+    create_info.setFlags(flags)
+        .setPfnCallback(DebugReportCallback)
+        .setPUserData(log_.get());
     debug_report_callback_ =
         instance_->createDebugReportCallbackEXTUnique(create_info);
   }
@@ -146,6 +786,89 @@ class MandelbrotApp {
                 << std::endl;
     }
     physical_device_ = devices[0];
+    DescribeDevice(physical_device_, &profile_);
+    profile_.memory_type_index = FindMemoryType(
+        ~0, vk::MemoryPropertyFlagBits::eHostCoherent |
+                vk::MemoryPropertyFlagBits::eHostVisible);
+    profile_.push_descriptor = false;
+    profile_.memory_budget = false;
+    for (const auto &extension :
+         physical_device_.enumerateDeviceExtensionProperties()) {
+      if (std::string(extension.extensionName) == kPushDescriptorExtension) {
+        profile_.push_descriptor = true;
+      }
+      if (std::string(extension.extensionName) == kMemoryBudgetExtension) {
+        profile_.memory_budget = true;
+      }
+    }
+  }
+
+  /* Fills in what identifies device and its compute limits. */
+  static void DescribeDevice(vk::PhysicalDevice device,
+                             device_profile::Profile *profile) {
+    auto properties = device.getProperties();
+    profile->vendor_id = properties.vendorID;
+    profile->device_id = properties.deviceID;
+    profile->driver_version = properties.driverVersion;
+    profile->pipeline_cache_uuid = device_profile::HexString(
+        properties.pipelineCacheUUID, VK_UUID_SIZE);
+    profile->device_name = properties.deviceName;
+    const auto &limits = properties.limits;
+    profile->max_compute_work_group_invocations =
+        limits.maxComputeWorkGroupInvocations;
+    for (int i = 0; i < 3; ++i) {
+      profile->max_compute_work_group_size[i] =
+          limits.maxComputeWorkGroupSize[i];
+      profile->max_compute_work_group_count[i] =
+          limits.maxComputeWorkGroupCount[i];
+    }
+    profile->max_storage_buffer_range = limits.maxStorageBufferRange;
+    profile->shader_int64 = device.getFeatures().shaderInt64;
+  }
+
+  /*
+   * Picks the device recorded in the profile, checking that its driver and
+   * limits did not change, that the queue family still computes and that
+   * the memory type is still host-visible and coherent. Otherwise leaves
+   * profile_cached_ false so the device is probed again.
+   */
+  void FindProfiledDevice() {
+    for (const auto &device : instance_->enumeratePhysicalDevices()) {
+      auto live = profile_;
+      DescribeDevice(device, &live);
+      if (not device_profile::SameDevice(live, profile_)) {
+        continue;
+      }
+      auto families = device.getQueueFamilyProperties();
+      uint32_t family = profile_.queue_family_index;
+      auto memory_properties = device.getMemoryProperties();
+      uint32_t type = profile_.memory_type_index;
+      vk::MemoryPropertyFlags host_visible =
+          vk::MemoryPropertyFlagBits::eHostCoherent |
+          vk::MemoryPropertyFlagBits::eHostVisible;
+      if (family < families.size() and
+          (families[family].queueFlags & vk::QueueFlagBits::eCompute) and
+          type < memory_properties.memoryTypeCount and
+          (memory_properties.memoryTypes[type].propertyFlags &
+           host_visible) == host_visible) {
+        physical_device_ = device;
+        queue_family_index_ = family;
+        return;
+      }
+    }
+    std::cerr << "Device profile " << options_.device_profile
+              << " does not match any device; probing again." << std::endl;
+    profile_cached_ = false;
+  }
+
+  /* The profile is only a cache: a run that cannot save it still renders. */
+  void SaveDeviceProfile() {
+    try {
+      device_profile::Save(options_.device_profile, profile_);
+    } catch (const std::runtime_error &e) {
+      std::cerr << "WARNING: device profile not saved: " << e.what()
+                << std::endl;
+    }
   }
 
   void FindQueueFamily() {
@@ -157,6 +880,7 @@ class MandelbrotApp {
                 << vk::to_string(family.queueFlags) << std::endl;
     }
     queue_family_index_ = FindQueueFamilyIndex(families);
+    profile_.queue_family_index = queue_family_index_;
   }
 
   void CreateLogicalDevice() {
@@ -165,111 +889,499 @@ class MandelbrotApp {
     queue_info.setQueueFamilyIndex(queue_family_index_)
         .setQueueCount(1)
         .setPQueuePriorities(queue_priorities);
+    /*
+     * Push descriptors and the memory budget depend on
+     * VK_KHR_get_physical_device_properties2.
+     */
+    std::vector<const char *> device_extensions;
+    if (profile_.physical_device_properties2 and profile_.push_descriptor and
+        options_.push_descriptors) {
+      device_extensions.push_back(kPushDescriptorExtension);
+      push_descriptors_ = true;
+    }
+#ifdef VK_EXT_memory_budget
+    if (profile_.physical_device_properties2 and profile_.memory_budget) {
+      device_extensions.push_back(kMemoryBudgetExtension);
+      memory_budget_ = true;
+    }
+#endif
+    std::cerr << "Buffer bindings: "
+              << (push_descriptors_ ? "push descriptors" : "pooled sets")
+              << std::endl;
+    auto features = vk::PhysicalDeviceFeatures();
+    features.setShaderInt64(profile_.shader_int64);
     auto device_info = vk::DeviceCreateInfo();
-    device_info.setQueueCreateInfoCount(1).setPQueueCreateInfos(&queue_info);
+    device_info.setQueueCreateInfoCount(1)
+        .setPQueueCreateInfos(&queue_info)
+        .setPEnabledFeatures(&features)
+        .setEnabledExtensionCount(device_extensions.size())
+        .setPpEnabledExtensionNames(device_extensions.data());
     device_ = physical_device_.createDeviceUnique(device_info);
+    vkExtInitDeviceTable(*device_, &device_table_);
   }
 
   void GetQueue() { queue_ = device_->getQueue(queue_family_index_, 0); }
 
+  void CreateAllocator() {
+    allocator_.reset(new device_memory::Allocator(physical_device_, *device_));
+  }
+
+  void PrintMemoryStats() {
+    auto stats = allocator_->stats();
+    std::cerr << "memory: " << stats.blocks << " blocks ("
+              << (stats.block_bytes >> 20) << " MiB), " << stats.allocations
+              << " allocations (" << (stats.allocated_bytes >> 10)
+              << " KiB), " << (stats.frame_bytes >> 10)
+              << " KiB of staging in flight, " << stats.device_allocations
+              << " vkAllocateMemory calls" << std::endl;
+  }
+
   void CreateBuffer() {
+    buffer_ = CreateStorageBuffer(buffer_size_);
+  }
+
+  void AllocateDeviceMemory() {
+    buffer_memory_ = AllocateHostVisibleMemory(
+        *buffer_, device_memory::Lifetime::kLongLived);
+  }
+
+  /*
+   * The iteration counts, one per sample, and the histogram only pass
+   * between kernels, so they live in device-local memory. The histogram is
+   * cleared by a transfer command before every histogram pass.
+   */
+  void CreateHistogramBuffers() {
+    vk::DeviceSize counts_size = sizeof(uint32_t) * vk::DeviceSize(kWidth) *
+                                 kHeight *
+                                 options_.specialization.supersampling *
+                                 options_.specialization.supersampling;
+    CheckHistogramCountsSize(counts_size);
+    counts_buffer_ = CreateStorageBuffer(counts_size);
+    counts_memory_ = AllocateDeviceLocalMemory(*counts_buffer_);
+    histogram_buffer_ =
+        CreateStorageBuffer(2 * sizeof(uint32_t) * kernels::kHistogramBins,
+                            vk::BufferUsageFlagBits::eTransferDst);
+    histogram_memory_ = AllocateDeviceLocalMemory(*histogram_buffer_);
+  }
+
+  /*
+   * Splits the default view into a grid of tiles and uploads their
+   * descriptors. Tile pixels are packed back to back in the output arena.
+   */
+  void BuildTileDescriptors() {
+    tiles_.clear();
+    uint32_t offset = 0;
+    auto view = RenderView(options_);
+    /*
+     * Tile i of n starts at pixel i * size / n rounded up, so every pixel of
+     * the image belongs to a tile and sizes differ by at most one, the first
+     * being the largest. Each tile spans exactly its pixels of the view.
+     */
+    auto start = [](uint32_t i, uint32_t size, uint32_t count) {
+      return uint32_t((uint64_t(i) * size + count - 1) / count);
+    };
+    for (uint32_t row = 0; row < options_.tile_rows; ++row) {
+      uint32_t y = start(row, kHeight, options_.tile_rows);
+      uint32_t tile_height = start(row + 1, kHeight, options_.tile_rows) - y;
+      for (uint32_t column = 0; column < options_.tile_columns; ++column) {
+        uint32_t x = start(column, kWidth, options_.tile_columns);
+        uint32_t tile_width =
+            start(column + 1, kWidth, options_.tile_columns) - x;
+        auto tile = TileDescriptor();
+        tile.span_x = float(view.span_x * tile_width / kWidth);
+        tile.span_y = float(view.span_y * tile_height / kHeight);
+        tile.min_x = float(view.min_x + view.span_x * x / kWidth);
+        tile.min_y = float(view.min_y + view.span_y * y / kHeight);
+        tile.width = tile_width;
+        tile.height = tile_height;
+        tile.max_iterations = options_.specialization.max_iterations;
+        tile.output_offset = offset;
+        offset += tile_width * tile_height;
+        tiles_.push_back(tile);
+      }
+    }
+    buffer_size_ = sizeof(Pixel) * offset;
+  }
+
+  void CreateTileDescriptorBuffer() {
+    tile_buffer_size_ = sizeof(TileDescriptor) * batch_tiles_.size();
+    tile_buffer_ = CreateStorageBuffer(tile_buffer_size_);
+    /* Only read by this frame's dispatch: staging ring memory. */
+    tile_buffer_memory_ = AllocateHostVisibleMemory(
+        *tile_buffer_, device_memory::Lifetime::kFrame);
+    std::memcpy(tile_buffer_memory_.mapped, batch_tiles_.data(),
+                tile_buffer_size_);
+  }
+
+  vk::UniqueBuffer CreateStorageBuffer(
+      vk::DeviceSize size, vk::BufferUsageFlags extra_usage = {}) {
     auto buffer_create_info = vk::BufferCreateInfo();
-    buffer_create_info.setSize(buffer_size)
-        .setUsage(vk::BufferUsageFlagBits::eStorageBuffer)
+    buffer_create_info.setSize(size)
+        .setUsage(vk::BufferUsageFlagBits::eStorageBuffer | extra_usage)
         .setSharingMode(vk::SharingMode::eExclusive);
-    buffer_ = device_->createBufferUnique(buffer_create_info);
+    return device_->createBufferUnique(buffer_create_info);
   }
 
-  void AllocateDeviceMemory() {
-    auto memory_requirements = device_->getBufferMemoryRequirements(*buffer_);
+  /*
+   * The counts are bound whole, so like a batch of tiles (TilesPerBatch())
+   * they must fit in one storage buffer binding and in memory_fraction of
+   * the device-local heap budget. Throws otherwise, before allocating.
+   */
+  void CheckHistogramCountsSize(vk::DeviceSize counts_size) {
+    auto budget = QueryHeapBudget(vk::MemoryPropertyFlagBits::eDeviceLocal);
+    double allowed = options_.memory_fraction * budget.budget -
+                     static_cast<double>(budget.usage);
+    allowed = std::min(allowed, double(profile_.max_storage_buffer_range));
+    if (double(counts_size) <= allowed) {
+      return;
+    }
+    std::string message =
+        "--histogram needs " + std::to_string(counts_size >> 20) +
+        " MiB of iteration counts in one storage buffer, over the " +
+        std::to_string(uint64_t(std::max(0.0, allowed)) >> 20) +
+        " MiB this device allows.";
+    /* Counts grow with the square of --supersample: suggest one that fits. */
+    uint32_t requested = options_.specialization.supersampling;
+    double sample_bytes = double(counts_size) / (requested * requested);
+    uint32_t fits = requested;
+    while (fits > 1 and sample_bytes * fits * fits > allowed) {
+      --fits;
+    }
+    if (fits < requested and sample_bytes * fits * fits <= allowed) {
+      message += " Use --supersample=" + std::to_string(fits) + " or less.";
+    }
+    throw std::runtime_error(message);
+  }
+
+  /* Sub-allocates host-visible, coherent memory for buffer and binds it. */
+  device_memory::Allocation AllocateHostVisibleMemory(
+      vk::Buffer buffer, device_memory::Lifetime lifetime) {
+    auto memory_requirements = device_->getBufferMemoryRequirements(buffer);
     uint32_t memory_type_index =
         FindMemoryType(memory_requirements.memoryTypeBits,
                        vk::MemoryPropertyFlagBits::eHostCoherent |
                            vk::MemoryPropertyFlagBits::eHostVisible);
-    auto allocate_info = vk::MemoryAllocateInfo();
-    allocate_info.setAllocationSize(memory_requirements.size)
-        .setMemoryTypeIndex(memory_type_index);
-    buffer_memory_ = device_->allocateMemoryUnique(allocate_info);
+    return allocator_->AllocateForBuffer(buffer, memory_type_index, lifetime);
   }
 
-  void BindDeviceMemory() {
-    device_->bindBufferMemory(*buffer_, *buffer_memory_, 0);
+  /* Sub-allocates device-local memory for buffer, which the host never maps. */
+  device_memory::Allocation AllocateDeviceLocalMemory(vk::Buffer buffer) {
+    auto memory_requirements = device_->getBufferMemoryRequirements(buffer);
+    uint32_t memory_type_index =
+        FindMemoryType(memory_requirements.memoryTypeBits,
+                       vk::MemoryPropertyFlagBits::eDeviceLocal);
+    return allocator_->AllocateForBuffer(buffer, memory_type_index,
+                                         device_memory::Lifetime::kLongLived);
   }
 
   void CreateDescriptorSetLayout() {
-    auto descriptor_set_layout_binding = vk::DescriptorSetLayoutBinding();
-    descriptor_set_layout_binding
-        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
-        .setDescriptorCount(1)
-        .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    std::vector<vk::DescriptorSetLayoutBinding> bindings(
+        kStorageBufferBindings);
+    for (uint32_t i = 0; i < kStorageBufferBindings; ++i) {
+      bindings[i]
+          .setBinding(i)
+          .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+          .setDescriptorCount(1)
+          .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    }
     auto descriptor_set_layout_create_info =
         vk::DescriptorSetLayoutCreateInfo();
-    descriptor_set_layout_create_info.setBindingCount(1).setPBindings(
-        &descriptor_set_layout_binding);
+    descriptor_set_layout_create_info.setBindingCount(bindings.size())
+        .setPBindings(bindings.data());
+    if (push_descriptors_) {
+      descriptor_set_layout_create_info.setFlags(
+          vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+    }
     descriptor_set_layout_ = device_->createDescriptorSetLayoutUnique(
         descriptor_set_layout_create_info);
   }
 
-  void CreateDescriptorPool() {
+  /*
+   * Sets the buffers bound to the kernel's bindings, buffer_infos[i] to
+   * binding i, for the next recorded dispatch. With push descriptors they
+   * are recorded straight into the command buffer; otherwise they are
+   * written into the next of a few sets allocated once, so no job ever
+   * allocates descriptor sets or pools.
+   */
+  void BindBuffers(const std::vector<vk::DescriptorBufferInfo> &buffer_infos) {
+    buffer_bindings_ = buffer_infos;
+    if (push_descriptors_) {
+      return;
+    }
+    if (not descriptor_pool_) {
+      CreateDescriptorPool(kStorageBufferBindings);
+      CreateDescriptorSets();
+    }
+    ConnectBufferWithDescriptorSets(buffer_infos);
+  }
+
+  void CreateDescriptorPool(uint32_t descriptor_count) {
     auto descriptor_pool_size = vk::DescriptorPoolSize();
     descriptor_pool_size.setType(vk::DescriptorType::eStorageBuffer)
-        .setDescriptorCount(1);
+        .setDescriptorCount(descriptor_count * kPooledDescriptorSets);
     auto descriptor_pool_create_info = vk::DescriptorPoolCreateInfo();
-    descriptor_pool_create_info.setMaxSets(1).setPoolSizeCount(1).setPPoolSizes(
-        &descriptor_pool_size);
+    descriptor_pool_create_info.setMaxSets(kPooledDescriptorSets)
+        .setPoolSizeCount(1)
+        .setPPoolSizes(&descriptor_pool_size);
     descriptor_pool_ =
         device_->createDescriptorPoolUnique(descriptor_pool_create_info);
   }
 
   void CreateDescriptorSets() {
+    std::vector<vk::DescriptorSetLayout> layouts(kPooledDescriptorSets,
+                                                 *descriptor_set_layout_);
     auto descriptor_set_allocate_info = vk::DescriptorSetAllocateInfo();
     descriptor_set_allocate_info.setDescriptorPool(*descriptor_pool_)
-        .setDescriptorSetCount(1)
-        .setPSetLayouts(&descriptor_set_layout_.get());
+        .setDescriptorSetCount(layouts.size())
+        .setPSetLayouts(layouts.data());
     descriptor_sets_ =
         device_->allocateDescriptorSets(descriptor_set_allocate_info);
   }
 
-  void ConnectBufferWithDescriptorSets() {
-    auto descriptor_buffer_info = vk::DescriptorBufferInfo();
-    descriptor_buffer_info.setBuffer(*buffer_).setOffset(0).setRange(
-        buffer_size);
-    auto write_descriptor_set = vk::WriteDescriptorSet();
-    write_descriptor_set.setDstSet(descriptor_sets_[0])
-        .setDstBinding(0)
-        .setDescriptorCount(1)
-        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
-        .setPBufferInfo(&descriptor_buffer_info);
-    device_->updateDescriptorSets({write_descriptor_set}, {});
+  /*
+   * Writes buffer_infos into the least recently used pooled set. Jobs wait
+   * for their submit, so a set is never rewritten while the GPU reads it.
+   */
+  void ConnectBufferWithDescriptorSets(
+      const std::vector<vk::DescriptorBufferInfo> &buffer_infos) {
+    bound_descriptor_set_ = descriptor_sets_[next_descriptor_set_];
+    next_descriptor_set_ = (next_descriptor_set_ + 1) % descriptor_sets_.size();
+    auto write_descriptor_sets = BufferWrites(buffer_infos);
+    for (auto &write : write_descriptor_sets) {
+      write.setDstSet(bound_descriptor_set_);
+    }
+    device_->updateDescriptorSets(write_descriptor_sets, {});
   }
 
-  void CreateShaderModule(const char *shader_filename) {
-    auto code = ReadFile(shader_filename);
-    auto shader_create_info = vk::ShaderModuleCreateInfo();
-    shader_create_info.setPCode(code.data()).setCodeSize(code.size());
-    compute_shader_module_ =
-        device_->createShaderModuleUnique(shader_create_info);
+  static std::vector<vk::WriteDescriptorSet> BufferWrites(
+      const std::vector<vk::DescriptorBufferInfo> &buffer_infos) {
+    std::vector<vk::WriteDescriptorSet> write_descriptor_sets(
+        buffer_infos.size());
+    for (uint32_t i = 0; i < buffer_infos.size(); ++i) {
+      write_descriptor_sets[i]
+          .setDstBinding(i)
+          .setDescriptorCount(1)
+          .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+          .setPBufferInfo(&buffer_infos[i]);
+    }
+    return write_descriptor_sets;
   }
 
-  void CreatePipeline() {
-    auto shader_stage_create_info = vk::PipelineShaderStageCreateInfo();
-    shader_stage_create_info.setStage(vk::ShaderStageFlagBits::eCompute)
-        .setModule(*compute_shader_module_)
-        .setPName("main");
+  /* Records the bindings set by BindBuffers() into command_buffer. */
+  void RecordBufferBindings(VkCommandBuffer command_buffer) {
+    auto layout = static_cast<VkPipelineLayout>(*pipeline_layout_);
+    if (push_descriptors_) {
+      auto writes = BufferWrites(buffer_bindings_);
+      device_table_.vkCmdPushDescriptorSetKHR(
+          command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0,
+          writes.size(),
+          reinterpret_cast<const VkWriteDescriptorSet *>(writes.data()));
+      return;
+    }
+    auto descriptor_set = static_cast<VkDescriptorSet>(bound_descriptor_set_);
+    device_table_.vkCmdBindDescriptorSets(command_buffer,
+                                          VK_PIPELINE_BIND_POINT_COMPUTE,
+                                          layout, 0, 1, &descriptor_set, 0,
+                                          nullptr);
+  }
+
+  /*
+   * Returns the module of kernel, creating it on first use. Called from the
+   * warm-up threads.
+   */
+  vk::ShaderModule ShaderModule(const kernels::Kernel &kernel) {
+    std::lock_guard<std::mutex> lock(shader_modules_mutex_);
+    auto &module = shader_modules_[kernel.name];
+    if (not module) {
+      auto shader_create_info = vk::ShaderModuleCreateInfo();
+      shader_create_info.setPCode(kernel.code).setCodeSize(kernel.code_size);
+      module = device_->createShaderModuleUnique(shader_create_info);
+    }
+    return *module;
+  }
+
+  /* Shared by every kernel; the push constants hold the image's view. */
+  void CreatePipelineLayout() {
+    auto push_constant_range = vk::PushConstantRange(
+        vk::ShaderStageFlagBits::eCompute, 0, sizeof(Fixed128View));
     auto pipeline_layout_create_info = vk::PipelineLayoutCreateInfo();
-    pipeline_layout_create_info.setSetLayoutCount(1).setPSetLayouts(
-        &descriptor_set_layout_.get());
+    pipeline_layout_create_info.setSetLayoutCount(1)
+        .setPSetLayouts(&descriptor_set_layout_.get())
+        .setPushConstantRangeCount(1)
+        .setPPushConstantRanges(&push_constant_range);
     pipeline_layout_ =
         device_->createPipelineLayoutUnique(pipeline_layout_create_info);
+  }
+
+  /*
+   * The image is rendered in float unless the CPU renderer would need more
+   * for its zoom and sample spacing; then in 128-bit fixed point.
+   */
+  kernels::Features JobFeatures() const {
+    kernels::Features features;
+    features.layout = options_.tile_columns > 0 ? kernels::Layout::kTiles
+                                                : kernels::Layout::kImage;
+    /* Tiles split the view, so together they sample it like the image. */
+    auto precision = cpu_renderer::ChoosePrecision(
+        RenderView(options_), kWidth * options_.specialization.supersampling,
+        kHeight * options_.specialization.supersampling,
+        options_.specialization.max_iterations);
+    if (precision == cpu_renderer::Precision::kFloat) {
+      return features;
+    }
+    if (features.layout == kernels::Layout::kTiles) {
+      throw std::runtime_error(
+          "This zoom needs the fixed-point kernel, and --tiles only has a "
+          "float one; render it without --tiles.");
+    }
+    if (not profile_.shader_int64) {
+      throw std::runtime_error(
+          "This zoom needs the fixed-point kernel, and the device lacks "
+          "shaderInt64; render it with --spawn-workers instead.");
+    }
+    if (precision == cpu_renderer::Precision::kFloat128) {
+      std::cerr << "WARNING: the zoom is too deep for fixed128; expect noise."
+                << std::endl;
+    }
+    features.precision = kernels::Precision::kFixed128;
+    return features;
+  }
+
+  /* The kernel of one of the histogram coloring passes. */
+  static kernels::Features HistogramPassFeatures(kernels::Pass pass) {
+    kernels::Features features;
+    features.pass = pass;
+    return features;
+  }
+
+  /*
+   * Creates the shared layouts and pipeline cache, and starts creating the
+   * configured pipelines on the warm-up threads: the job's own first, so the
+   * rest of its setup overlaps with compiling it.
+   */
+  void StartPipelineWarmUp() {
+    CreateDescriptorSetLayout();
+    CreatePipelineLayout();
+    pipeline_cache_ =
+        device_->createPipelineCacheUnique(vk::PipelineCacheCreateInfo());
+    warm_up_.reset(new warm_up::Pool(options_.warm_up_threads));
+    QueuePipeline(kernels::Find(JobFeatures()), options_.specialization);
+    if (options_.specialization.histogram) {
+      for (auto pass : kHistogramPasses) {
+        QueuePipeline(kernels::Find(HistogramPassFeatures(pass)),
+                      options_.specialization);
+      }
+    }
+    if (not options_.warm_up_variants) {
+      return;
+    }
+    for (const auto *kernel : kernels::All()) {
+      if (kernel->features.precision == kernels::Precision::kFixed128 and
+          not profile_.shader_int64) {
+        continue;
+      }
+      if (kernel->features.pass != kernels::Pass::kRender and
+          not options_.specialization.histogram) {
+        continue;
+      }
+      for (auto coloring : {kernels::Coloring::kCosinePalette,
+                            kernels::Coloring::kGrayscale}) {
+        for (int early_outs = 0; early_outs < 4; ++early_outs) {
+          auto specialization = options_.specialization;
+          specialization.coloring = coloring;
+          specialization.interior_check = early_outs & 1;
+          specialization.periodicity = early_outs & 2;
+          QueuePipeline(*kernel, specialization);
+        }
+      }
+    }
+  }
+
+  /* Queues the pipeline of kernel and specialization, unless known already. */
+  warm_up::Pool::Task QueuePipeline(
+      const kernels::Kernel &kernel,
+      const kernels::Specialization &specialization) {
+    auto key = std::make_pair(&kernel, specialization);
+    auto found = pipelines_.find(key);
+    if (found != pipelines_.end()) {
+      return found->second.task;
+    }
+    /* Map nodes are stable; the task writes only its own entry. */
+    auto &variant = pipelines_[key];
+    variant.task = warm_up_->Add([this, &kernel, specialization, &variant] {
+      variant.pipeline = CreatePipeline(kernel, specialization);
+    });
+    return variant.task;
+  }
+
+  /*
+   * Returns the pipeline of kernel specialized for specialization, waiting
+   * for that pipeline alone if it is still being created, or creating it
+   * here if no warm-up thread has started it.
+   */
+  vk::Pipeline Pipeline(const kernels::Kernel &kernel,
+                        const kernels::Specialization &specialization) {
+    warm_up_->Wait(QueuePipeline(kernel, specialization));
+    return *pipelines_[std::make_pair(&kernel, specialization)].pipeline;
+  }
+
+  /*
+   * Every combination gets its own branch-free pipeline. They all share
+   * pipeline_layout_ and pipeline_cache_, and are created concurrently.
+   */
+  vk::UniquePipeline CreatePipeline(
+      const kernels::Kernel &kernel,
+      const kernels::Specialization &specialization) {
+    uint32_t values[kernels::kSpecializationConstants];
+    kernels::PackSpecialization(specialization, values);
+    vk::SpecializationMapEntry entries[kernels::kSpecializationConstants];
+    for (uint32_t i = 0; i < kernels::kSpecializationConstants; ++i) {
+      entries[i]
+          .setConstantID(i)
+          .setOffset(i * sizeof(uint32_t))
+          .setSize(sizeof(uint32_t));
+    }
+    auto specialization_info = vk::SpecializationInfo();
+    specialization_info.setMapEntryCount(kernels::kSpecializationConstants)
+        .setPMapEntries(entries)
+        .setDataSize(sizeof(values))
+        .setPData(values);
+    auto shader_stage_create_info = vk::PipelineShaderStageCreateInfo();
+    shader_stage_create_info.setStage(vk::ShaderStageFlagBits::eCompute)
+        .setModule(ShaderModule(kernel))
+        .setPName("main")
+        .setPSpecializationInfo(&specialization_info);
     auto pipeline_create_info = vk::ComputePipelineCreateInfo();
     pipeline_create_info.setStage(shader_stage_create_info)
         .setLayout(*pipeline_layout_);
-    pipeline_ = device_->createComputePipelineUnique({}, pipeline_create_info);
+    return device_->createComputePipelineUnique(*pipeline_cache_,
+                                                pipeline_create_info);
+  }
+
+  std::string PipelineHealthReport() const {
+    auto health = warm_up_->health();
+    return "pipelines: " + std::to_string(health.ready) + " ready, " +
+           std::to_string(health.pending) + " pending, " +
+           std::to_string(health.failed) + " failed";
+  }
+
+  /*
+   * --health-check: waits for every configured pipeline, reports, and fails
+   * unless all of them could be created.
+   */
+  void CheckPipelineHealth() {
+    warm_up_->WaitAll();
+    std::cout << PipelineHealthReport() << std::endl;
+    if (not warm_up_->health().AllReady()) {
+      throw std::runtime_error("Pipeline warm-up failed.");
+    }
   }
 
   void CreateCommandPool() {
     auto command_pool_info = vk::CommandPoolCreateInfo();
-    command_pool_info.setQueueFamilyIndex(0);
+    /* Tile batches record the command buffer again for every batch. */
+    command_pool_info.setQueueFamilyIndex(queue_family_index_).setFlags(
+        vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
     command_pool_ = device_->createCommandPoolUnique(command_pool_info);
   }
 
@@ -281,26 +1393,86 @@ class MandelbrotApp {
     command_buffers_ = device_->allocateCommandBuffersUnique(buffer_info);
   }
 
-  void FillCommandBuffer() {
+  /*
+   * Recording, submitting and waiting go through device_table_, straight
+   * into the driver, rather than through the loader's trampolines. Memory
+   * stays mapped for the allocator's lifetime.
+   */
+  void FillCommandBuffer(uint32_t group_count_x, uint32_t group_count_y,
+                         uint32_t group_count_z) {
+    auto command_buffer = static_cast<VkCommandBuffer>(*command_buffers_[0]);
+
     /* Start recording commands into the command buffer */
     auto begin_info = vk::CommandBufferBeginInfo();
     begin_info.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-    command_buffers_[0]->begin(begin_info);
+    CheckResult(device_table_.vkBeginCommandBuffer(
+                    command_buffer,
+                    reinterpret_cast<const VkCommandBufferBeginInfo *>(
+                        &begin_info)),
+                "vkBeginCommandBuffer");
 
-    /* Bind pipeline and descriptor set. */
-    command_buffers_[0]->bindPipeline(vk::PipelineBindPoint::eCompute,
-                                      *pipeline_);
-    command_buffers_[0]->bindDescriptorSets(vk::PipelineBindPoint::eCompute,
-                                            *pipeline_layout_, 0,
-                                            descriptor_sets_, {});
+    /* Bind pipeline and buffers. */
+    device_table_.vkCmdBindPipeline(command_buffer,
+                                    VK_PIPELINE_BIND_POINT_COMPUTE,
+                                    static_cast<VkPipeline>(pipeline_));
+    RecordBufferBindings(command_buffer);
+    if (not push_constants_.empty()) {
+      device_table_.vkCmdPushConstants(
+          command_buffer, static_cast<VkPipelineLayout>(*pipeline_layout_),
+          VK_SHADER_STAGE_COMPUTE_BIT, 0, push_constants_.size(),
+          push_constants_.data());
+    }
 
     /* Dispatch commands */
-    command_buffers_[0]->dispatch(
-        (uint32_t)std::ceil(kWidth / float(kWorkgroupSize)),
-        (uint32_t)std::ceil(kHeight / float(kWorkgroupSize)), 1);
+    device_table_.vkCmdDispatch(command_buffer, group_count_x, group_count_y,
+                                group_count_z);
+    if (not histogram_passes_.empty()) {
+      RecordHistogramPasses(command_buffer);
+    }
 
     /* Stop recording commands. */
-    command_buffers_[0]->end();
+    CheckResult(device_table_.vkEndCommandBuffer(command_buffer),
+                "vkEndCommandBuffer");
+  }
+
+  /*
+   * Records the passes that color the iteration counts just rendered:
+   * histogram, prefix sum, colorize. The bindings and push constants of
+   * the render dispatch stay bound, since all kernels share one layout.
+   */
+  void RecordHistogramPasses(VkCommandBuffer command_buffer) {
+    device_table_.vkCmdFillBuffer(command_buffer,
+                                  static_cast<VkBuffer>(*histogram_buffer_), 0,
+                                  VK_WHOLE_SIZE, 0);
+    /* The prefix sum is one workgroup; colorize is one invocation a pixel. */
+    uint32_t colorize_size =
+        kernels::Find(HistogramPassFeatures(kernels::Pass::kColorize))
+            .workgroup_size;
+    const uint32_t group_counts[] = {
+        kHistogramWorkgroups, 1,
+        (kWidth * kHeight + colorize_size - 1) / colorize_size};
+    for (size_t i = 0; i < histogram_passes_.size(); ++i) {
+      RecordComputeBarrier(command_buffer);
+      device_table_.vkCmdBindPipeline(
+          command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+          static_cast<VkPipeline>(histogram_passes_[i]));
+      device_table_.vkCmdDispatch(command_buffer, group_counts[i], 1, 1);
+    }
+  }
+
+  /* Makes earlier compute and transfer writes visible to the next dispatch. */
+  void RecordComputeBarrier(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask =
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    device_table_.vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+        nullptr);
   }
 
   void SubmitAndWait() {
@@ -311,37 +1483,201 @@ class MandelbrotApp {
 
     /* Create a fence */
     auto fence = device_->createFenceUnique({});
+    auto raw_fence = static_cast<VkFence>(*fence);
 
     /* Submit the command buffer to the queue. */
-    queue_.submit({submit_info}, *fence);
+    CheckResult(device_table_.vkQueueSubmit(
+                    static_cast<VkQueue>(queue_), 1,
+                    reinterpret_cast<const VkSubmitInfo *>(&submit_info),
+                    raw_fence),
+                "vkQueueSubmit");
+
+    allocator_->EndFrame();
 
     /* Wait for the fence */
-    device_->waitForFences({*fence}, VK_TRUE, 100000000000);
+    CheckResult(device_table_.vkWaitForFences(static_cast<VkDevice>(*device_),
+                                              1, &raw_fence, VK_TRUE,
+                                              100000000000),
+                "vkWaitForFences");
+    allocator_->RetireFrame();
+  }
+
+  static void CheckResult(VkResult result, const char *command) {
+    if (result != VK_SUCCESS) {
+      throw std::runtime_error(std::string(command) + " failed: " +
+                               vk::to_string(vk::Result(result)));
+    }
+  }
+
+  void SaveRenderedImage(const std::string &outfilename) {
+    auto pixel_data = static_cast<Pixel *>(buffer_memory_.mapped);
+    image_writers::WriteImage(options_.format, &pixel_data->r, kWidth,
+                              kHeight, outfilename);
+  }
+
+  /*
+   * Copies the frame from the mapped buffer straight into the next slot of
+   * the shared-memory ring and wakes its consumers. No file, no encoding.
+   */
+  void PublishRenderedImage() {
+    if (not frame_ring_) {
+      frame_ring_.reset(new frame_ring::Producer(
+          options_.shm_name, kFrameRingSlots, size_t(kWidth) * kHeight * 4));
+    }
+    unsigned char *frame = frame_ring_->BeginFrame(kWidth, kHeight);
+    std::memcpy(frame, buffer_memory_.mapped, sizeof(Pixel) * kWidth * kHeight);
+    frame_ring_->Publish();
   }
 
-  void SaveRenderedImage(const char *outfilename) {
-    auto pixel_data = static_cast<Pixel *>(
-        device_->mapMemory(*buffer_memory_, 0, buffer_size, {}));
-    std::vector<unsigned char> image;
-    image.reserve(kWidth * kHeight * 4);
-    for (int i = 0; i < kWidth * kHeight; ++i) {
-      image.push_back(static_cast<unsigned char>(255.0f * (pixel_data[i].r)));
-      image.push_back(static_cast<unsigned char>(255.0f * (pixel_data[i].g)));
-      image.push_back(static_cast<unsigned char>(255.0f * (pixel_data[i].b)));
-      image.push_back(static_cast<unsigned char>(255.0f * (pixel_data[i].a)));
+  /* Saves the batch of tiles_[first, first + count) just rendered. */
+  void SaveRenderedTiles(const std::string &prefix, size_t first,
+                         size_t count) {
+    auto pixel_data = static_cast<Pixel *>(buffer_memory_.mapped);
+    for (size_t i = first; i < first + count; ++i) {
+      const auto &tile = batch_tiles_[i - first];
+      auto outfilename = prefix + "_" +
+                         std::to_string(i / options_.tile_columns) + "_" +
+                         std::to_string(i % options_.tile_columns) +
+                         image_writers::FormatExtension(options_.format);
+      image_writers::WriteImage(options_.format,
+                                &pixel_data[tile.output_offset].r, tile.width,
+                                tile.height, outfilename);
     }
-    device_->unmapMemory(*buffer_memory_);
-    unsigned error = lodepng::encode(outfilename, image, kWidth, kHeight);
-    if (error) {
-      throw std::runtime_error("Encoding error: "s + lodepng_error_text(error));
+  }
+
+  /* Writes the rendered frame once in every format and reports the time. */
+  void BenchmarkWriters() {
+    using image_writers::Format;
+    auto pixel_data = static_cast<Pixel *>(buffer_memory_.mapped);
+    std::cerr << "Output format benchmark (" << kWidth << "x" << kHeight
+              << "):" << std::endl;
+    double png_ms = 0.0;
+    for (auto format : {Format::kPng, Format::kFastPng, Format::kQoi,
+                        Format::kPpm, Format::kPam, Format::kRaw}) {
+      auto outfilename = "mandelbrot_bench"s +
+                         (format == Format::kFastPng ? "_fast" : "") +
+                         image_writers::FormatExtension(format);
+      auto start = std::chrono::steady_clock::now();
+      image_writers::WriteImage(format, &pixel_data->r, kWidth, kHeight,
+                                outfilename);
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (format == Format::kPng) {
+        png_ms = elapsed.count();
+      }
+      std::ifstream written(outfilename,
+                            std::ifstream::binary | std::ifstream::ate);
+      std::cerr << "  " << outfilename << "\t" << elapsed.count() << " ms\t"
+                << written.tellg() << " bytes\t"
+                << png_ms / elapsed.count() << "x vs PNG" << std::endl;
     }
   }
 
+  /*
+   * Measures the per-call cost of the loader's trampolines (vulkan.hpp
+   * calls) against device_table_: batches of submits of an empty command
+   * buffer with a fence wait per batch, then recording many dispatches.
+   */
+  void BenchmarkSubmit() {
+    const int kBatches = 1000, kBatchSize = 64, kDispatches = 100000;
+    auto buffer_info = vk::CommandBufferAllocateInfo();
+    buffer_info.setCommandPool(*command_pool_)
+        .setLevel(vk::CommandBufferLevel::ePrimary)
+        .setCommandBufferCount(3);
+    auto command_buffers = device_->allocateCommandBuffersUnique(buffer_info);
+    auto empty = *command_buffers[0];
+    /* Submitted again while still pending, which needs simultaneous use. */
+    empty.begin(vk::CommandBufferBeginInfo(
+        vk::CommandBufferUsageFlagBits::eSimultaneousUse));
+    empty.end();
+    auto fence = device_->createFenceUnique({});
+    auto raw_device = static_cast<VkDevice>(*device_);
+    auto raw_queue = static_cast<VkQueue>(queue_);
+    auto raw_fence = static_cast<VkFence>(*fence);
+    auto submit_info = vk::SubmitInfo();
+    submit_info.setCommandBufferCount(1).setPCommandBuffers(&empty);
+    auto raw_submit_info = reinterpret_cast<const VkSubmitInfo *>(&submit_info);
+
+    auto time_ns = [](int calls, const std::function<void()> &body) {
+      auto start = std::chrono::steady_clock::now();
+      body();
+      std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+      return elapsed.count() / calls;
+    };
+    double loader_submit = time_ns(kBatches * kBatchSize, [&] {
+      for (int batch = 0; batch < kBatches; ++batch) {
+        for (int i = 0; i < kBatchSize; ++i) {
+          queue_.submit({submit_info},
+                        i == kBatchSize - 1 ? *fence : vk::Fence());
+        }
+        device_->waitForFences({*fence}, VK_TRUE, 100000000000);
+        device_->resetFences({*fence});
+      }
+    });
+    double table_submit = time_ns(kBatches * kBatchSize, [&] {
+      for (int batch = 0; batch < kBatches; ++batch) {
+        for (int i = 0; i < kBatchSize; ++i) {
+          CheckResult(device_table_.vkQueueSubmit(
+                          raw_queue, 1, raw_submit_info,
+                          i == kBatchSize - 1 ? raw_fence : VK_NULL_HANDLE),
+                      "vkQueueSubmit");
+        }
+        CheckResult(device_table_.vkWaitForFences(raw_device, 1, &raw_fence,
+                                                  VK_TRUE, 100000000000),
+                    "vkWaitForFences");
+        CheckResult(device_table_.vkResetFences(raw_device, 1, &raw_fence),
+                    "vkResetFences");
+      }
+    });
+
+    /* Recorded only, never submitted. */
+    auto loader_buffer = *command_buffers[1];
+    double loader_dispatch = time_ns(kDispatches, [&] {
+      loader_buffer.begin(vk::CommandBufferBeginInfo());
+      loader_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_);
+      RecordBufferBindings(static_cast<VkCommandBuffer>(loader_buffer));
+      for (int i = 0; i < kDispatches; ++i) {
+        loader_buffer.dispatch(1, 1, 1);
+      }
+      loader_buffer.end();
+    });
+    auto table_buffer = static_cast<VkCommandBuffer>(*command_buffers[2]);
+    auto begin_info = VkCommandBufferBeginInfo();
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    double table_dispatch = time_ns(kDispatches, [&] {
+      CheckResult(device_table_.vkBeginCommandBuffer(table_buffer, &begin_info),
+                  "vkBeginCommandBuffer");
+      device_table_.vkCmdBindPipeline(table_buffer,
+                                      VK_PIPELINE_BIND_POINT_COMPUTE,
+                                      static_cast<VkPipeline>(pipeline_));
+      RecordBufferBindings(table_buffer);
+      for (int i = 0; i < kDispatches; ++i) {
+        device_table_.vkCmdDispatch(table_buffer, 1, 1, 1);
+      }
+      CheckResult(device_table_.vkEndCommandBuffer(table_buffer),
+                  "vkEndCommandBuffer");
+    });
+
+    std::cerr << "Call overhead benchmark (ns per call, loader vs device "
+                 "table):"
+              << std::endl
+              << "  vkQueueSubmit\t" << loader_submit << "\t" << table_submit
+              << "\t(" << kBatchSize << " per fence wait)" << std::endl
+              << "  vkCmdDispatch\t" << loader_dispatch << "\t"
+              << table_dispatch << std::endl;
+  }
+
   static VKAPI_ATTR VkBool32 VKAPI_CALL DebugReportCallback(
       VkDebugReportFlagsEXT /* flags */,
       VkDebugReportObjectTypeEXT /* objectType */, uint64_t /* object */,
-      size_t /* location */, int32_t /* messageCode */,
-      const char *pLayerPrefix, const char *pMessage, void * /* pUserData */) {
+      size_t /* location */, int32_t messageCode, const char *pLayerPrefix,
+      const char *pMessage, void *pUserData) {
+    if (pUserData != nullptr) {
+      static_cast<async_log::Logger *>(pUserData)->Log(
+          messageCode, pLayerPrefix, pMessage);
+      return VK_FALSE;
+    }
     std::cerr << "\033[1;36m" << pLayerPrefix << ": "
               << "\033[0m" << pMessage << std::endl;
     return VK_FALSE;
@@ -349,9 +1685,16 @@ class MandelbrotApp {
 
   uint32_t FindMemoryType(int32_t memory_type_bits,
                           const vk::MemoryPropertyFlags &properties) {
+    /* The profiled host-visible type, if the resource can live there. */
+    if (properties == (vk::MemoryPropertyFlagBits::eHostCoherent |
+                       vk::MemoryPropertyFlagBits::eHostVisible) and
+        profile_cached_ and
+        (memory_type_bits & (1u << profile_.memory_type_index))) {
+      return profile_.memory_type_index;
+    }
     auto memory_properties = physical_device_.getMemoryProperties();
     for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
-      if ((memory_type_bits & (1 << i)) and
+      if ((memory_type_bits & (1u << i)) and
           ((memory_properties.memoryTypes[i].propertyFlags & properties) ==
            properties)) {
         return i;
@@ -371,23 +1714,19 @@ class MandelbrotApp {
         "Could not find a queue family with compute capabilities.");
   }
 
-  static std::vector<uint32_t> ReadFile(const char *filename) {
-    std::ifstream infile(filename, std::ifstream::binary | std::ifstream::ate);
-    if (not infile.good()) {
-      throw std::runtime_error(std::string(filename) + ": no such file.");
-    }
-    size_t file_size = infile.tellg();
-    size_t file_size_padded = size_t(std::ceil(file_size / 4.0)) * 4;
-    infile.seekg(0);
-    std::vector<uint32_t> data(file_size_padded, 0);
-    infile.read(reinterpret_cast<char *>(data.data()), file_size);
-    return data;
-  }
-
  private:
+  Options options_;
+
+  /* Production diagnostics; outlives every Vulkan object below. */
+  std::unique_ptr<async_log::Logger> log_;
+
   std::vector<const char *> enabled_layers_;
   std::vector<const char *> enabled_extensions_;
 
+  /* What was probed, or loaded from options_.device_profile. */
+  device_profile::Profile profile_;
+  bool profile_cached_ = false;
+
   vk::UniqueInstance instance_;
   vk::UniqueDebugReportCallbackEXT debug_report_callback_;
 
@@ -397,25 +1736,303 @@ class MandelbrotApp {
   vk::UniqueDevice device_;
   vk::Queue queue_;
 
+  /* Declared before every resource placed in its memory. */
+  std::unique_ptr<device_memory::Allocator> allocator_;
+
+  vk::DeviceSize buffer_size_ = 0;
   vk::UniqueBuffer buffer_;
-  vk::UniqueDeviceMemory buffer_memory_;
+  device_memory::Allocation buffer_memory_;
+
+  /* Histogram coloring only; see CreateHistogramBuffers(). */
+  vk::UniqueBuffer counts_buffer_;
+  device_memory::Allocation counts_memory_;
+  vk::UniqueBuffer histogram_buffer_;
+  device_memory::Allocation histogram_memory_;
+
+  std::vector<TileDescriptor> tiles_;
+  /* Recorded with the dispatch: the image's view, for its kernel. */
+  std::vector<char> push_constants_;
+  /* The tiles of the batch being rendered, offsets relative to its arena. */
+  std::vector<TileDescriptor> batch_tiles_;
+  vk::DeviceSize tile_buffer_size_ = 0;
+  vk::UniqueBuffer tile_buffer_;
+  device_memory::Allocation tile_buffer_memory_;
 
   vk::UniqueDescriptorSetLayout descriptor_set_layout_;
   vk::UniqueDescriptorPool descriptor_pool_;
   std::vector<vk::DescriptorSet> descriptor_sets_;
+  size_t next_descriptor_set_ = 0;
+  vk::DescriptorSet bound_descriptor_set_;
+  std::vector<vk::DescriptorBufferInfo> buffer_bindings_;
+  bool push_descriptors_ = false;
+  /* VK_EXT_memory_budget is enabled. */
+  bool memory_budget_ = false;
 
-  vk::UniqueShaderModule compute_shader_module_;
+  /* Created on first use; see ShaderModule(). */
+  std::mutex shader_modules_mutex_;
+  std::map<std::string, vk::UniqueShaderModule> shader_modules_;
   vk::UniquePipelineLayout pipeline_layout_;
-  vk::UniquePipeline pipeline_;
+  vk::UniquePipelineCache pipeline_cache_;
+
+  /* A pipeline once its task has finished; see QueuePipeline(). */
+  struct PipelineVariant {
+    warm_up::Pool::Task task = 0;
+    vk::UniquePipeline pipeline;
+  };
+  /* Keyed by entries of the kernels table, which are never copied. */
+  std::map<std::pair<const kernels::Kernel *, kernels::Specialization>,
+           PipelineVariant>
+      pipelines_;
+  /* Declared after everything its tasks touch, so it stops first. */
+  std::unique_ptr<warm_up::Pool> warm_up_;
+  /* The pipeline the current job records. */
+  vk::Pipeline pipeline_;
+  /* Recorded after it with histogram coloring, in kHistogramPasses order. */
+  std::vector<vk::Pipeline> histogram_passes_;
 
   vk::UniqueCommandPool command_pool_;
   std::vector<vk::UniqueCommandBuffer> command_buffers_;
+
+  std::unique_ptr<frame_ring::Producer> frame_ring_;
+
+  /* Entry points of device_, bypassing the loader; see vulkan_ext.h. */
+  VkExtDeviceTable device_table_ = {};
 };
 
-int main() {
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  bool format_set = false;
+  bool output_set = false;
+  bool center_set = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 8, "--tiles=") == 0) {
+      if (std::sscanf(arg.c_str() + 8, "%ux%u", &options.tile_columns,
+                      &options.tile_rows) != 2 or
+          options.tile_columns == 0 or options.tile_rows == 0) {
+        throw std::runtime_error(arg + ": expected --tiles=COLUMNSxROWS.");
+      }
+      if (options.tile_columns > uint32_t(kWidth) or
+          options.tile_rows > uint32_t(kHeight)) {
+        throw std::runtime_error(arg + ": at most " + std::to_string(kWidth) +
+                                 "x" + std::to_string(kHeight) +
+                                 " tiles, one per pixel.");
+      }
+    } else if (arg.compare(0, 9, "--output=") == 0) {
+      options.output = arg.substr(9);
+      output_set = true;
+      if (not format_set) {
+        options.format = image_writers::FormatFromFilename(options.output);
+      }
+    } else if (arg.compare(0, 9, "--format=") == 0) {
+      if (not image_writers::ParseFormat(arg.substr(9), &options.format)) {
+        throw std::runtime_error(
+            arg + ": expected png, fastpng, qoi, ppm, pam or raw.");
+      }
+      format_set = true;
+      if (options.format == image_writers::Format::kRaw and not output_set) {
+        options.output = "-";
+      }
+    } else if (arg == "--benchmark-writers") {
+      options.benchmark_writers = true;
+    } else if (arg == "--benchmark-submit") {
+      options.benchmark_submit = true;
+    } else if (arg == "--profile=debug") {
+      options.profile = Profile::kDebug;
+    } else if (arg == "--profile=production") {
+      options.profile = Profile::kProduction;
+    } else if (arg.compare(0, 17, "--max-iterations=") == 0) {
+      options.specialization.max_iterations = std::stoul(arg.substr(17));
+      if (options.specialization.max_iterations == 0) {
+        throw std::runtime_error("--max-iterations must be at least 1.");
+      }
+    } else if (arg == "--coloring=palette") {
+      options.specialization.coloring = kernels::Coloring::kCosinePalette;
+    } else if (arg == "--coloring=grayscale") {
+      options.specialization.coloring = kernels::Coloring::kGrayscale;
+    } else if (arg.compare(0, 14, "--supersample=") == 0) {
+      options.specialization.supersampling = std::stoul(arg.substr(14));
+      if (options.specialization.supersampling < 1 or
+          options.specialization.supersampling > kMaxSupersampling) {
+        throw std::runtime_error(arg + ": expected 1 to " +
+                                 std::to_string(kMaxSupersampling) + ".");
+      }
+    } else if (arg == "--histogram") {
+      options.specialization.histogram = true;
+    } else if (arg == "--interior-check") {
+      options.specialization.interior_check = true;
+    } else if (arg == "--periodicity") {
+      options.specialization.periodicity = true;
+    } else if (arg.compare(0, 18, "--warm-up-threads=") == 0) {
+      options.warm_up_threads = std::stoul(arg.substr(18));
+    } else if (arg == "--warm-up") {
+      options.warm_up_variants = true;
+    } else if (arg == "--health-check") {
+      options.health_check = true;
+    } else if (arg == "--memory-stats") {
+      options.memory_stats = true;
+    } else if (arg.compare(0, 16, "--memory-budget=") == 0) {
+      options.memory_fraction = std::stod(arg.substr(16));
+      if (not(options.memory_fraction > 0.0 and
+              options.memory_fraction <= 1.0)) {
+        throw std::runtime_error(arg + ": expected a fraction in (0, 1].");
+      }
+    } else if (arg == "--no-push-descriptors") {
+      options.push_descriptors = false;
+    } else if (arg.compare(0, 17, "--device-profile=") == 0 and
+               arg.size() > 17) {
+      options.device_profile = arg.substr(17);
+    } else if (arg == "--startup-timing") {
+      options.startup_timing = true;
+    } else if (arg.compare(0, 6, "--shm=") == 0 and arg.size() > 6) {
+      options.shm_name = arg[6] == '/' ? arg.substr(6) : "/" + arg.substr(6);
+    } else if (arg == "--coordinator") {
+      options.coordinator = true;
+    } else if (arg.compare(0, 14, "--coordinator=") == 0) {
+      options.coordinator = true;
+      options.coordinator_options.port =
+          static_cast<uint16_t>(std::stoul(arg.substr(14)));
+    } else if (arg.compare(0, 16, "--spawn-workers=") == 0) {
+      options.coordinator = true;
+      options.coordinator_options.spawn_workers = std::stoul(arg.substr(16));
+    } else if (arg.compare(0, 7, "--size=") == 0) {
+      if (std::sscanf(arg.c_str() + 7, "%ux%u", &options.width,
+                      &options.height) != 2 or
+          options.width == 0 or options.height == 0) {
+        throw std::runtime_error(arg + ": expected --size=WIDTHxHEIGHT.");
+      }
+    } else if (arg.compare(0, 12, "--band-rows=") == 0) {
+      options.band_rows = std::stoul(arg.substr(12));
+    } else if (arg.compare(0, 9, "--worker=") == 0 and arg.size() > 9) {
+      options.worker_address = arg.substr(9);
+    } else if (arg.compare(0, 17, "--worker-threads=") == 0) {
+      options.worker_threads = std::stoul(arg.substr(17));
+    } else if (arg.compare(0, 12, "--multibrot=") == 0) {
+      options.specialization.family = kernels::Family::kMultibrot;
+      options.specialization.exponent = std::stoul(arg.substr(12));
+      if (options.specialization.exponent < kernels::kMinExponent or
+          options.specialization.exponent > kernels::kMaxExponent) {
+        throw std::runtime_error(arg + ": expected an exponent from " +
+                                 std::to_string(kernels::kMinExponent) +
+                                 " to " +
+                                 std::to_string(kernels::kMaxExponent) + ".");
+      }
+    } else if (arg.compare(0, 8, "--julia=") == 0) {
+      options.specialization.family = kernels::Family::kJulia;
+      if (std::sscanf(arg.c_str() + 8, "%f,%f",
+                      &options.specialization.julia_x,
+                      &options.specialization.julia_y) != 2) {
+        throw std::runtime_error(arg + ": expected --julia=X,Y.");
+      }
+    } else if (arg == "--burning-ship") {
+      options.specialization.family = kernels::Family::kBurningShip;
+    } else if (arg.compare(0, 9, "--center=") == 0) {
+      if (std::sscanf(arg.c_str() + 9, "%lf,%lf", &options.center_x,
+                      &options.center_y) != 2) {
+        throw std::runtime_error(arg + ": expected --center=X,Y.");
+      }
+      center_set = true;
+    } else if (arg.compare(0, 7, "--zoom=") == 0) {
+      options.zoom = std::stod(arg.substr(7));
+      if (not(options.zoom > 0.0)) {
+        throw std::runtime_error("--zoom must be positive.");
+      }
+    } else if (arg.compare(0, 16, "--cpu-precision=") == 0) {
+      if (not cpu_renderer::ParsePrecision(arg.substr(16),
+                                           &options.cpu_precision)) {
+        throw std::runtime_error(arg +
+                                 ": expected auto, float, double, fixed64, "
+                                 "double-double, fixed128 or float128.");
+      }
+      if (not cpu_renderer::IsAvailable(options.cpu_precision)) {
+        throw std::runtime_error(arg + ": not available in this build.");
+      }
+    } else if (arg.compare(0, 12, "--cpu-lanes=") == 0) {
+      options.cpu_lanes = std::stoul(arg.substr(12));
+      if (std::find(std::begin(cpu_renderer::kLaneCounts),
+                    std::end(cpu_renderer::kLaneCounts),
+                    options.cpu_lanes) == std::end(cpu_renderer::kLaneCounts)) {
+        throw std::runtime_error(arg + ": expected 1, 4, 8 or 16.");
+      }
+    } else if (arg == "--benchmark-cpu") {
+      options.benchmark_cpu = true;
+    } else if (arg == "--validate") {
+      options.validate = true;
+    } else {
+      throw std::runtime_error(arg + ": unknown option.");
+    }
+  }
+  if (options.specialization.family != kernels::Family::kMandelbrot) {
+    if (not center_set) {
+      bool ship = options.specialization.family ==
+                  kernels::Family::kBurningShip;
+      options.center_x = ship ? -0.5 : 0.0;
+      options.center_y = ship ? -0.55 : 0.0;
+    }
+    options.view_span = kFamilyViewSpan;
+  }
+  if (not options.shm_name.empty()) {
+    if (options.tile_columns > 0) {
+      throw std::runtime_error("--shm cannot be combined with --tiles.");
+    }
+    options.write_file = output_set;
+  }
+  bool supersampled = options.specialization.supersampling > 1;
+  if (options.validate and
+      (options.tile_columns > 0 or options.specialization.histogram or
+       supersampled or
+       options.specialization.coloring != kernels::Coloring::kCosinePalette)) {
+    throw std::runtime_error(
+        "--validate checks a single image with the cosine palette, one "
+        "sample per pixel.");
+  }
+  if (options.specialization.histogram and options.tile_columns > 0) {
+    throw std::runtime_error("--histogram colors a single image, not tiles.");
+  }
+  if (supersampled and options.tile_columns > 0) {
+    throw std::runtime_error(
+        "--supersample renders a single image, not tiles.");
+  }
+  if (options.coordinator) {
+    if (format_set and options.format != image_writers::Format::kPng and
+        options.format != image_writers::Format::kFastPng) {
+      throw std::runtime_error("--coordinator writes PNG only.");
+    }
+    if (options.tile_columns > 0 or not options.shm_name.empty() or
+        not options.worker_address.empty() or
+        options.specialization.histogram or supersampled) {
+      throw std::runtime_error(
+          "--coordinator cannot be combined with --tiles, --shm, --worker, "
+          "--histogram or --supersample.");
+    }
+    /* Workers get no coloring or early-outs: see distributed::RenderJob. */
+    if (options.specialization.coloring !=
+            kernels::Coloring::kCosinePalette or
+        options.specialization.interior_check or
+        options.specialization.periodicity or options.validate) {
+      throw std::runtime_error(
+          "--coordinator renders with the cosine palette and no early-outs; "
+          "it cannot be combined with --coloring=grayscale, "
+          "--interior-check, --periodicity or --validate.");
+    }
+    if (options.band_rows == 0) {
+      throw std::runtime_error("--band-rows must be at least 1.");
+    }
+  }
+  return options;
+}
+
+int main(int argc, char **argv) {
   MandelbrotApp app;
   try {
-    app.Run();
+    Options options = ParseOptions(argc, argv);
+    if (options.benchmark_cpu) {
+      BenchmarkCpuKernels(options);
+    } else if (options.coordinator or not options.worker_address.empty()) {
+      RunDistributed(options);
+    } else {
+      app.Run(options);
+    }
   } catch (std::exception &e) {
     std::cerr << e.what() << std::endl;
     return 1;
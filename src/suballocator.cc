@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "suballocator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace suballocator {
+
+FreeList::FreeList(uint64_t size, uint64_t granularity)
+    : size_(size), granularity_(std::max<uint64_t>(granularity, 1)) {
+  ranges_[0] = {size, true, true};
+}
+
+bool FreeList::Allocate(uint64_t size, uint64_t alignment, bool linear,
+                        uint64_t *offset) {
+  if (size == 0) {
+    size = 1;
+  }
+  for (auto it = ranges_.begin(); it != ranges_.end(); ++it) {
+    if (not it->second.free or it->second.size < size) {
+      continue;
+    }
+    uint64_t range_end = it->first + it->second.size;
+    uint64_t start = AlignUp(it->first, alignment);
+    /* Free ranges are coalesced, so the neighbors are allocated. */
+    if (it != ranges_.begin()) {
+      auto previous = std::prev(it);
+      if (previous->second.linear != linear and
+          SamePage(it->first - 1, start)) {
+        start = AlignUp(start, granularity_);
+      }
+    }
+    uint64_t end = start + size;
+    if (end > range_end) {
+      continue;
+    }
+    auto next = std::next(it);
+    if (next != ranges_.end() and next->second.linear != linear and
+        SamePage(end - 1, next->first)) {
+      continue;
+    }
+    /* Split into [it->first, start) free, [start, end), [end, range_end). */
+    if (end < range_end) {
+      ranges_[end] = {range_end - end, true, true};
+    }
+    if (start > it->first) {
+      it->second.size = start - it->first;
+      ranges_[start] = {size, false, linear};
+    } else {
+      it->second = {size, false, linear};
+    }
+    used_ += size;
+    ++allocations_;
+    *offset = start;
+    return true;
+  }
+  return false;
+}
+
+void FreeList::Free(uint64_t offset) {
+  auto it = ranges_.find(offset);
+  if (it == ranges_.end() or it->second.free) {
+    throw std::invalid_argument("FreeList::Free: no allocation at offset.");
+  }
+  used_ -= it->second.size;
+  --allocations_;
+  it->second.free = true;
+  auto next = std::next(it);
+  if (next != ranges_.end() and next->second.free) {
+    it->second.size += next->second.size;
+    ranges_.erase(next);
+  }
+  if (it != ranges_.begin()) {
+    auto previous = std::prev(it);
+    if (previous->second.free) {
+      previous->second.size += it->second.size;
+      ranges_.erase(it);
+    }
+  }
+}
+
+uint64_t FreeList::largest_free() const {
+  uint64_t largest = 0;
+  for (const auto &range : ranges_) {
+    if (range.second.free) {
+      largest = std::max(largest, range.second.size);
+    }
+  }
+  return largest;
+}
+
+bool Ring::Allocate(uint64_t size, uint64_t alignment, uint64_t *offset) {
+  if (used_ == 0) {
+    head_ = tail_ = 0;
+  }
+  uint64_t start = AlignUp(head_, alignment);
+  uint64_t consumed;
+  if (head_ >= tail_ and used_ < size_) {
+    /* Free space is [head_, size_) and then [0, tail_). */
+    if (start + size <= size_) {
+      consumed = start + size - head_;
+    } else if (size <= tail_) {
+      start = 0;
+      consumed = size_ - head_ + size;
+    } else {
+      return false;
+    }
+  } else {
+    /* Free space is [head_, tail_). */
+    if (start + size > tail_ or used_ == size_) {
+      return false;
+    }
+    consumed = start + size - head_;
+  }
+  head_ = start + size;
+  used_ += consumed;
+  frame_bytes_ += consumed;
+  *offset = start;
+  return true;
+}
+
+void Ring::EndFrame() {
+  frames_.push_back({head_, frame_bytes_});
+  frame_bytes_ = 0;
+}
+
+void Ring::RetireFrame() {
+  if (frames_.empty()) {
+    return;
+  }
+  /* An empty frame's end may predate the reset in Allocate(). */
+  if (frames_.front().bytes > 0) {
+    tail_ = frames_.front().end;
+    used_ -= frames_.front().bytes;
+  }
+  frames_.pop_front();
+}
+
+}  // namespace suballocator
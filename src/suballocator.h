@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SUBALLOCATOR_H
+#define SUBALLOCATOR_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+
+/*
+ * Offset bookkeeping for carving many resources out of one large memory
+ * block. Nothing here touches Vulkan: device_memory.h owns the blocks and
+ * uses these to place resources inside them. Neither class is thread-safe.
+ */
+namespace suballocator {
+
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return alignment > 1 ? (value + alignment - 1) / alignment * alignment
+                       : value;
+}
+
+/*
+ * First-fit allocation with coalescing on free, for long-lived resources.
+ *
+ * Linear resources (buffers, linear images) and non-linear ones (optimal
+ * images) may not share a page of bufferImageGranularity bytes, so an
+ * allocation next to a resource of the other kind is padded onto its own
+ * page.
+ */
+class FreeList {
+ public:
+  FreeList(uint64_t size, uint64_t granularity);
+
+  /* Places size bytes at a multiple of alignment; false if nothing fits. */
+  bool Allocate(uint64_t size, uint64_t alignment, bool linear,
+                uint64_t *offset);
+  /* Releases the allocation at offset, as returned by Allocate(). */
+  void Free(uint64_t offset);
+
+  uint64_t size() const { return size_; }
+  /* Bytes handed out, excluding alignment padding. */
+  uint64_t used() const { return used_; }
+  uint32_t allocations() const { return allocations_; }
+  uint64_t largest_free() const;
+
+ private:
+  struct Range {
+    uint64_t size;
+    bool free;
+    bool linear;
+  };
+
+  bool SamePage(uint64_t a, uint64_t b) const {
+    return a / granularity_ == b / granularity_;
+  }
+
+  uint64_t size_;
+  uint64_t granularity_;
+  uint64_t used_ = 0;
+  uint32_t allocations_ = 0;
+  /* Ranges by offset, covering [0, size_) without gaps. */
+  std::map<uint64_t, Range> ranges_;
+};
+
+/*
+ * Ring allocation for per-frame staging data. Allocations are grouped into
+ * frames by EndFrame(), and a whole frame is released at once by
+ * RetireFrame() when the GPU is done with it, oldest first. Allocating is a
+ * pointer bump; nothing is freed individually.
+ */
+class Ring {
+ public:
+  explicit Ring(uint64_t size) : size_(size) {}
+
+  bool Allocate(uint64_t size, uint64_t alignment, uint64_t *offset);
+  /* Closes the current frame; later allocations belong to the next one. */
+  void EndFrame();
+  /* Releases the oldest closed frame, if any. */
+  void RetireFrame();
+
+  uint64_t size() const { return size_; }
+  /* Bytes held by live frames, including alignment and wrap padding. */
+  uint64_t used() const { return used_; }
+  uint32_t frames_in_flight() const { return frames_.size(); }
+
+ private:
+  struct Frame {
+    uint64_t end;
+    uint64_t bytes;
+  };
+
+  uint64_t size_;
+  uint64_t head_ = 0;  // next free byte
+  uint64_t tail_ = 0;  // first live byte
+  uint64_t used_ = 0;
+  uint64_t frame_bytes_ = 0;  // of the open frame
+  std::deque<Frame> frames_;
+};
+
+}  // namespace suballocator
+
+#endif
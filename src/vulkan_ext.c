@@ -20,6 +20,46 @@
 */
 
 #include <vulkan/vulkan.h>
+#include "vulkan_ext.h"
+
+/*
+** Entry points are resolved on their first call, not by vkExtInitInstance and
+** vkExtInitDevice: those only record where to resolve from and forget what was
+** resolved before. A headless compute program calls a handful of the entry
+** points below, so it pays for a handful of lookups instead of all of them.
+**
+** Resolving is idempotent, so threads racing on a first call all look up and
+** store the same pointer; the atomic loads and stores keep any of them from
+** seeing a torn one. Only the first call of each entry point pays a lookup.
+*/
+static VkInstance vkExtInstance;
+static VkDevice vkExtDevice;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VK_EXT_LOAD(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define VK_EXT_STORE(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELEASE)
+#else
+/* Aligned pointer-sized loads and stores are atomic on every MSVC target. */
+#define VK_EXT_LOAD(var) (*(void* volatile*)&(var))
+#define VK_EXT_STORE(var, value) (*(void* volatile*)&(var) = (void*)(value))
+#endif
+
+static PFN_vkVoidFunction vkExtGetProcAddr(const char* name)
+{
+    VkDevice device = VK_EXT_LOAD(vkExtDevice);
+    if (device != VK_NULL_HANDLE)
+        return vkGetDeviceProcAddr(device, name);
+    return vkGetInstanceProcAddr(VK_EXT_LOAD(vkExtInstance), name);
+}
+
+#define VK_EXT_RESOLVE(name) \
+    PFN_##name pfn = (PFN_##name)VK_EXT_LOAD(pfn_##name); \
+    if (pfn == NULL) { \
+        pfn = (PFN_##name)vkExtGetProcAddr(#name); \
+        VK_EXT_STORE(pfn_##name, pfn); \
+    }
+
+#define VK_EXT_RESET(name) VK_EXT_STORE(pfn_##name, NULL)
 
 #ifdef VK_KHR_surface
 static PFN_vkDestroySurfaceKHR pfn_vkDestroySurfaceKHR;
@@ -28,7 +68,8 @@ void vkDestroySurfaceKHR(
     VkSurfaceKHR                                surface,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroySurfaceKHR(
+    VK_EXT_RESOLVE(vkDestroySurfaceKHR)
+    pfn(
         instance,
         surface,
         pAllocator
@@ -42,7 +83,8 @@ VkResult vkGetPhysicalDeviceSurfaceSupportKHR(
     VkSurfaceKHR                                surface,
     VkBool32*                                   pSupported)
 {
-    return pfn_vkGetPhysicalDeviceSurfaceSupportKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfaceSupportKHR)
+    return pfn(
         physicalDevice,
         queueFamilyIndex,
         surface,
@@ -56,7 +98,8 @@ VkResult vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
     VkSurfaceKHR                                surface,
     VkSurfaceCapabilitiesKHR*                   pSurfaceCapabilities)
 {
-    return pfn_vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfaceCapabilitiesKHR)
+    return pfn(
         physicalDevice,
         surface,
         pSurfaceCapabilities
@@ -70,7 +113,8 @@ VkResult vkGetPhysicalDeviceSurfaceFormatsKHR(
     uint32_t*                                   pSurfaceFormatCount,
     VkSurfaceFormatKHR*                         pSurfaceFormats)
 {
-    return pfn_vkGetPhysicalDeviceSurfaceFormatsKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfaceFormatsKHR)
+    return pfn(
         physicalDevice,
         surface,
         pSurfaceFormatCount,
@@ -85,7 +129,8 @@ VkResult vkGetPhysicalDeviceSurfacePresentModesKHR(
     uint32_t*                                   pPresentModeCount,
     VkPresentModeKHR*                           pPresentModes)
 {
-    return pfn_vkGetPhysicalDeviceSurfacePresentModesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfacePresentModesKHR)
+    return pfn(
         physicalDevice,
         surface,
         pPresentModeCount,
@@ -102,7 +147,8 @@ VkResult vkCreateSwapchainKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSwapchainKHR*                             pSwapchain)
 {
-    return pfn_vkCreateSwapchainKHR(
+    VK_EXT_RESOLVE(vkCreateSwapchainKHR)
+    return pfn(
         device,
         pCreateInfo,
         pAllocator,
@@ -116,7 +162,8 @@ void vkDestroySwapchainKHR(
     VkSwapchainKHR                              swapchain,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroySwapchainKHR(
+    VK_EXT_RESOLVE(vkDestroySwapchainKHR)
+    pfn(
         device,
         swapchain,
         pAllocator
@@ -130,7 +177,8 @@ VkResult vkGetSwapchainImagesKHR(
     uint32_t*                                   pSwapchainImageCount,
     VkImage*                                    pSwapchainImages)
 {
-    return pfn_vkGetSwapchainImagesKHR(
+    VK_EXT_RESOLVE(vkGetSwapchainImagesKHR)
+    return pfn(
         device,
         swapchain,
         pSwapchainImageCount,
@@ -147,7 +195,8 @@ VkResult vkAcquireNextImageKHR(
     VkFence                                     fence,
     uint32_t*                                   pImageIndex)
 {
-    return pfn_vkAcquireNextImageKHR(
+    VK_EXT_RESOLVE(vkAcquireNextImageKHR)
+    return pfn(
         device,
         swapchain,
         timeout,
@@ -162,7 +211,8 @@ VkResult vkQueuePresentKHR(
     VkQueue                                     queue,
     const VkPresentInfoKHR*                     pPresentInfo)
 {
-    return pfn_vkQueuePresentKHR(
+    VK_EXT_RESOLVE(vkQueuePresentKHR)
+    return pfn(
         queue,
         pPresentInfo
     );
@@ -176,7 +226,8 @@ VkResult vkGetPhysicalDeviceDisplayPropertiesKHR(
     uint32_t*                                   pPropertyCount,
     VkDisplayPropertiesKHR*                     pProperties)
 {
-    return pfn_vkGetPhysicalDeviceDisplayPropertiesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceDisplayPropertiesKHR)
+    return pfn(
         physicalDevice,
         pPropertyCount,
         pProperties
@@ -189,7 +240,8 @@ VkResult vkGetPhysicalDeviceDisplayPlanePropertiesKHR(
     uint32_t*                                   pPropertyCount,
     VkDisplayPlanePropertiesKHR*                pProperties)
 {
-    return pfn_vkGetPhysicalDeviceDisplayPlanePropertiesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceDisplayPlanePropertiesKHR)
+    return pfn(
         physicalDevice,
         pPropertyCount,
         pProperties
@@ -203,7 +255,8 @@ VkResult vkGetDisplayPlaneSupportedDisplaysKHR(
     uint32_t*                                   pDisplayCount,
     VkDisplayKHR*                               pDisplays)
 {
-    return pfn_vkGetDisplayPlaneSupportedDisplaysKHR(
+    VK_EXT_RESOLVE(vkGetDisplayPlaneSupportedDisplaysKHR)
+    return pfn(
         physicalDevice,
         planeIndex,
         pDisplayCount,
@@ -218,7 +271,8 @@ VkResult vkGetDisplayModePropertiesKHR(
     uint32_t*                                   pPropertyCount,
     VkDisplayModePropertiesKHR*                 pProperties)
 {
-    return pfn_vkGetDisplayModePropertiesKHR(
+    VK_EXT_RESOLVE(vkGetDisplayModePropertiesKHR)
+    return pfn(
         physicalDevice,
         display,
         pPropertyCount,
@@ -234,7 +288,8 @@ VkResult vkCreateDisplayModeKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkDisplayModeKHR*                           pMode)
 {
-    return pfn_vkCreateDisplayModeKHR(
+    VK_EXT_RESOLVE(vkCreateDisplayModeKHR)
+    return pfn(
         physicalDevice,
         display,
         pCreateInfo,
@@ -250,7 +305,8 @@ VkResult vkGetDisplayPlaneCapabilitiesKHR(
     uint32_t                                    planeIndex,
     VkDisplayPlaneCapabilitiesKHR*              pCapabilities)
 {
-    return pfn_vkGetDisplayPlaneCapabilitiesKHR(
+    VK_EXT_RESOLVE(vkGetDisplayPlaneCapabilitiesKHR)
+    return pfn(
         physicalDevice,
         mode,
         planeIndex,
@@ -265,7 +321,8 @@ VkResult vkCreateDisplayPlaneSurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateDisplayPlaneSurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateDisplayPlaneSurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -283,7 +340,8 @@ VkResult vkCreateSharedSwapchainsKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSwapchainKHR*                             pSwapchains)
 {
-    return pfn_vkCreateSharedSwapchainsKHR(
+    VK_EXT_RESOLVE(vkCreateSharedSwapchainsKHR)
+    return pfn(
         device,
         swapchainCount,
         pCreateInfos,
@@ -302,7 +360,8 @@ VkResult vkCreateXlibSurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateXlibSurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateXlibSurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -317,7 +376,8 @@ VkBool32 vkGetPhysicalDeviceXlibPresentationSupportKHR(
     Display*                                    dpy,
     VisualID                                    visualID)
 {
-    return pfn_vkGetPhysicalDeviceXlibPresentationSupportKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceXlibPresentationSupportKHR)
+    return pfn(
         physicalDevice,
         queueFamilyIndex,
         dpy,
@@ -336,7 +396,8 @@ VkResult vkCreateXcbSurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateXcbSurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateXcbSurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -351,7 +412,8 @@ VkBool32 vkGetPhysicalDeviceXcbPresentationSupportKHR(
     xcb_connection_t*                           connection,
     xcb_visualid_t                              visual_id)
 {
-    return pfn_vkGetPhysicalDeviceXcbPresentationSupportKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceXcbPresentationSupportKHR)
+    return pfn(
         physicalDevice,
         queueFamilyIndex,
         connection,
@@ -370,7 +432,8 @@ VkResult vkCreateWaylandSurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateWaylandSurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateWaylandSurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -384,7 +447,8 @@ VkBool32 vkGetPhysicalDeviceWaylandPresentationSupportKHR(
     uint32_t                                    queueFamilyIndex,
     struct wl_display*                          display)
 {
-    return pfn_vkGetPhysicalDeviceWaylandPresentationSupportKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceWaylandPresentationSupportKHR)
+    return pfn(
         physicalDevice,
         queueFamilyIndex,
         display
@@ -402,7 +466,8 @@ VkResult vkCreateMirSurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateMirSurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateMirSurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -416,7 +481,8 @@ VkBool32 vkGetPhysicalDeviceMirPresentationSupportKHR(
     uint32_t                                    queueFamilyIndex,
     MirConnection*                              connection)
 {
-    return pfn_vkGetPhysicalDeviceMirPresentationSupportKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceMirPresentationSupportKHR)
+    return pfn(
         physicalDevice,
         queueFamilyIndex,
         connection
@@ -434,7 +500,8 @@ VkResult vkCreateAndroidSurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateAndroidSurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateAndroidSurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -453,7 +520,8 @@ VkResult vkCreateWin32SurfaceKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateWin32SurfaceKHR(
+    VK_EXT_RESOLVE(vkCreateWin32SurfaceKHR)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -466,7 +534,8 @@ VkBool32 vkGetPhysicalDeviceWin32PresentationSupportKHR(
     VkPhysicalDevice                            physicalDevice,
     uint32_t                                    queueFamilyIndex)
 {
-    return pfn_vkGetPhysicalDeviceWin32PresentationSupportKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceWin32PresentationSupportKHR)
+    return pfn(
         physicalDevice,
         queueFamilyIndex
     );
@@ -480,7 +549,8 @@ void vkGetPhysicalDeviceFeatures2KHR(
     VkPhysicalDevice                            physicalDevice,
     VkPhysicalDeviceFeatures2KHR*               pFeatures)
 {
-    pfn_vkGetPhysicalDeviceFeatures2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceFeatures2KHR)
+    pfn(
         physicalDevice,
         pFeatures
     );
@@ -491,7 +561,8 @@ void vkGetPhysicalDeviceProperties2KHR(
     VkPhysicalDevice                            physicalDevice,
     VkPhysicalDeviceProperties2KHR*             pProperties)
 {
-    pfn_vkGetPhysicalDeviceProperties2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceProperties2KHR)
+    pfn(
         physicalDevice,
         pProperties
     );
@@ -503,7 +574,8 @@ void vkGetPhysicalDeviceFormatProperties2KHR(
     VkFormat                                    format,
     VkFormatProperties2KHR*                     pFormatProperties)
 {
-    pfn_vkGetPhysicalDeviceFormatProperties2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceFormatProperties2KHR)
+    pfn(
         physicalDevice,
         format,
         pFormatProperties
@@ -516,7 +588,8 @@ VkResult vkGetPhysicalDeviceImageFormatProperties2KHR(
     const VkPhysicalDeviceImageFormatInfo2KHR*  pImageFormatInfo,
     VkImageFormatProperties2KHR*                pImageFormatProperties)
 {
-    return pfn_vkGetPhysicalDeviceImageFormatProperties2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceImageFormatProperties2KHR)
+    return pfn(
         physicalDevice,
         pImageFormatInfo,
         pImageFormatProperties
@@ -529,7 +602,8 @@ void vkGetPhysicalDeviceQueueFamilyProperties2KHR(
     uint32_t*                                   pQueueFamilyPropertyCount,
     VkQueueFamilyProperties2KHR*                pQueueFamilyProperties)
 {
-    pfn_vkGetPhysicalDeviceQueueFamilyProperties2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceQueueFamilyProperties2KHR)
+    pfn(
         physicalDevice,
         pQueueFamilyPropertyCount,
         pQueueFamilyProperties
@@ -541,7 +615,8 @@ void vkGetPhysicalDeviceMemoryProperties2KHR(
     VkPhysicalDevice                            physicalDevice,
     VkPhysicalDeviceMemoryProperties2KHR*       pMemoryProperties)
 {
-    pfn_vkGetPhysicalDeviceMemoryProperties2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceMemoryProperties2KHR)
+    pfn(
         physicalDevice,
         pMemoryProperties
     );
@@ -554,7 +629,8 @@ void vkGetPhysicalDeviceSparseImageFormatProperties2KHR(
     uint32_t*                                   pPropertyCount,
     VkSparseImageFormatProperties2KHR*          pProperties)
 {
-    pfn_vkGetPhysicalDeviceSparseImageFormatProperties2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSparseImageFormatProperties2KHR)
+    pfn(
         physicalDevice,
         pFormatInfo,
         pPropertyCount,
@@ -570,7 +646,8 @@ void vkTrimCommandPoolKHR(
     VkCommandPool                               commandPool,
     VkCommandPoolTrimFlagsKHR                   flags)
 {
-    pfn_vkTrimCommandPoolKHR(
+    VK_EXT_RESOLVE(vkTrimCommandPoolKHR)
+    pfn(
         device,
         commandPool,
         flags
@@ -585,7 +662,8 @@ void vkGetPhysicalDeviceExternalBufferPropertiesKHR(
     const VkPhysicalDeviceExternalBufferInfoKHR* pExternalBufferInfo,
     VkExternalBufferPropertiesKHR*              pExternalBufferProperties)
 {
-    pfn_vkGetPhysicalDeviceExternalBufferPropertiesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceExternalBufferPropertiesKHR)
+    pfn(
         physicalDevice,
         pExternalBufferInfo,
         pExternalBufferProperties
@@ -601,7 +679,8 @@ VkResult vkGetMemoryWin32HandleKHR(
     const VkMemoryGetWin32HandleInfoKHR*        pGetWin32HandleInfo,
     HANDLE*                                     pHandle)
 {
-    return pfn_vkGetMemoryWin32HandleKHR(
+    VK_EXT_RESOLVE(vkGetMemoryWin32HandleKHR)
+    return pfn(
         device,
         pGetWin32HandleInfo,
         pHandle
@@ -615,7 +694,8 @@ VkResult vkGetMemoryWin32HandlePropertiesKHR(
     HANDLE                                      handle,
     VkMemoryWin32HandlePropertiesKHR*           pMemoryWin32HandleProperties)
 {
-    return pfn_vkGetMemoryWin32HandlePropertiesKHR(
+    VK_EXT_RESOLVE(vkGetMemoryWin32HandlePropertiesKHR)
+    return pfn(
         device,
         handleType,
         handle,
@@ -632,7 +712,8 @@ VkResult vkGetMemoryFdKHR(
     const VkMemoryGetFdInfoKHR*                 pGetFdInfo,
     int*                                        pFd)
 {
-    return pfn_vkGetMemoryFdKHR(
+    VK_EXT_RESOLVE(vkGetMemoryFdKHR)
+    return pfn(
         device,
         pGetFdInfo,
         pFd
@@ -646,7 +727,8 @@ VkResult vkGetMemoryFdPropertiesKHR(
     int                                         fd,
     VkMemoryFdPropertiesKHR*                    pMemoryFdProperties)
 {
-    return pfn_vkGetMemoryFdPropertiesKHR(
+    VK_EXT_RESOLVE(vkGetMemoryFdPropertiesKHR)
+    return pfn(
         device,
         handleType,
         fd,
@@ -662,7 +744,8 @@ void vkGetPhysicalDeviceExternalSemaphorePropertiesKHR(
     const VkPhysicalDeviceExternalSemaphoreInfoKHR* pExternalSemaphoreInfo,
     VkExternalSemaphorePropertiesKHR*           pExternalSemaphoreProperties)
 {
-    pfn_vkGetPhysicalDeviceExternalSemaphorePropertiesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceExternalSemaphorePropertiesKHR)
+    pfn(
         physicalDevice,
         pExternalSemaphoreInfo,
         pExternalSemaphoreProperties
@@ -677,7 +760,8 @@ VkResult vkImportSemaphoreWin32HandleKHR(
     VkDevice                                    device,
     const VkImportSemaphoreWin32HandleInfoKHR*  pImportSemaphoreWin32HandleInfo)
 {
-    return pfn_vkImportSemaphoreWin32HandleKHR(
+    VK_EXT_RESOLVE(vkImportSemaphoreWin32HandleKHR)
+    return pfn(
         device,
         pImportSemaphoreWin32HandleInfo
     );
@@ -689,7 +773,8 @@ VkResult vkGetSemaphoreWin32HandleKHR(
     const VkSemaphoreGetWin32HandleInfoKHR*     pGetWin32HandleInfo,
     HANDLE*                                     pHandle)
 {
-    return pfn_vkGetSemaphoreWin32HandleKHR(
+    VK_EXT_RESOLVE(vkGetSemaphoreWin32HandleKHR)
+    return pfn(
         device,
         pGetWin32HandleInfo,
         pHandle
@@ -704,7 +789,8 @@ VkResult vkImportSemaphoreFdKHR(
     VkDevice                                    device,
     const VkImportSemaphoreFdInfoKHR*           pImportSemaphoreFdInfo)
 {
-    return pfn_vkImportSemaphoreFdKHR(
+    VK_EXT_RESOLVE(vkImportSemaphoreFdKHR)
+    return pfn(
         device,
         pImportSemaphoreFdInfo
     );
@@ -716,7 +802,8 @@ VkResult vkGetSemaphoreFdKHR(
     const VkSemaphoreGetFdInfoKHR*              pGetFdInfo,
     int*                                        pFd)
 {
-    return pfn_vkGetSemaphoreFdKHR(
+    VK_EXT_RESOLVE(vkGetSemaphoreFdKHR)
+    return pfn(
         device,
         pGetFdInfo,
         pFd
@@ -734,7 +821,8 @@ void vkCmdPushDescriptorSetKHR(
     uint32_t                                    descriptorWriteCount,
     const VkWriteDescriptorSet*                 pDescriptorWrites)
 {
-    pfn_vkCmdPushDescriptorSetKHR(
+    VK_EXT_RESOLVE(vkCmdPushDescriptorSetKHR)
+    pfn(
         commandBuffer,
         pipelineBindPoint,
         layout,
@@ -753,7 +841,8 @@ VkResult vkCreateDescriptorUpdateTemplateKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkDescriptorUpdateTemplateKHR*              pDescriptorUpdateTemplate)
 {
-    return pfn_vkCreateDescriptorUpdateTemplateKHR(
+    VK_EXT_RESOLVE(vkCreateDescriptorUpdateTemplateKHR)
+    return pfn(
         device,
         pCreateInfo,
         pAllocator,
@@ -767,7 +856,8 @@ void vkDestroyDescriptorUpdateTemplateKHR(
     VkDescriptorUpdateTemplateKHR               descriptorUpdateTemplate,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroyDescriptorUpdateTemplateKHR(
+    VK_EXT_RESOLVE(vkDestroyDescriptorUpdateTemplateKHR)
+    pfn(
         device,
         descriptorUpdateTemplate,
         pAllocator
@@ -781,7 +871,8 @@ void vkUpdateDescriptorSetWithTemplateKHR(
     VkDescriptorUpdateTemplateKHR               descriptorUpdateTemplate,
     const void*                                 pData)
 {
-    pfn_vkUpdateDescriptorSetWithTemplateKHR(
+    VK_EXT_RESOLVE(vkUpdateDescriptorSetWithTemplateKHR)
+    pfn(
         device,
         descriptorSet,
         descriptorUpdateTemplate,
@@ -797,7 +888,8 @@ void vkCmdPushDescriptorSetWithTemplateKHR(
     uint32_t                                    set,
     const void*                                 pData)
 {
-    pfn_vkCmdPushDescriptorSetWithTemplateKHR(
+    VK_EXT_RESOLVE(vkCmdPushDescriptorSetWithTemplateKHR)
+    pfn(
         commandBuffer,
         descriptorUpdateTemplate,
         layout,
@@ -813,7 +905,8 @@ VkResult vkGetSwapchainStatusKHR(
     VkDevice                                    device,
     VkSwapchainKHR                              swapchain)
 {
-    return pfn_vkGetSwapchainStatusKHR(
+    VK_EXT_RESOLVE(vkGetSwapchainStatusKHR)
+    return pfn(
         device,
         swapchain
     );
@@ -827,7 +920,8 @@ void vkGetPhysicalDeviceExternalFencePropertiesKHR(
     const VkPhysicalDeviceExternalFenceInfoKHR* pExternalFenceInfo,
     VkExternalFencePropertiesKHR*               pExternalFenceProperties)
 {
-    pfn_vkGetPhysicalDeviceExternalFencePropertiesKHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceExternalFencePropertiesKHR)
+    pfn(
         physicalDevice,
         pExternalFenceInfo,
         pExternalFenceProperties
@@ -842,7 +936,8 @@ VkResult vkImportFenceWin32HandleKHR(
     VkDevice                                    device,
     const VkImportFenceWin32HandleInfoKHR*      pImportFenceWin32HandleInfo)
 {
-    return pfn_vkImportFenceWin32HandleKHR(
+    VK_EXT_RESOLVE(vkImportFenceWin32HandleKHR)
+    return pfn(
         device,
         pImportFenceWin32HandleInfo
     );
@@ -854,7 +949,8 @@ VkResult vkGetFenceWin32HandleKHR(
     const VkFenceGetWin32HandleInfoKHR*         pGetWin32HandleInfo,
     HANDLE*                                     pHandle)
 {
-    return pfn_vkGetFenceWin32HandleKHR(
+    VK_EXT_RESOLVE(vkGetFenceWin32HandleKHR)
+    return pfn(
         device,
         pGetWin32HandleInfo,
         pHandle
@@ -869,7 +965,8 @@ VkResult vkImportFenceFdKHR(
     VkDevice                                    device,
     const VkImportFenceFdInfoKHR*               pImportFenceFdInfo)
 {
-    return pfn_vkImportFenceFdKHR(
+    VK_EXT_RESOLVE(vkImportFenceFdKHR)
+    return pfn(
         device,
         pImportFenceFdInfo
     );
@@ -881,7 +978,8 @@ VkResult vkGetFenceFdKHR(
     const VkFenceGetFdInfoKHR*                  pGetFdInfo,
     int*                                        pFd)
 {
-    return pfn_vkGetFenceFdKHR(
+    VK_EXT_RESOLVE(vkGetFenceFdKHR)
+    return pfn(
         device,
         pGetFdInfo,
         pFd
@@ -896,7 +994,8 @@ VkResult vkGetPhysicalDeviceSurfaceCapabilities2KHR(
     const VkPhysicalDeviceSurfaceInfo2KHR*      pSurfaceInfo,
     VkSurfaceCapabilities2KHR*                  pSurfaceCapabilities)
 {
-    return pfn_vkGetPhysicalDeviceSurfaceCapabilities2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfaceCapabilities2KHR)
+    return pfn(
         physicalDevice,
         pSurfaceInfo,
         pSurfaceCapabilities
@@ -910,7 +1009,8 @@ VkResult vkGetPhysicalDeviceSurfaceFormats2KHR(
     uint32_t*                                   pSurfaceFormatCount,
     VkSurfaceFormat2KHR*                        pSurfaceFormats)
 {
-    return pfn_vkGetPhysicalDeviceSurfaceFormats2KHR(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfaceFormats2KHR)
+    return pfn(
         physicalDevice,
         pSurfaceInfo,
         pSurfaceFormatCount,
@@ -926,7 +1026,8 @@ void vkGetImageMemoryRequirements2KHR(
     const VkImageMemoryRequirementsInfo2KHR*    pInfo,
     VkMemoryRequirements2KHR*                   pMemoryRequirements)
 {
-    pfn_vkGetImageMemoryRequirements2KHR(
+    VK_EXT_RESOLVE(vkGetImageMemoryRequirements2KHR)
+    pfn(
         device,
         pInfo,
         pMemoryRequirements
@@ -939,7 +1040,8 @@ void vkGetBufferMemoryRequirements2KHR(
     const VkBufferMemoryRequirementsInfo2KHR*   pInfo,
     VkMemoryRequirements2KHR*                   pMemoryRequirements)
 {
-    pfn_vkGetBufferMemoryRequirements2KHR(
+    VK_EXT_RESOLVE(vkGetBufferMemoryRequirements2KHR)
+    pfn(
         device,
         pInfo,
         pMemoryRequirements
@@ -953,7 +1055,8 @@ void vkGetImageSparseMemoryRequirements2KHR(
     uint32_t*                                   pSparseMemoryRequirementCount,
     VkSparseImageMemoryRequirements2KHR*        pSparseMemoryRequirements)
 {
-    pfn_vkGetImageSparseMemoryRequirements2KHR(
+    VK_EXT_RESOLVE(vkGetImageSparseMemoryRequirements2KHR)
+    pfn(
         device,
         pInfo,
         pSparseMemoryRequirementCount,
@@ -970,7 +1073,8 @@ VkResult vkCreateSamplerYcbcrConversionKHR(
     const VkAllocationCallbacks*                pAllocator,
     VkSamplerYcbcrConversionKHR*                pYcbcrConversion)
 {
-    return pfn_vkCreateSamplerYcbcrConversionKHR(
+    VK_EXT_RESOLVE(vkCreateSamplerYcbcrConversionKHR)
+    return pfn(
         device,
         pCreateInfo,
         pAllocator,
@@ -984,7 +1088,8 @@ void vkDestroySamplerYcbcrConversionKHR(
     VkSamplerYcbcrConversionKHR                 ycbcrConversion,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroySamplerYcbcrConversionKHR(
+    VK_EXT_RESOLVE(vkDestroySamplerYcbcrConversionKHR)
+    pfn(
         device,
         ycbcrConversion,
         pAllocator
@@ -999,7 +1104,8 @@ VkResult vkBindBufferMemory2KHR(
     uint32_t                                    bindInfoCount,
     const VkBindBufferMemoryInfoKHR*            pBindInfos)
 {
-    return pfn_vkBindBufferMemory2KHR(
+    VK_EXT_RESOLVE(vkBindBufferMemory2KHR)
+    return pfn(
         device,
         bindInfoCount,
         pBindInfos
@@ -1012,7 +1118,8 @@ VkResult vkBindImageMemory2KHR(
     uint32_t                                    bindInfoCount,
     const VkBindImageMemoryInfoKHR*             pBindInfos)
 {
-    return pfn_vkBindImageMemory2KHR(
+    VK_EXT_RESOLVE(vkBindImageMemory2KHR)
+    return pfn(
         device,
         bindInfoCount,
         pBindInfos
@@ -1028,7 +1135,8 @@ VkResult vkGetSwapchainGrallocUsageANDROID(
     VkImageUsageFlags                           imageUsage,
     int*                                        grallocUsage)
 {
-    return pfn_vkGetSwapchainGrallocUsageANDROID(
+    VK_EXT_RESOLVE(vkGetSwapchainGrallocUsageANDROID)
+    return pfn(
         device,
         format,
         imageUsage,
@@ -1044,7 +1152,8 @@ VkResult vkAcquireImageANDROID(
     VkSemaphore                                 semaphore,
     VkFence                                     fence)
 {
-    return pfn_vkAcquireImageANDROID(
+    VK_EXT_RESOLVE(vkAcquireImageANDROID)
+    return pfn(
         device,
         image,
         nativeFenceFd,
@@ -1061,7 +1170,8 @@ VkResult vkQueueSignalReleaseImageANDROID(
     VkImage                                     image,
     int*                                        pNativeFenceFd)
 {
-    return pfn_vkQueueSignalReleaseImageANDROID(
+    VK_EXT_RESOLVE(vkQueueSignalReleaseImageANDROID)
+    return pfn(
         queue,
         waitSemaphoreCount,
         pWaitSemaphores,
@@ -1079,7 +1189,8 @@ VkResult vkCreateDebugReportCallbackEXT(
     const VkAllocationCallbacks*                pAllocator,
     VkDebugReportCallbackEXT*                   pCallback)
 {
-    return pfn_vkCreateDebugReportCallbackEXT(
+    VK_EXT_RESOLVE(vkCreateDebugReportCallbackEXT)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -1093,7 +1204,8 @@ void vkDestroyDebugReportCallbackEXT(
     VkDebugReportCallbackEXT                    callback,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroyDebugReportCallbackEXT(
+    VK_EXT_RESOLVE(vkDestroyDebugReportCallbackEXT)
+    pfn(
         instance,
         callback,
         pAllocator
@@ -1111,7 +1223,8 @@ void vkDebugReportMessageEXT(
     const char*                                 pLayerPrefix,
     const char*                                 pMessage)
 {
-    pfn_vkDebugReportMessageEXT(
+    VK_EXT_RESOLVE(vkDebugReportMessageEXT)
+    pfn(
         instance,
         flags,
         objectType,
@@ -1130,7 +1243,8 @@ VkResult vkDebugMarkerSetObjectTagEXT(
     VkDevice                                    device,
     const VkDebugMarkerObjectTagInfoEXT*        pTagInfo)
 {
-    return pfn_vkDebugMarkerSetObjectTagEXT(
+    VK_EXT_RESOLVE(vkDebugMarkerSetObjectTagEXT)
+    return pfn(
         device,
         pTagInfo
     );
@@ -1141,7 +1255,8 @@ VkResult vkDebugMarkerSetObjectNameEXT(
     VkDevice                                    device,
     const VkDebugMarkerObjectNameInfoEXT*       pNameInfo)
 {
-    return pfn_vkDebugMarkerSetObjectNameEXT(
+    VK_EXT_RESOLVE(vkDebugMarkerSetObjectNameEXT)
+    return pfn(
         device,
         pNameInfo
     );
@@ -1152,7 +1267,8 @@ void vkCmdDebugMarkerBeginEXT(
     VkCommandBuffer                             commandBuffer,
     const VkDebugMarkerMarkerInfoEXT*           pMarkerInfo)
 {
-    pfn_vkCmdDebugMarkerBeginEXT(
+    VK_EXT_RESOLVE(vkCmdDebugMarkerBeginEXT)
+    pfn(
         commandBuffer,
         pMarkerInfo
     );
@@ -1162,7 +1278,8 @@ static PFN_vkCmdDebugMarkerEndEXT pfn_vkCmdDebugMarkerEndEXT;
 void vkCmdDebugMarkerEndEXT(
     VkCommandBuffer                             commandBuffer)
 {
-    pfn_vkCmdDebugMarkerEndEXT(
+    VK_EXT_RESOLVE(vkCmdDebugMarkerEndEXT)
+    pfn(
         commandBuffer
     );
 }
@@ -1172,7 +1289,8 @@ void vkCmdDebugMarkerInsertEXT(
     VkCommandBuffer                             commandBuffer,
     const VkDebugMarkerMarkerInfoEXT*           pMarkerInfo)
 {
-    pfn_vkCmdDebugMarkerInsertEXT(
+    VK_EXT_RESOLVE(vkCmdDebugMarkerInsertEXT)
+    pfn(
         commandBuffer,
         pMarkerInfo
     );
@@ -1190,7 +1308,8 @@ void vkCmdDrawIndirectCountAMD(
     uint32_t                                    maxDrawCount,
     uint32_t                                    stride)
 {
-    pfn_vkCmdDrawIndirectCountAMD(
+    VK_EXT_RESOLVE(vkCmdDrawIndirectCountAMD)
+    pfn(
         commandBuffer,
         buffer,
         offset,
@@ -1211,7 +1330,8 @@ void vkCmdDrawIndexedIndirectCountAMD(
     uint32_t                                    maxDrawCount,
     uint32_t                                    stride)
 {
-    pfn_vkCmdDrawIndexedIndirectCountAMD(
+    VK_EXT_RESOLVE(vkCmdDrawIndexedIndirectCountAMD)
+    pfn(
         commandBuffer,
         buffer,
         offset,
@@ -1233,7 +1353,8 @@ VkResult vkGetShaderInfoAMD(
     size_t*                                     pInfoSize,
     void*                                       pInfo)
 {
-    return pfn_vkGetShaderInfoAMD(
+    VK_EXT_RESOLVE(vkGetShaderInfoAMD)
+    return pfn(
         device,
         pipeline,
         shaderStage,
@@ -1256,7 +1377,8 @@ VkResult vkGetPhysicalDeviceExternalImageFormatPropertiesNV(
     VkExternalMemoryHandleTypeFlagsNV           externalHandleType,
     VkExternalImageFormatPropertiesNV*          pExternalImageFormatProperties)
 {
-    return pfn_vkGetPhysicalDeviceExternalImageFormatPropertiesNV(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceExternalImageFormatPropertiesNV)
+    return pfn(
         physicalDevice,
         format,
         type,
@@ -1278,7 +1400,8 @@ VkResult vkGetMemoryWin32HandleNV(
     VkExternalMemoryHandleTypeFlagsNV           handleType,
     HANDLE*                                     pHandle)
 {
-    return pfn_vkGetMemoryWin32HandleNV(
+    VK_EXT_RESOLVE(vkGetMemoryWin32HandleNV)
+    return pfn(
         device,
         memory,
         handleType,
@@ -1297,7 +1420,8 @@ void vkGetDeviceGroupPeerMemoryFeaturesKHX(
     uint32_t                                    remoteDeviceIndex,
     VkPeerMemoryFeatureFlagsKHX*                pPeerMemoryFeatures)
 {
-    pfn_vkGetDeviceGroupPeerMemoryFeaturesKHX(
+    VK_EXT_RESOLVE(vkGetDeviceGroupPeerMemoryFeaturesKHX)
+    pfn(
         device,
         heapIndex,
         localDeviceIndex,
@@ -1311,7 +1435,8 @@ void vkCmdSetDeviceMaskKHX(
     VkCommandBuffer                             commandBuffer,
     uint32_t                                    deviceMask)
 {
-    pfn_vkCmdSetDeviceMaskKHX(
+    VK_EXT_RESOLVE(vkCmdSetDeviceMaskKHX)
+    pfn(
         commandBuffer,
         deviceMask
     );
@@ -1327,7 +1452,8 @@ void vkCmdDispatchBaseKHX(
     uint32_t                                    groupCountY,
     uint32_t                                    groupCountZ)
 {
-    pfn_vkCmdDispatchBaseKHX(
+    VK_EXT_RESOLVE(vkCmdDispatchBaseKHX)
+    pfn(
         commandBuffer,
         baseGroupX,
         baseGroupY,
@@ -1343,7 +1469,8 @@ VkResult vkGetDeviceGroupPresentCapabilitiesKHX(
     VkDevice                                    device,
     VkDeviceGroupPresentCapabilitiesKHX*        pDeviceGroupPresentCapabilities)
 {
-    return pfn_vkGetDeviceGroupPresentCapabilitiesKHX(
+    VK_EXT_RESOLVE(vkGetDeviceGroupPresentCapabilitiesKHX)
+    return pfn(
         device,
         pDeviceGroupPresentCapabilities
     );
@@ -1355,7 +1482,8 @@ VkResult vkGetDeviceGroupSurfacePresentModesKHX(
     VkSurfaceKHR                                surface,
     VkDeviceGroupPresentModeFlagsKHX*           pModes)
 {
-    return pfn_vkGetDeviceGroupSurfacePresentModesKHX(
+    VK_EXT_RESOLVE(vkGetDeviceGroupSurfacePresentModesKHX)
+    return pfn(
         device,
         surface,
         pModes
@@ -1369,7 +1497,8 @@ VkResult vkGetPhysicalDevicePresentRectanglesKHX(
     uint32_t*                                   pRectCount,
     VkRect2D*                                   pRects)
 {
-    return pfn_vkGetPhysicalDevicePresentRectanglesKHX(
+    VK_EXT_RESOLVE(vkGetPhysicalDevicePresentRectanglesKHX)
+    return pfn(
         physicalDevice,
         surface,
         pRectCount,
@@ -1383,7 +1512,8 @@ VkResult vkAcquireNextImage2KHX(
     const VkAcquireNextImageInfoKHX*            pAcquireInfo,
     uint32_t*                                   pImageIndex)
 {
-    return pfn_vkAcquireNextImage2KHX(
+    VK_EXT_RESOLVE(vkAcquireNextImage2KHX)
+    return pfn(
         device,
         pAcquireInfo,
         pImageIndex
@@ -1400,7 +1530,8 @@ VkResult vkCreateViSurfaceNN(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateViSurfaceNN(
+    VK_EXT_RESOLVE(vkCreateViSurfaceNN)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -1417,7 +1548,8 @@ VkResult vkEnumeratePhysicalDeviceGroupsKHX(
     uint32_t*                                   pPhysicalDeviceGroupCount,
     VkPhysicalDeviceGroupPropertiesKHX*         pPhysicalDeviceGroupProperties)
 {
-    return pfn_vkEnumeratePhysicalDeviceGroupsKHX(
+    VK_EXT_RESOLVE(vkEnumeratePhysicalDeviceGroupsKHX)
+    return pfn(
         instance,
         pPhysicalDeviceGroupCount,
         pPhysicalDeviceGroupProperties
@@ -1431,7 +1563,8 @@ void vkCmdProcessCommandsNVX(
     VkCommandBuffer                             commandBuffer,
     const VkCmdProcessCommandsInfoNVX*          pProcessCommandsInfo)
 {
-    pfn_vkCmdProcessCommandsNVX(
+    VK_EXT_RESOLVE(vkCmdProcessCommandsNVX)
+    pfn(
         commandBuffer,
         pProcessCommandsInfo
     );
@@ -1442,7 +1575,8 @@ void vkCmdReserveSpaceForCommandsNVX(
     VkCommandBuffer                             commandBuffer,
     const VkCmdReserveSpaceForCommandsInfoNVX*  pReserveSpaceInfo)
 {
-    pfn_vkCmdReserveSpaceForCommandsNVX(
+    VK_EXT_RESOLVE(vkCmdReserveSpaceForCommandsNVX)
+    pfn(
         commandBuffer,
         pReserveSpaceInfo
     );
@@ -1455,7 +1589,8 @@ VkResult vkCreateIndirectCommandsLayoutNVX(
     const VkAllocationCallbacks*                pAllocator,
     VkIndirectCommandsLayoutNVX*                pIndirectCommandsLayout)
 {
-    return pfn_vkCreateIndirectCommandsLayoutNVX(
+    VK_EXT_RESOLVE(vkCreateIndirectCommandsLayoutNVX)
+    return pfn(
         device,
         pCreateInfo,
         pAllocator,
@@ -1469,7 +1604,8 @@ void vkDestroyIndirectCommandsLayoutNVX(
     VkIndirectCommandsLayoutNVX                 indirectCommandsLayout,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroyIndirectCommandsLayoutNVX(
+    VK_EXT_RESOLVE(vkDestroyIndirectCommandsLayoutNVX)
+    pfn(
         device,
         indirectCommandsLayout,
         pAllocator
@@ -1483,7 +1619,8 @@ VkResult vkCreateObjectTableNVX(
     const VkAllocationCallbacks*                pAllocator,
     VkObjectTableNVX*                           pObjectTable)
 {
-    return pfn_vkCreateObjectTableNVX(
+    VK_EXT_RESOLVE(vkCreateObjectTableNVX)
+    return pfn(
         device,
         pCreateInfo,
         pAllocator,
@@ -1497,7 +1634,8 @@ void vkDestroyObjectTableNVX(
     VkObjectTableNVX                            objectTable,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroyObjectTableNVX(
+    VK_EXT_RESOLVE(vkDestroyObjectTableNVX)
+    pfn(
         device,
         objectTable,
         pAllocator
@@ -1512,7 +1650,8 @@ VkResult vkRegisterObjectsNVX(
     const VkObjectTableEntryNVX* const*         ppObjectTableEntries,
     const uint32_t*                             pObjectIndices)
 {
-    return pfn_vkRegisterObjectsNVX(
+    VK_EXT_RESOLVE(vkRegisterObjectsNVX)
+    return pfn(
         device,
         objectTable,
         objectCount,
@@ -1529,7 +1668,8 @@ VkResult vkUnregisterObjectsNVX(
     const VkObjectEntryTypeNVX*                 pObjectEntryTypes,
     const uint32_t*                             pObjectIndices)
 {
-    return pfn_vkUnregisterObjectsNVX(
+    VK_EXT_RESOLVE(vkUnregisterObjectsNVX)
+    return pfn(
         device,
         objectTable,
         objectCount,
@@ -1544,7 +1684,8 @@ void vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX(
     VkDeviceGeneratedCommandsFeaturesNVX*       pFeatures,
     VkDeviceGeneratedCommandsLimitsNVX*         pLimits)
 {
-    pfn_vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX)
+    pfn(
         physicalDevice,
         pFeatures,
         pLimits
@@ -1560,7 +1701,8 @@ void vkCmdSetViewportWScalingNV(
     uint32_t                                    viewportCount,
     const VkViewportWScalingNV*                 pViewportWScalings)
 {
-    pfn_vkCmdSetViewportWScalingNV(
+    VK_EXT_RESOLVE(vkCmdSetViewportWScalingNV)
+    pfn(
         commandBuffer,
         firstViewport,
         viewportCount,
@@ -1575,7 +1717,8 @@ VkResult vkReleaseDisplayEXT(
     VkPhysicalDevice                            physicalDevice,
     VkDisplayKHR                                display)
 {
-    return pfn_vkReleaseDisplayEXT(
+    VK_EXT_RESOLVE(vkReleaseDisplayEXT)
+    return pfn(
         physicalDevice,
         display
     );
@@ -1590,7 +1733,8 @@ VkResult vkAcquireXlibDisplayEXT(
     Display*                                    dpy,
     VkDisplayKHR                                display)
 {
-    return pfn_vkAcquireXlibDisplayEXT(
+    VK_EXT_RESOLVE(vkAcquireXlibDisplayEXT)
+    return pfn(
         physicalDevice,
         dpy,
         display
@@ -1604,7 +1748,8 @@ VkResult vkGetRandROutputDisplayEXT(
     RROutput                                    rrOutput,
     VkDisplayKHR*                               pDisplay)
 {
-    return pfn_vkGetRandROutputDisplayEXT(
+    VK_EXT_RESOLVE(vkGetRandROutputDisplayEXT)
+    return pfn(
         physicalDevice,
         dpy,
         rrOutput,
@@ -1621,7 +1766,8 @@ VkResult vkGetPhysicalDeviceSurfaceCapabilities2EXT(
     VkSurfaceKHR                                surface,
     VkSurfaceCapabilities2EXT*                  pSurfaceCapabilities)
 {
-    return pfn_vkGetPhysicalDeviceSurfaceCapabilities2EXT(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceSurfaceCapabilities2EXT)
+    return pfn(
         physicalDevice,
         surface,
         pSurfaceCapabilities
@@ -1636,7 +1782,8 @@ VkResult vkDisplayPowerControlEXT(
     VkDisplayKHR                                display,
     const VkDisplayPowerInfoEXT*                pDisplayPowerInfo)
 {
-    return pfn_vkDisplayPowerControlEXT(
+    VK_EXT_RESOLVE(vkDisplayPowerControlEXT)
+    return pfn(
         device,
         display,
         pDisplayPowerInfo
@@ -1650,7 +1797,8 @@ VkResult vkRegisterDeviceEventEXT(
     const VkAllocationCallbacks*                pAllocator,
     VkFence*                                    pFence)
 {
-    return pfn_vkRegisterDeviceEventEXT(
+    VK_EXT_RESOLVE(vkRegisterDeviceEventEXT)
+    return pfn(
         device,
         pDeviceEventInfo,
         pAllocator,
@@ -1666,7 +1814,8 @@ VkResult vkRegisterDisplayEventEXT(
     const VkAllocationCallbacks*                pAllocator,
     VkFence*                                    pFence)
 {
-    return pfn_vkRegisterDisplayEventEXT(
+    VK_EXT_RESOLVE(vkRegisterDisplayEventEXT)
+    return pfn(
         device,
         display,
         pDisplayEventInfo,
@@ -1682,7 +1831,8 @@ VkResult vkGetSwapchainCounterEXT(
     VkSurfaceCounterFlagBitsEXT                 counter,
     uint64_t*                                   pCounterValue)
 {
-    return pfn_vkGetSwapchainCounterEXT(
+    VK_EXT_RESOLVE(vkGetSwapchainCounterEXT)
+    return pfn(
         device,
         swapchain,
         counter,
@@ -1698,7 +1848,8 @@ VkResult vkGetRefreshCycleDurationGOOGLE(
     VkSwapchainKHR                              swapchain,
     VkRefreshCycleDurationGOOGLE*               pDisplayTimingProperties)
 {
-    return pfn_vkGetRefreshCycleDurationGOOGLE(
+    VK_EXT_RESOLVE(vkGetRefreshCycleDurationGOOGLE)
+    return pfn(
         device,
         swapchain,
         pDisplayTimingProperties
@@ -1712,7 +1863,8 @@ VkResult vkGetPastPresentationTimingGOOGLE(
     uint32_t*                                   pPresentationTimingCount,
     VkPastPresentationTimingGOOGLE*             pPresentationTimings)
 {
-    return pfn_vkGetPastPresentationTimingGOOGLE(
+    VK_EXT_RESOLVE(vkGetPastPresentationTimingGOOGLE)
+    return pfn(
         device,
         swapchain,
         pPresentationTimingCount,
@@ -1729,7 +1881,8 @@ void vkCmdSetDiscardRectangleEXT(
     uint32_t                                    discardRectangleCount,
     const VkRect2D*                             pDiscardRectangles)
 {
-    pfn_vkCmdSetDiscardRectangleEXT(
+    VK_EXT_RESOLVE(vkCmdSetDiscardRectangleEXT)
+    pfn(
         commandBuffer,
         firstDiscardRectangle,
         discardRectangleCount,
@@ -1746,7 +1899,8 @@ void vkSetHdrMetadataEXT(
     const VkSwapchainKHR*                       pSwapchains,
     const VkHdrMetadataEXT*                     pMetadata)
 {
-    pfn_vkSetHdrMetadataEXT(
+    VK_EXT_RESOLVE(vkSetHdrMetadataEXT)
+    pfn(
         device,
         swapchainCount,
         pSwapchains,
@@ -1764,7 +1918,8 @@ VkResult vkCreateIOSSurfaceMVK(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateIOSSurfaceMVK(
+    VK_EXT_RESOLVE(vkCreateIOSSurfaceMVK)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -1783,7 +1938,8 @@ VkResult vkCreateMacOSSurfaceMVK(
     const VkAllocationCallbacks*                pAllocator,
     VkSurfaceKHR*                               pSurface)
 {
-    return pfn_vkCreateMacOSSurfaceMVK(
+    VK_EXT_RESOLVE(vkCreateMacOSSurfaceMVK)
+    return pfn(
         instance,
         pCreateInfo,
         pAllocator,
@@ -1799,7 +1955,8 @@ void vkCmdSetSampleLocationsEXT(
     VkCommandBuffer                             commandBuffer,
     const VkSampleLocationsInfoEXT*             pSampleLocationsInfo)
 {
-    pfn_vkCmdSetSampleLocationsEXT(
+    VK_EXT_RESOLVE(vkCmdSetSampleLocationsEXT)
+    pfn(
         commandBuffer,
         pSampleLocationsInfo
     );
@@ -1811,7 +1968,8 @@ void vkGetPhysicalDeviceMultisamplePropertiesEXT(
     VkSampleCountFlagBits                       samples,
     VkMultisamplePropertiesEXT*                 pMultisampleProperties)
 {
-    pfn_vkGetPhysicalDeviceMultisamplePropertiesEXT(
+    VK_EXT_RESOLVE(vkGetPhysicalDeviceMultisamplePropertiesEXT)
+    pfn(
         physicalDevice,
         samples,
         pMultisampleProperties
@@ -1827,7 +1985,8 @@ VkResult vkCreateValidationCacheEXT(
     const VkAllocationCallbacks*                pAllocator,
     VkValidationCacheEXT*                       pValidationCache)
 {
-    return pfn_vkCreateValidationCacheEXT(
+    VK_EXT_RESOLVE(vkCreateValidationCacheEXT)
+    return pfn(
         device,
         pCreateInfo,
         pAllocator,
@@ -1841,7 +2000,8 @@ void vkDestroyValidationCacheEXT(
     VkValidationCacheEXT                        validationCache,
     const VkAllocationCallbacks*                pAllocator)
 {
-    pfn_vkDestroyValidationCacheEXT(
+    VK_EXT_RESOLVE(vkDestroyValidationCacheEXT)
+    pfn(
         device,
         validationCache,
         pAllocator
@@ -1855,7 +2015,8 @@ VkResult vkMergeValidationCachesEXT(
     uint32_t                                    srcCacheCount,
     const VkValidationCacheEXT*                 pSrcCaches)
 {
-    return pfn_vkMergeValidationCachesEXT(
+    VK_EXT_RESOLVE(vkMergeValidationCachesEXT)
+    return pfn(
         device,
         dstCache,
         srcCacheCount,
@@ -1870,7 +2031,8 @@ VkResult vkGetValidationCacheDataEXT(
     size_t*                                     pDataSize,
     void*                                       pData)
 {
-    return pfn_vkGetValidationCacheDataEXT(
+    VK_EXT_RESOLVE(vkGetValidationCacheDataEXT)
+    return pfn(
         device,
         validationCache,
         pDataSize,
@@ -1887,7 +2049,8 @@ VkResult vkGetMemoryHostPointerPropertiesEXT(
     const void*                                 pHostPointer,
     VkMemoryHostPointerPropertiesEXT*           pMemoryHostPointerProperties)
 {
-    return pfn_vkGetMemoryHostPointerPropertiesEXT(
+    VK_EXT_RESOLVE(vkGetMemoryHostPointerPropertiesEXT)
+    return pfn(
         device,
         handleType,
         pHostPointer,
@@ -1905,7 +2068,8 @@ void vkCmdWriteBufferMarkerAMD(
     VkDeviceSize                                dstOffset,
     uint32_t                                    marker)
 {
-    pfn_vkCmdWriteBufferMarkerAMD(
+    VK_EXT_RESOLVE(vkCmdWriteBufferMarkerAMD)
+    pfn(
         commandBuffer,
         pipelineStage,
         dstBuffer,
@@ -1918,525 +2082,695 @@ void vkCmdWriteBufferMarkerAMD(
 
 void vkExtInitInstance(VkInstance instance)
 {
+    VK_EXT_STORE(vkExtInstance, instance);
+    VK_EXT_STORE(vkExtDevice, VK_NULL_HANDLE);
 #ifdef VK_KHR_surface
-    pfn_vkDestroySurfaceKHR = (PFN_vkDestroySurfaceKHR)vkGetInstanceProcAddr(instance, "vkDestroySurfaceKHR");
-    pfn_vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfaceSupportKHR");
-    pfn_vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
-    pfn_vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfaceFormatsKHR");
-    pfn_vkGetPhysicalDeviceSurfacePresentModesKHR = (PFN_vkGetPhysicalDeviceSurfacePresentModesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfacePresentModesKHR");
+    VK_EXT_RESET(vkDestroySurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceSupportKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceFormatsKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfacePresentModesKHR);
 #endif /* VK_KHR_surface */
 #ifdef VK_KHR_swapchain
-    pfn_vkCreateSwapchainKHR = (PFN_vkCreateSwapchainKHR)vkGetInstanceProcAddr(instance, "vkCreateSwapchainKHR");
-    pfn_vkDestroySwapchainKHR = (PFN_vkDestroySwapchainKHR)vkGetInstanceProcAddr(instance, "vkDestroySwapchainKHR");
-    pfn_vkGetSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR)vkGetInstanceProcAddr(instance, "vkGetSwapchainImagesKHR");
-    pfn_vkAcquireNextImageKHR = (PFN_vkAcquireNextImageKHR)vkGetInstanceProcAddr(instance, "vkAcquireNextImageKHR");
-    pfn_vkQueuePresentKHR = (PFN_vkQueuePresentKHR)vkGetInstanceProcAddr(instance, "vkQueuePresentKHR");
+    VK_EXT_RESET(vkCreateSwapchainKHR);
+    VK_EXT_RESET(vkDestroySwapchainKHR);
+    VK_EXT_RESET(vkGetSwapchainImagesKHR);
+    VK_EXT_RESET(vkAcquireNextImageKHR);
+    VK_EXT_RESET(vkQueuePresentKHR);
 #endif /* VK_KHR_swapchain */
 #ifdef VK_KHR_display
-    pfn_vkGetPhysicalDeviceDisplayPropertiesKHR = (PFN_vkGetPhysicalDeviceDisplayPropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceDisplayPropertiesKHR");
-    pfn_vkGetPhysicalDeviceDisplayPlanePropertiesKHR = (PFN_vkGetPhysicalDeviceDisplayPlanePropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceDisplayPlanePropertiesKHR");
-    pfn_vkGetDisplayPlaneSupportedDisplaysKHR = (PFN_vkGetDisplayPlaneSupportedDisplaysKHR)vkGetInstanceProcAddr(instance, "vkGetDisplayPlaneSupportedDisplaysKHR");
-    pfn_vkGetDisplayModePropertiesKHR = (PFN_vkGetDisplayModePropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetDisplayModePropertiesKHR");
-    pfn_vkCreateDisplayModeKHR = (PFN_vkCreateDisplayModeKHR)vkGetInstanceProcAddr(instance, "vkCreateDisplayModeKHR");
-    pfn_vkGetDisplayPlaneCapabilitiesKHR = (PFN_vkGetDisplayPlaneCapabilitiesKHR)vkGetInstanceProcAddr(instance, "vkGetDisplayPlaneCapabilitiesKHR");
-    pfn_vkCreateDisplayPlaneSurfaceKHR = (PFN_vkCreateDisplayPlaneSurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateDisplayPlaneSurfaceKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceDisplayPropertiesKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceDisplayPlanePropertiesKHR);
+    VK_EXT_RESET(vkGetDisplayPlaneSupportedDisplaysKHR);
+    VK_EXT_RESET(vkGetDisplayModePropertiesKHR);
+    VK_EXT_RESET(vkCreateDisplayModeKHR);
+    VK_EXT_RESET(vkGetDisplayPlaneCapabilitiesKHR);
+    VK_EXT_RESET(vkCreateDisplayPlaneSurfaceKHR);
 #endif /* VK_KHR_display */
 #ifdef VK_KHR_display_swapchain
-    pfn_vkCreateSharedSwapchainsKHR = (PFN_vkCreateSharedSwapchainsKHR)vkGetInstanceProcAddr(instance, "vkCreateSharedSwapchainsKHR");
+    VK_EXT_RESET(vkCreateSharedSwapchainsKHR);
 #endif /* VK_KHR_display_swapchain */
 #ifdef VK_KHR_xlib_surface
 #ifndef VK_KHR_xlib_surface
-    pfn_vkCreateXlibSurfaceKHR = (PFN_vkCreateXlibSurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateXlibSurfaceKHR");
-    pfn_vkGetPhysicalDeviceXlibPresentationSupportKHR = (PFN_vkGetPhysicalDeviceXlibPresentationSupportKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceXlibPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateXlibSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceXlibPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_XLIB_KHR */
 #endif /* VK_KHR_xlib_surface */
 #ifdef VK_KHR_xcb_surface
 #ifndef VK_KHR_xcb_surface
-    pfn_vkCreateXcbSurfaceKHR = (PFN_vkCreateXcbSurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateXcbSurfaceKHR");
-    pfn_vkGetPhysicalDeviceXcbPresentationSupportKHR = (PFN_vkGetPhysicalDeviceXcbPresentationSupportKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceXcbPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateXcbSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceXcbPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_XCB_KHR */
 #endif /* VK_KHR_xcb_surface */
 #ifdef VK_KHR_wayland_surface
 #ifndef VK_KHR_wayland_surface
-    pfn_vkCreateWaylandSurfaceKHR = (PFN_vkCreateWaylandSurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateWaylandSurfaceKHR");
-    pfn_vkGetPhysicalDeviceWaylandPresentationSupportKHR = (PFN_vkGetPhysicalDeviceWaylandPresentationSupportKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceWaylandPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateWaylandSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceWaylandPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_WAYLAND_KHR */
 #endif /* VK_KHR_wayland_surface */
 #ifdef VK_KHR_mir_surface
 #ifndef VK_KHR_mir_surface
-    pfn_vkCreateMirSurfaceKHR = (PFN_vkCreateMirSurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateMirSurfaceKHR");
-    pfn_vkGetPhysicalDeviceMirPresentationSupportKHR = (PFN_vkGetPhysicalDeviceMirPresentationSupportKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMirPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateMirSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceMirPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_MIR_KHR */
 #endif /* VK_KHR_mir_surface */
 #ifdef VK_KHR_android_surface
 #ifndef VK_KHR_android_surface
-    pfn_vkCreateAndroidSurfaceKHR = (PFN_vkCreateAndroidSurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateAndroidSurfaceKHR");
+    VK_EXT_RESET(vkCreateAndroidSurfaceKHR);
 #endif /* VK_USE_PLATFORM_ANDROID_KHR */
 #endif /* VK_KHR_android_surface */
 #ifdef VK_KHR_win32_surface
 #ifndef VK_KHR_win32_surface
-    pfn_vkCreateWin32SurfaceKHR = (PFN_vkCreateWin32SurfaceKHR)vkGetInstanceProcAddr(instance, "vkCreateWin32SurfaceKHR");
-    pfn_vkGetPhysicalDeviceWin32PresentationSupportKHR = (PFN_vkGetPhysicalDeviceWin32PresentationSupportKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceWin32PresentationSupportKHR");
+    VK_EXT_RESET(vkCreateWin32SurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceWin32PresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_win32_surface */
 #ifdef VK_KHR_get_physical_device_properties2
-    pfn_vkGetPhysicalDeviceFeatures2KHR = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
-    pfn_vkGetPhysicalDeviceProperties2KHR = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
-    pfn_vkGetPhysicalDeviceFormatProperties2KHR = (PFN_vkGetPhysicalDeviceFormatProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFormatProperties2KHR");
-    pfn_vkGetPhysicalDeviceImageFormatProperties2KHR = (PFN_vkGetPhysicalDeviceImageFormatProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceImageFormatProperties2KHR");
-    pfn_vkGetPhysicalDeviceQueueFamilyProperties2KHR = (PFN_vkGetPhysicalDeviceQueueFamilyProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyProperties2KHR");
-    pfn_vkGetPhysicalDeviceMemoryProperties2KHR = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
-    pfn_vkGetPhysicalDeviceSparseImageFormatProperties2KHR = (PFN_vkGetPhysicalDeviceSparseImageFormatProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSparseImageFormatProperties2KHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceFeatures2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceFormatProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceImageFormatProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceQueueFamilyProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceMemoryProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSparseImageFormatProperties2KHR);
 #endif /* VK_KHR_get_physical_device_properties2 */
 #ifdef VK_KHR_maintenance1
-    pfn_vkTrimCommandPoolKHR = (PFN_vkTrimCommandPoolKHR)vkGetInstanceProcAddr(instance, "vkTrimCommandPoolKHR");
+    VK_EXT_RESET(vkTrimCommandPoolKHR);
 #endif /* VK_KHR_maintenance1 */
 #ifdef VK_KHR_external_memory_capabilities
-    pfn_vkGetPhysicalDeviceExternalBufferPropertiesKHR = (PFN_vkGetPhysicalDeviceExternalBufferPropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceExternalBufferPropertiesKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalBufferPropertiesKHR);
 #endif /* VK_KHR_external_memory_capabilities */
 #ifdef VK_KHR_external_memory_win32
 #ifndef VK_KHR_external_memory_win32
-    pfn_vkGetMemoryWin32HandleKHR = (PFN_vkGetMemoryWin32HandleKHR)vkGetInstanceProcAddr(instance, "vkGetMemoryWin32HandleKHR");
-    pfn_vkGetMemoryWin32HandlePropertiesKHR = (PFN_vkGetMemoryWin32HandlePropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetMemoryWin32HandlePropertiesKHR");
+    VK_EXT_RESET(vkGetMemoryWin32HandleKHR);
+    VK_EXT_RESET(vkGetMemoryWin32HandlePropertiesKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_external_memory_win32 */
 #ifdef VK_KHR_external_memory_fd
-    pfn_vkGetMemoryFdKHR = (PFN_vkGetMemoryFdKHR)vkGetInstanceProcAddr(instance, "vkGetMemoryFdKHR");
-    pfn_vkGetMemoryFdPropertiesKHR = (PFN_vkGetMemoryFdPropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetMemoryFdPropertiesKHR");
+    VK_EXT_RESET(vkGetMemoryFdKHR);
+    VK_EXT_RESET(vkGetMemoryFdPropertiesKHR);
 #endif /* VK_KHR_external_memory_fd */
 #ifdef VK_KHR_external_semaphore_capabilities
-    pfn_vkGetPhysicalDeviceExternalSemaphorePropertiesKHR = (PFN_vkGetPhysicalDeviceExternalSemaphorePropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceExternalSemaphorePropertiesKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalSemaphorePropertiesKHR);
 #endif /* VK_KHR_external_semaphore_capabilities */
 #ifdef VK_KHR_external_semaphore_win32
 #ifndef VK_KHR_external_semaphore_win32
-    pfn_vkImportSemaphoreWin32HandleKHR = (PFN_vkImportSemaphoreWin32HandleKHR)vkGetInstanceProcAddr(instance, "vkImportSemaphoreWin32HandleKHR");
-    pfn_vkGetSemaphoreWin32HandleKHR = (PFN_vkGetSemaphoreWin32HandleKHR)vkGetInstanceProcAddr(instance, "vkGetSemaphoreWin32HandleKHR");
+    VK_EXT_RESET(vkImportSemaphoreWin32HandleKHR);
+    VK_EXT_RESET(vkGetSemaphoreWin32HandleKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_external_semaphore_win32 */
 #ifdef VK_KHR_external_semaphore_fd
-    pfn_vkImportSemaphoreFdKHR = (PFN_vkImportSemaphoreFdKHR)vkGetInstanceProcAddr(instance, "vkImportSemaphoreFdKHR");
-    pfn_vkGetSemaphoreFdKHR = (PFN_vkGetSemaphoreFdKHR)vkGetInstanceProcAddr(instance, "vkGetSemaphoreFdKHR");
+    VK_EXT_RESET(vkImportSemaphoreFdKHR);
+    VK_EXT_RESET(vkGetSemaphoreFdKHR);
 #endif /* VK_KHR_external_semaphore_fd */
 #ifdef VK_KHR_push_descriptor
-    pfn_vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetInstanceProcAddr(instance, "vkCmdPushDescriptorSetKHR");
+    VK_EXT_RESET(vkCmdPushDescriptorSetKHR);
 #endif /* VK_KHR_push_descriptor */
 #ifdef VK_KHR_descriptor_update_template
-    pfn_vkCreateDescriptorUpdateTemplateKHR = (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetInstanceProcAddr(instance, "vkCreateDescriptorUpdateTemplateKHR");
-    pfn_vkDestroyDescriptorUpdateTemplateKHR = (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetInstanceProcAddr(instance, "vkDestroyDescriptorUpdateTemplateKHR");
-    pfn_vkUpdateDescriptorSetWithTemplateKHR = (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetInstanceProcAddr(instance, "vkUpdateDescriptorSetWithTemplateKHR");
-    pfn_vkCmdPushDescriptorSetWithTemplateKHR = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetInstanceProcAddr(instance, "vkCmdPushDescriptorSetWithTemplateKHR");
+    VK_EXT_RESET(vkCreateDescriptorUpdateTemplateKHR);
+    VK_EXT_RESET(vkDestroyDescriptorUpdateTemplateKHR);
+    VK_EXT_RESET(vkUpdateDescriptorSetWithTemplateKHR);
+    VK_EXT_RESET(vkCmdPushDescriptorSetWithTemplateKHR);
 #endif /* VK_KHR_descriptor_update_template */
 #ifdef VK_KHR_shared_presentable_image
-    pfn_vkGetSwapchainStatusKHR = (PFN_vkGetSwapchainStatusKHR)vkGetInstanceProcAddr(instance, "vkGetSwapchainStatusKHR");
+    VK_EXT_RESET(vkGetSwapchainStatusKHR);
 #endif /* VK_KHR_shared_presentable_image */
 #ifdef VK_KHR_external_fence_capabilities
-    pfn_vkGetPhysicalDeviceExternalFencePropertiesKHR = (PFN_vkGetPhysicalDeviceExternalFencePropertiesKHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceExternalFencePropertiesKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalFencePropertiesKHR);
 #endif /* VK_KHR_external_fence_capabilities */
 #ifdef VK_KHR_external_fence_win32
 #ifndef VK_KHR_external_fence_win32
-    pfn_vkImportFenceWin32HandleKHR = (PFN_vkImportFenceWin32HandleKHR)vkGetInstanceProcAddr(instance, "vkImportFenceWin32HandleKHR");
-    pfn_vkGetFenceWin32HandleKHR = (PFN_vkGetFenceWin32HandleKHR)vkGetInstanceProcAddr(instance, "vkGetFenceWin32HandleKHR");
+    VK_EXT_RESET(vkImportFenceWin32HandleKHR);
+    VK_EXT_RESET(vkGetFenceWin32HandleKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_external_fence_win32 */
 #ifdef VK_KHR_external_fence_fd
-    pfn_vkImportFenceFdKHR = (PFN_vkImportFenceFdKHR)vkGetInstanceProcAddr(instance, "vkImportFenceFdKHR");
-    pfn_vkGetFenceFdKHR = (PFN_vkGetFenceFdKHR)vkGetInstanceProcAddr(instance, "vkGetFenceFdKHR");
+    VK_EXT_RESET(vkImportFenceFdKHR);
+    VK_EXT_RESET(vkGetFenceFdKHR);
 #endif /* VK_KHR_external_fence_fd */
 #ifdef VK_KHR_get_surface_capabilities2
-    pfn_vkGetPhysicalDeviceSurfaceCapabilities2KHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilities2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfaceCapabilities2KHR");
-    pfn_vkGetPhysicalDeviceSurfaceFormats2KHR = (PFN_vkGetPhysicalDeviceSurfaceFormats2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfaceFormats2KHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceCapabilities2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceFormats2KHR);
 #endif /* VK_KHR_get_surface_capabilities2 */
 #ifdef VK_KHR_get_memory_requirements2
-    pfn_vkGetImageMemoryRequirements2KHR = (PFN_vkGetImageMemoryRequirements2KHR)vkGetInstanceProcAddr(instance, "vkGetImageMemoryRequirements2KHR");
-    pfn_vkGetBufferMemoryRequirements2KHR = (PFN_vkGetBufferMemoryRequirements2KHR)vkGetInstanceProcAddr(instance, "vkGetBufferMemoryRequirements2KHR");
-    pfn_vkGetImageSparseMemoryRequirements2KHR = (PFN_vkGetImageSparseMemoryRequirements2KHR)vkGetInstanceProcAddr(instance, "vkGetImageSparseMemoryRequirements2KHR");
+    VK_EXT_RESET(vkGetImageMemoryRequirements2KHR);
+    VK_EXT_RESET(vkGetBufferMemoryRequirements2KHR);
+    VK_EXT_RESET(vkGetImageSparseMemoryRequirements2KHR);
 #endif /* VK_KHR_get_memory_requirements2 */
 #ifdef VK_KHR_sampler_ycbcr_conversion
-    pfn_vkCreateSamplerYcbcrConversionKHR = (PFN_vkCreateSamplerYcbcrConversionKHR)vkGetInstanceProcAddr(instance, "vkCreateSamplerYcbcrConversionKHR");
-    pfn_vkDestroySamplerYcbcrConversionKHR = (PFN_vkDestroySamplerYcbcrConversionKHR)vkGetInstanceProcAddr(instance, "vkDestroySamplerYcbcrConversionKHR");
+    VK_EXT_RESET(vkCreateSamplerYcbcrConversionKHR);
+    VK_EXT_RESET(vkDestroySamplerYcbcrConversionKHR);
 #endif /* VK_KHR_sampler_ycbcr_conversion */
 #ifdef VK_KHR_bind_memory2
-    pfn_vkBindBufferMemory2KHR = (PFN_vkBindBufferMemory2KHR)vkGetInstanceProcAddr(instance, "vkBindBufferMemory2KHR");
-    pfn_vkBindImageMemory2KHR = (PFN_vkBindImageMemory2KHR)vkGetInstanceProcAddr(instance, "vkBindImageMemory2KHR");
+    VK_EXT_RESET(vkBindBufferMemory2KHR);
+    VK_EXT_RESET(vkBindImageMemory2KHR);
 #endif /* VK_KHR_bind_memory2 */
 #ifdef VK_ANDROID_native_buffer
-    pfn_vkGetSwapchainGrallocUsageANDROID = (PFN_vkGetSwapchainGrallocUsageANDROID)vkGetInstanceProcAddr(instance, "vkGetSwapchainGrallocUsageANDROID");
-    pfn_vkAcquireImageANDROID = (PFN_vkAcquireImageANDROID)vkGetInstanceProcAddr(instance, "vkAcquireImageANDROID");
-    pfn_vkQueueSignalReleaseImageANDROID = (PFN_vkQueueSignalReleaseImageANDROID)vkGetInstanceProcAddr(instance, "vkQueueSignalReleaseImageANDROID");
+    VK_EXT_RESET(vkGetSwapchainGrallocUsageANDROID);
+    VK_EXT_RESET(vkAcquireImageANDROID);
+    VK_EXT_RESET(vkQueueSignalReleaseImageANDROID);
 #endif /* VK_ANDROID_native_buffer */
 #ifdef VK_EXT_debug_report
-    pfn_vkCreateDebugReportCallbackEXT = (PFN_vkCreateDebugReportCallbackEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugReportCallbackEXT");
-    pfn_vkDestroyDebugReportCallbackEXT = (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugReportCallbackEXT");
-    pfn_vkDebugReportMessageEXT = (PFN_vkDebugReportMessageEXT)vkGetInstanceProcAddr(instance, "vkDebugReportMessageEXT");
+    VK_EXT_RESET(vkCreateDebugReportCallbackEXT);
+    VK_EXT_RESET(vkDestroyDebugReportCallbackEXT);
+    VK_EXT_RESET(vkDebugReportMessageEXT);
 #endif /* VK_EXT_debug_report */
 #ifdef VK_EXT_debug_marker
-    pfn_vkDebugMarkerSetObjectTagEXT = (PFN_vkDebugMarkerSetObjectTagEXT)vkGetInstanceProcAddr(instance, "vkDebugMarkerSetObjectTagEXT");
-    pfn_vkDebugMarkerSetObjectNameEXT = (PFN_vkDebugMarkerSetObjectNameEXT)vkGetInstanceProcAddr(instance, "vkDebugMarkerSetObjectNameEXT");
-    pfn_vkCmdDebugMarkerBeginEXT = (PFN_vkCmdDebugMarkerBeginEXT)vkGetInstanceProcAddr(instance, "vkCmdDebugMarkerBeginEXT");
-    pfn_vkCmdDebugMarkerEndEXT = (PFN_vkCmdDebugMarkerEndEXT)vkGetInstanceProcAddr(instance, "vkCmdDebugMarkerEndEXT");
-    pfn_vkCmdDebugMarkerInsertEXT = (PFN_vkCmdDebugMarkerInsertEXT)vkGetInstanceProcAddr(instance, "vkCmdDebugMarkerInsertEXT");
+    VK_EXT_RESET(vkDebugMarkerSetObjectTagEXT);
+    VK_EXT_RESET(vkDebugMarkerSetObjectNameEXT);
+    VK_EXT_RESET(vkCmdDebugMarkerBeginEXT);
+    VK_EXT_RESET(vkCmdDebugMarkerEndEXT);
+    VK_EXT_RESET(vkCmdDebugMarkerInsertEXT);
 #endif /* VK_EXT_debug_marker */
 #ifdef VK_AMD_draw_indirect_count
-    pfn_vkCmdDrawIndirectCountAMD = (PFN_vkCmdDrawIndirectCountAMD)vkGetInstanceProcAddr(instance, "vkCmdDrawIndirectCountAMD");
-    pfn_vkCmdDrawIndexedIndirectCountAMD = (PFN_vkCmdDrawIndexedIndirectCountAMD)vkGetInstanceProcAddr(instance, "vkCmdDrawIndexedIndirectCountAMD");
+    VK_EXT_RESET(vkCmdDrawIndirectCountAMD);
+    VK_EXT_RESET(vkCmdDrawIndexedIndirectCountAMD);
 #endif /* VK_AMD_draw_indirect_count */
 #ifdef VK_AMD_shader_info
-    pfn_vkGetShaderInfoAMD = (PFN_vkGetShaderInfoAMD)vkGetInstanceProcAddr(instance, "vkGetShaderInfoAMD");
+    VK_EXT_RESET(vkGetShaderInfoAMD);
 #endif /* VK_AMD_shader_info */
 #ifdef VK_NV_external_memory_capabilities
-    pfn_vkGetPhysicalDeviceExternalImageFormatPropertiesNV = (PFN_vkGetPhysicalDeviceExternalImageFormatPropertiesNV)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceExternalImageFormatPropertiesNV");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalImageFormatPropertiesNV);
 #endif /* VK_NV_external_memory_capabilities */
 #ifdef VK_NV_external_memory_win32
 #ifndef VK_NV_external_memory_win32
-    pfn_vkGetMemoryWin32HandleNV = (PFN_vkGetMemoryWin32HandleNV)vkGetInstanceProcAddr(instance, "vkGetMemoryWin32HandleNV");
+    VK_EXT_RESET(vkGetMemoryWin32HandleNV);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_NV_external_memory_win32 */
 #ifdef VK_KHX_device_group
-    pfn_vkGetDeviceGroupPeerMemoryFeaturesKHX = (PFN_vkGetDeviceGroupPeerMemoryFeaturesKHX)vkGetInstanceProcAddr(instance, "vkGetDeviceGroupPeerMemoryFeaturesKHX");
-    pfn_vkCmdSetDeviceMaskKHX = (PFN_vkCmdSetDeviceMaskKHX)vkGetInstanceProcAddr(instance, "vkCmdSetDeviceMaskKHX");
-    pfn_vkCmdDispatchBaseKHX = (PFN_vkCmdDispatchBaseKHX)vkGetInstanceProcAddr(instance, "vkCmdDispatchBaseKHX");
-    pfn_vkGetDeviceGroupPresentCapabilitiesKHX = (PFN_vkGetDeviceGroupPresentCapabilitiesKHX)vkGetInstanceProcAddr(instance, "vkGetDeviceGroupPresentCapabilitiesKHX");
-    pfn_vkGetDeviceGroupSurfacePresentModesKHX = (PFN_vkGetDeviceGroupSurfacePresentModesKHX)vkGetInstanceProcAddr(instance, "vkGetDeviceGroupSurfacePresentModesKHX");
-    pfn_vkGetPhysicalDevicePresentRectanglesKHX = (PFN_vkGetPhysicalDevicePresentRectanglesKHX)vkGetInstanceProcAddr(instance, "vkGetPhysicalDevicePresentRectanglesKHX");
-    pfn_vkAcquireNextImage2KHX = (PFN_vkAcquireNextImage2KHX)vkGetInstanceProcAddr(instance, "vkAcquireNextImage2KHX");
+    VK_EXT_RESET(vkGetDeviceGroupPeerMemoryFeaturesKHX);
+    VK_EXT_RESET(vkCmdSetDeviceMaskKHX);
+    VK_EXT_RESET(vkCmdDispatchBaseKHX);
+    VK_EXT_RESET(vkGetDeviceGroupPresentCapabilitiesKHX);
+    VK_EXT_RESET(vkGetDeviceGroupSurfacePresentModesKHX);
+    VK_EXT_RESET(vkGetPhysicalDevicePresentRectanglesKHX);
+    VK_EXT_RESET(vkAcquireNextImage2KHX);
 #endif /* VK_KHX_device_group */
 #ifdef VK_NN_vi_surface
 #ifndef VK_NN_vi_surface
-    pfn_vkCreateViSurfaceNN = (PFN_vkCreateViSurfaceNN)vkGetInstanceProcAddr(instance, "vkCreateViSurfaceNN");
+    VK_EXT_RESET(vkCreateViSurfaceNN);
 #endif /* VK_USE_PLATFORM_VI_NN */
 #endif /* VK_NN_vi_surface */
 #ifdef VK_KHX_device_group_creation
-    pfn_vkEnumeratePhysicalDeviceGroupsKHX = (PFN_vkEnumeratePhysicalDeviceGroupsKHX)vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDeviceGroupsKHX");
+    VK_EXT_RESET(vkEnumeratePhysicalDeviceGroupsKHX);
 #endif /* VK_KHX_device_group_creation */
 #ifdef VK_NVX_device_generated_commands
-    pfn_vkCmdProcessCommandsNVX = (PFN_vkCmdProcessCommandsNVX)vkGetInstanceProcAddr(instance, "vkCmdProcessCommandsNVX");
-    pfn_vkCmdReserveSpaceForCommandsNVX = (PFN_vkCmdReserveSpaceForCommandsNVX)vkGetInstanceProcAddr(instance, "vkCmdReserveSpaceForCommandsNVX");
-    pfn_vkCreateIndirectCommandsLayoutNVX = (PFN_vkCreateIndirectCommandsLayoutNVX)vkGetInstanceProcAddr(instance, "vkCreateIndirectCommandsLayoutNVX");
-    pfn_vkDestroyIndirectCommandsLayoutNVX = (PFN_vkDestroyIndirectCommandsLayoutNVX)vkGetInstanceProcAddr(instance, "vkDestroyIndirectCommandsLayoutNVX");
-    pfn_vkCreateObjectTableNVX = (PFN_vkCreateObjectTableNVX)vkGetInstanceProcAddr(instance, "vkCreateObjectTableNVX");
-    pfn_vkDestroyObjectTableNVX = (PFN_vkDestroyObjectTableNVX)vkGetInstanceProcAddr(instance, "vkDestroyObjectTableNVX");
-    pfn_vkRegisterObjectsNVX = (PFN_vkRegisterObjectsNVX)vkGetInstanceProcAddr(instance, "vkRegisterObjectsNVX");
-    pfn_vkUnregisterObjectsNVX = (PFN_vkUnregisterObjectsNVX)vkGetInstanceProcAddr(instance, "vkUnregisterObjectsNVX");
-    pfn_vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX = (PFN_vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX");
+    VK_EXT_RESET(vkCmdProcessCommandsNVX);
+    VK_EXT_RESET(vkCmdReserveSpaceForCommandsNVX);
+    VK_EXT_RESET(vkCreateIndirectCommandsLayoutNVX);
+    VK_EXT_RESET(vkDestroyIndirectCommandsLayoutNVX);
+    VK_EXT_RESET(vkCreateObjectTableNVX);
+    VK_EXT_RESET(vkDestroyObjectTableNVX);
+    VK_EXT_RESET(vkRegisterObjectsNVX);
+    VK_EXT_RESET(vkUnregisterObjectsNVX);
+    VK_EXT_RESET(vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX);
 #endif /* VK_NVX_device_generated_commands */
 #ifdef VK_NV_clip_space_w_scaling
-    pfn_vkCmdSetViewportWScalingNV = (PFN_vkCmdSetViewportWScalingNV)vkGetInstanceProcAddr(instance, "vkCmdSetViewportWScalingNV");
+    VK_EXT_RESET(vkCmdSetViewportWScalingNV);
 #endif /* VK_NV_clip_space_w_scaling */
 #ifdef VK_EXT_direct_mode_display
-    pfn_vkReleaseDisplayEXT = (PFN_vkReleaseDisplayEXT)vkGetInstanceProcAddr(instance, "vkReleaseDisplayEXT");
+    VK_EXT_RESET(vkReleaseDisplayEXT);
 #endif /* VK_EXT_direct_mode_display */
 #ifdef VK_EXT_acquire_xlib_display
 #ifndef VK_EXT_acquire_xlib_display
-    pfn_vkAcquireXlibDisplayEXT = (PFN_vkAcquireXlibDisplayEXT)vkGetInstanceProcAddr(instance, "vkAcquireXlibDisplayEXT");
-    pfn_vkGetRandROutputDisplayEXT = (PFN_vkGetRandROutputDisplayEXT)vkGetInstanceProcAddr(instance, "vkGetRandROutputDisplayEXT");
+    VK_EXT_RESET(vkAcquireXlibDisplayEXT);
+    VK_EXT_RESET(vkGetRandROutputDisplayEXT);
 #endif /* VK_USE_PLATFORM_XLIB_XRANDR_EXT */
 #endif /* VK_EXT_acquire_xlib_display */
 #ifdef VK_EXT_display_surface_counter
-    pfn_vkGetPhysicalDeviceSurfaceCapabilities2EXT = (PFN_vkGetPhysicalDeviceSurfaceCapabilities2EXT)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfaceCapabilities2EXT");
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceCapabilities2EXT);
 #endif /* VK_EXT_display_surface_counter */
 #ifdef VK_EXT_display_control
-    pfn_vkDisplayPowerControlEXT = (PFN_vkDisplayPowerControlEXT)vkGetInstanceProcAddr(instance, "vkDisplayPowerControlEXT");
-    pfn_vkRegisterDeviceEventEXT = (PFN_vkRegisterDeviceEventEXT)vkGetInstanceProcAddr(instance, "vkRegisterDeviceEventEXT");
-    pfn_vkRegisterDisplayEventEXT = (PFN_vkRegisterDisplayEventEXT)vkGetInstanceProcAddr(instance, "vkRegisterDisplayEventEXT");
-    pfn_vkGetSwapchainCounterEXT = (PFN_vkGetSwapchainCounterEXT)vkGetInstanceProcAddr(instance, "vkGetSwapchainCounterEXT");
+    VK_EXT_RESET(vkDisplayPowerControlEXT);
+    VK_EXT_RESET(vkRegisterDeviceEventEXT);
+    VK_EXT_RESET(vkRegisterDisplayEventEXT);
+    VK_EXT_RESET(vkGetSwapchainCounterEXT);
 #endif /* VK_EXT_display_control */
 #ifdef VK_GOOGLE_display_timing
-    pfn_vkGetRefreshCycleDurationGOOGLE = (PFN_vkGetRefreshCycleDurationGOOGLE)vkGetInstanceProcAddr(instance, "vkGetRefreshCycleDurationGOOGLE");
-    pfn_vkGetPastPresentationTimingGOOGLE = (PFN_vkGetPastPresentationTimingGOOGLE)vkGetInstanceProcAddr(instance, "vkGetPastPresentationTimingGOOGLE");
+    VK_EXT_RESET(vkGetRefreshCycleDurationGOOGLE);
+    VK_EXT_RESET(vkGetPastPresentationTimingGOOGLE);
 #endif /* VK_GOOGLE_display_timing */
 #ifdef VK_EXT_discard_rectangles
-    pfn_vkCmdSetDiscardRectangleEXT = (PFN_vkCmdSetDiscardRectangleEXT)vkGetInstanceProcAddr(instance, "vkCmdSetDiscardRectangleEXT");
+    VK_EXT_RESET(vkCmdSetDiscardRectangleEXT);
 #endif /* VK_EXT_discard_rectangles */
 #ifdef VK_EXT_hdr_metadata
-    pfn_vkSetHdrMetadataEXT = (PFN_vkSetHdrMetadataEXT)vkGetInstanceProcAddr(instance, "vkSetHdrMetadataEXT");
+    VK_EXT_RESET(vkSetHdrMetadataEXT);
 #endif /* VK_EXT_hdr_metadata */
 #ifdef VK_MVK_ios_surface
 #ifndef VK_MVK_ios_surface
-    pfn_vkCreateIOSSurfaceMVK = (PFN_vkCreateIOSSurfaceMVK)vkGetInstanceProcAddr(instance, "vkCreateIOSSurfaceMVK");
+    VK_EXT_RESET(vkCreateIOSSurfaceMVK);
 #endif /* VK_USE_PLATFORM_IOS_MVK */
 #endif /* VK_MVK_ios_surface */
 #ifdef VK_MVK_macos_surface
 #ifndef VK_MVK_macos_surface
-    pfn_vkCreateMacOSSurfaceMVK = (PFN_vkCreateMacOSSurfaceMVK)vkGetInstanceProcAddr(instance, "vkCreateMacOSSurfaceMVK");
+    VK_EXT_RESET(vkCreateMacOSSurfaceMVK);
 #endif /* VK_USE_PLATFORM_MACOS_MVK */
 #endif /* VK_MVK_macos_surface */
 #ifdef VK_EXT_sample_locations
-    pfn_vkCmdSetSampleLocationsEXT = (PFN_vkCmdSetSampleLocationsEXT)vkGetInstanceProcAddr(instance, "vkCmdSetSampleLocationsEXT");
-    pfn_vkGetPhysicalDeviceMultisamplePropertiesEXT = (PFN_vkGetPhysicalDeviceMultisamplePropertiesEXT)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMultisamplePropertiesEXT");
+    VK_EXT_RESET(vkCmdSetSampleLocationsEXT);
+    VK_EXT_RESET(vkGetPhysicalDeviceMultisamplePropertiesEXT);
 #endif /* VK_EXT_sample_locations */
 #ifdef VK_EXT_validation_cache
-    pfn_vkCreateValidationCacheEXT = (PFN_vkCreateValidationCacheEXT)vkGetInstanceProcAddr(instance, "vkCreateValidationCacheEXT");
-    pfn_vkDestroyValidationCacheEXT = (PFN_vkDestroyValidationCacheEXT)vkGetInstanceProcAddr(instance, "vkDestroyValidationCacheEXT");
-    pfn_vkMergeValidationCachesEXT = (PFN_vkMergeValidationCachesEXT)vkGetInstanceProcAddr(instance, "vkMergeValidationCachesEXT");
-    pfn_vkGetValidationCacheDataEXT = (PFN_vkGetValidationCacheDataEXT)vkGetInstanceProcAddr(instance, "vkGetValidationCacheDataEXT");
+    VK_EXT_RESET(vkCreateValidationCacheEXT);
+    VK_EXT_RESET(vkDestroyValidationCacheEXT);
+    VK_EXT_RESET(vkMergeValidationCachesEXT);
+    VK_EXT_RESET(vkGetValidationCacheDataEXT);
 #endif /* VK_EXT_validation_cache */
 #ifdef VK_EXT_external_memory_host
-    pfn_vkGetMemoryHostPointerPropertiesEXT = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetInstanceProcAddr(instance, "vkGetMemoryHostPointerPropertiesEXT");
+    VK_EXT_RESET(vkGetMemoryHostPointerPropertiesEXT);
 #endif /* VK_EXT_external_memory_host */
 #ifdef VK_AMD_buffer_marker
-    pfn_vkCmdWriteBufferMarkerAMD = (PFN_vkCmdWriteBufferMarkerAMD)vkGetInstanceProcAddr(instance, "vkCmdWriteBufferMarkerAMD");
+    VK_EXT_RESET(vkCmdWriteBufferMarkerAMD);
 #endif /* VK_AMD_buffer_marker */
 }
 
 void vkExtInitDevice(VkDevice device)
 {
+    VK_EXT_STORE(vkExtDevice, device);
 #ifdef VK_KHR_surface
-    pfn_vkDestroySurfaceKHR = (PFN_vkDestroySurfaceKHR)vkGetDeviceProcAddr(device, "vkDestroySurfaceKHR");
-    pfn_vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfaceSupportKHR");
-    pfn_vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
-    pfn_vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfaceFormatsKHR");
-    pfn_vkGetPhysicalDeviceSurfacePresentModesKHR = (PFN_vkGetPhysicalDeviceSurfacePresentModesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfacePresentModesKHR");
+    VK_EXT_RESET(vkDestroySurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceSupportKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceFormatsKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfacePresentModesKHR);
 #endif /* VK_KHR_surface */
 #ifdef VK_KHR_swapchain
-    pfn_vkCreateSwapchainKHR = (PFN_vkCreateSwapchainKHR)vkGetDeviceProcAddr(device, "vkCreateSwapchainKHR");
-    pfn_vkDestroySwapchainKHR = (PFN_vkDestroySwapchainKHR)vkGetDeviceProcAddr(device, "vkDestroySwapchainKHR");
-    pfn_vkGetSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR)vkGetDeviceProcAddr(device, "vkGetSwapchainImagesKHR");
-    pfn_vkAcquireNextImageKHR = (PFN_vkAcquireNextImageKHR)vkGetDeviceProcAddr(device, "vkAcquireNextImageKHR");
-    pfn_vkQueuePresentKHR = (PFN_vkQueuePresentKHR)vkGetDeviceProcAddr(device, "vkQueuePresentKHR");
+    VK_EXT_RESET(vkCreateSwapchainKHR);
+    VK_EXT_RESET(vkDestroySwapchainKHR);
+    VK_EXT_RESET(vkGetSwapchainImagesKHR);
+    VK_EXT_RESET(vkAcquireNextImageKHR);
+    VK_EXT_RESET(vkQueuePresentKHR);
 #endif /* VK_KHR_swapchain */
 #ifdef VK_KHR_display
-    pfn_vkGetPhysicalDeviceDisplayPropertiesKHR = (PFN_vkGetPhysicalDeviceDisplayPropertiesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceDisplayPropertiesKHR");
-    pfn_vkGetPhysicalDeviceDisplayPlanePropertiesKHR = (PFN_vkGetPhysicalDeviceDisplayPlanePropertiesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceDisplayPlanePropertiesKHR");
-    pfn_vkGetDisplayPlaneSupportedDisplaysKHR = (PFN_vkGetDisplayPlaneSupportedDisplaysKHR)vkGetDeviceProcAddr(device, "vkGetDisplayPlaneSupportedDisplaysKHR");
-    pfn_vkGetDisplayModePropertiesKHR = (PFN_vkGetDisplayModePropertiesKHR)vkGetDeviceProcAddr(device, "vkGetDisplayModePropertiesKHR");
-    pfn_vkCreateDisplayModeKHR = (PFN_vkCreateDisplayModeKHR)vkGetDeviceProcAddr(device, "vkCreateDisplayModeKHR");
-    pfn_vkGetDisplayPlaneCapabilitiesKHR = (PFN_vkGetDisplayPlaneCapabilitiesKHR)vkGetDeviceProcAddr(device, "vkGetDisplayPlaneCapabilitiesKHR");
-    pfn_vkCreateDisplayPlaneSurfaceKHR = (PFN_vkCreateDisplayPlaneSurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateDisplayPlaneSurfaceKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceDisplayPropertiesKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceDisplayPlanePropertiesKHR);
+    VK_EXT_RESET(vkGetDisplayPlaneSupportedDisplaysKHR);
+    VK_EXT_RESET(vkGetDisplayModePropertiesKHR);
+    VK_EXT_RESET(vkCreateDisplayModeKHR);
+    VK_EXT_RESET(vkGetDisplayPlaneCapabilitiesKHR);
+    VK_EXT_RESET(vkCreateDisplayPlaneSurfaceKHR);
 #endif /* VK_KHR_display */
 #ifdef VK_KHR_display_swapchain
-    pfn_vkCreateSharedSwapchainsKHR = (PFN_vkCreateSharedSwapchainsKHR)vkGetDeviceProcAddr(device, "vkCreateSharedSwapchainsKHR");
+    VK_EXT_RESET(vkCreateSharedSwapchainsKHR);
 #endif /* VK_KHR_display_swapchain */
 #ifdef VK_KHR_xlib_surface
 #ifndef VK_KHR_xlib_surface
-    pfn_vkCreateXlibSurfaceKHR = (PFN_vkCreateXlibSurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateXlibSurfaceKHR");
-    pfn_vkGetPhysicalDeviceXlibPresentationSupportKHR = (PFN_vkGetPhysicalDeviceXlibPresentationSupportKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceXlibPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateXlibSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceXlibPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_XLIB_KHR */
 #endif /* VK_KHR_xlib_surface */
 #ifdef VK_KHR_xcb_surface
 #ifndef VK_KHR_xcb_surface
-    pfn_vkCreateXcbSurfaceKHR = (PFN_vkCreateXcbSurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateXcbSurfaceKHR");
-    pfn_vkGetPhysicalDeviceXcbPresentationSupportKHR = (PFN_vkGetPhysicalDeviceXcbPresentationSupportKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceXcbPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateXcbSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceXcbPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_XCB_KHR */
 #endif /* VK_KHR_xcb_surface */
 #ifdef VK_KHR_wayland_surface
 #ifndef VK_KHR_wayland_surface
-    pfn_vkCreateWaylandSurfaceKHR = (PFN_vkCreateWaylandSurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateWaylandSurfaceKHR");
-    pfn_vkGetPhysicalDeviceWaylandPresentationSupportKHR = (PFN_vkGetPhysicalDeviceWaylandPresentationSupportKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceWaylandPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateWaylandSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceWaylandPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_WAYLAND_KHR */
 #endif /* VK_KHR_wayland_surface */
 #ifdef VK_KHR_mir_surface
 #ifndef VK_KHR_mir_surface
-    pfn_vkCreateMirSurfaceKHR = (PFN_vkCreateMirSurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateMirSurfaceKHR");
-    pfn_vkGetPhysicalDeviceMirPresentationSupportKHR = (PFN_vkGetPhysicalDeviceMirPresentationSupportKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceMirPresentationSupportKHR");
+    VK_EXT_RESET(vkCreateMirSurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceMirPresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_MIR_KHR */
 #endif /* VK_KHR_mir_surface */
 #ifdef VK_KHR_android_surface
 #ifndef VK_KHR_android_surface
-    pfn_vkCreateAndroidSurfaceKHR = (PFN_vkCreateAndroidSurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateAndroidSurfaceKHR");
+    VK_EXT_RESET(vkCreateAndroidSurfaceKHR);
 #endif /* VK_USE_PLATFORM_ANDROID_KHR */
 #endif /* VK_KHR_android_surface */
 #ifdef VK_KHR_win32_surface
 #ifndef VK_KHR_win32_surface
-    pfn_vkCreateWin32SurfaceKHR = (PFN_vkCreateWin32SurfaceKHR)vkGetDeviceProcAddr(device, "vkCreateWin32SurfaceKHR");
-    pfn_vkGetPhysicalDeviceWin32PresentationSupportKHR = (PFN_vkGetPhysicalDeviceWin32PresentationSupportKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceWin32PresentationSupportKHR");
+    VK_EXT_RESET(vkCreateWin32SurfaceKHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceWin32PresentationSupportKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_win32_surface */
 #ifdef VK_KHR_get_physical_device_properties2
-    pfn_vkGetPhysicalDeviceFeatures2KHR = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceFeatures2KHR");
-    pfn_vkGetPhysicalDeviceProperties2KHR = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceProperties2KHR");
-    pfn_vkGetPhysicalDeviceFormatProperties2KHR = (PFN_vkGetPhysicalDeviceFormatProperties2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceFormatProperties2KHR");
-    pfn_vkGetPhysicalDeviceImageFormatProperties2KHR = (PFN_vkGetPhysicalDeviceImageFormatProperties2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceImageFormatProperties2KHR");
-    pfn_vkGetPhysicalDeviceQueueFamilyProperties2KHR = (PFN_vkGetPhysicalDeviceQueueFamilyProperties2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceQueueFamilyProperties2KHR");
-    pfn_vkGetPhysicalDeviceMemoryProperties2KHR = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceMemoryProperties2KHR");
-    pfn_vkGetPhysicalDeviceSparseImageFormatProperties2KHR = (PFN_vkGetPhysicalDeviceSparseImageFormatProperties2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSparseImageFormatProperties2KHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceFeatures2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceFormatProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceImageFormatProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceQueueFamilyProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceMemoryProperties2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSparseImageFormatProperties2KHR);
 #endif /* VK_KHR_get_physical_device_properties2 */
 #ifdef VK_KHR_maintenance1
-    pfn_vkTrimCommandPoolKHR = (PFN_vkTrimCommandPoolKHR)vkGetDeviceProcAddr(device, "vkTrimCommandPoolKHR");
+    VK_EXT_RESET(vkTrimCommandPoolKHR);
 #endif /* VK_KHR_maintenance1 */
 #ifdef VK_KHR_external_memory_capabilities
-    pfn_vkGetPhysicalDeviceExternalBufferPropertiesKHR = (PFN_vkGetPhysicalDeviceExternalBufferPropertiesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceExternalBufferPropertiesKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalBufferPropertiesKHR);
 #endif /* VK_KHR_external_memory_capabilities */
 #ifdef VK_KHR_external_memory_win32
 #ifndef VK_KHR_external_memory_win32
-    pfn_vkGetMemoryWin32HandleKHR = (PFN_vkGetMemoryWin32HandleKHR)vkGetDeviceProcAddr(device, "vkGetMemoryWin32HandleKHR");
-    pfn_vkGetMemoryWin32HandlePropertiesKHR = (PFN_vkGetMemoryWin32HandlePropertiesKHR)vkGetDeviceProcAddr(device, "vkGetMemoryWin32HandlePropertiesKHR");
+    VK_EXT_RESET(vkGetMemoryWin32HandleKHR);
+    VK_EXT_RESET(vkGetMemoryWin32HandlePropertiesKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_external_memory_win32 */
 #ifdef VK_KHR_external_memory_fd
-    pfn_vkGetMemoryFdKHR = (PFN_vkGetMemoryFdKHR)vkGetDeviceProcAddr(device, "vkGetMemoryFdKHR");
-    pfn_vkGetMemoryFdPropertiesKHR = (PFN_vkGetMemoryFdPropertiesKHR)vkGetDeviceProcAddr(device, "vkGetMemoryFdPropertiesKHR");
+    VK_EXT_RESET(vkGetMemoryFdKHR);
+    VK_EXT_RESET(vkGetMemoryFdPropertiesKHR);
 #endif /* VK_KHR_external_memory_fd */
 #ifdef VK_KHR_external_semaphore_capabilities
-    pfn_vkGetPhysicalDeviceExternalSemaphorePropertiesKHR = (PFN_vkGetPhysicalDeviceExternalSemaphorePropertiesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceExternalSemaphorePropertiesKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalSemaphorePropertiesKHR);
 #endif /* VK_KHR_external_semaphore_capabilities */
 #ifdef VK_KHR_external_semaphore_win32
 #ifndef VK_KHR_external_semaphore_win32
-    pfn_vkImportSemaphoreWin32HandleKHR = (PFN_vkImportSemaphoreWin32HandleKHR)vkGetDeviceProcAddr(device, "vkImportSemaphoreWin32HandleKHR");
-    pfn_vkGetSemaphoreWin32HandleKHR = (PFN_vkGetSemaphoreWin32HandleKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreWin32HandleKHR");
+    VK_EXT_RESET(vkImportSemaphoreWin32HandleKHR);
+    VK_EXT_RESET(vkGetSemaphoreWin32HandleKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_external_semaphore_win32 */
 #ifdef VK_KHR_external_semaphore_fd
-    pfn_vkImportSemaphoreFdKHR = (PFN_vkImportSemaphoreFdKHR)vkGetDeviceProcAddr(device, "vkImportSemaphoreFdKHR");
-    pfn_vkGetSemaphoreFdKHR = (PFN_vkGetSemaphoreFdKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreFdKHR");
+    VK_EXT_RESET(vkImportSemaphoreFdKHR);
+    VK_EXT_RESET(vkGetSemaphoreFdKHR);
 #endif /* VK_KHR_external_semaphore_fd */
 #ifdef VK_KHR_push_descriptor
-    pfn_vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+    VK_EXT_RESET(vkCmdPushDescriptorSetKHR);
 #endif /* VK_KHR_push_descriptor */
 #ifdef VK_KHR_descriptor_update_template
-    pfn_vkCreateDescriptorUpdateTemplateKHR = (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplateKHR");
-    pfn_vkDestroyDescriptorUpdateTemplateKHR = (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplateKHR");
-    pfn_vkUpdateDescriptorSetWithTemplateKHR = (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplateKHR");
-    pfn_vkCmdPushDescriptorSetWithTemplateKHR = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetWithTemplateKHR");
+    VK_EXT_RESET(vkCreateDescriptorUpdateTemplateKHR);
+    VK_EXT_RESET(vkDestroyDescriptorUpdateTemplateKHR);
+    VK_EXT_RESET(vkUpdateDescriptorSetWithTemplateKHR);
+    VK_EXT_RESET(vkCmdPushDescriptorSetWithTemplateKHR);
 #endif /* VK_KHR_descriptor_update_template */
 #ifdef VK_KHR_shared_presentable_image
-    pfn_vkGetSwapchainStatusKHR = (PFN_vkGetSwapchainStatusKHR)vkGetDeviceProcAddr(device, "vkGetSwapchainStatusKHR");
+    VK_EXT_RESET(vkGetSwapchainStatusKHR);
 #endif /* VK_KHR_shared_presentable_image */
 #ifdef VK_KHR_external_fence_capabilities
-    pfn_vkGetPhysicalDeviceExternalFencePropertiesKHR = (PFN_vkGetPhysicalDeviceExternalFencePropertiesKHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceExternalFencePropertiesKHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalFencePropertiesKHR);
 #endif /* VK_KHR_external_fence_capabilities */
 #ifdef VK_KHR_external_fence_win32
 #ifndef VK_KHR_external_fence_win32
-    pfn_vkImportFenceWin32HandleKHR = (PFN_vkImportFenceWin32HandleKHR)vkGetDeviceProcAddr(device, "vkImportFenceWin32HandleKHR");
-    pfn_vkGetFenceWin32HandleKHR = (PFN_vkGetFenceWin32HandleKHR)vkGetDeviceProcAddr(device, "vkGetFenceWin32HandleKHR");
+    VK_EXT_RESET(vkImportFenceWin32HandleKHR);
+    VK_EXT_RESET(vkGetFenceWin32HandleKHR);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_KHR_external_fence_win32 */
 #ifdef VK_KHR_external_fence_fd
-    pfn_vkImportFenceFdKHR = (PFN_vkImportFenceFdKHR)vkGetDeviceProcAddr(device, "vkImportFenceFdKHR");
-    pfn_vkGetFenceFdKHR = (PFN_vkGetFenceFdKHR)vkGetDeviceProcAddr(device, "vkGetFenceFdKHR");
+    VK_EXT_RESET(vkImportFenceFdKHR);
+    VK_EXT_RESET(vkGetFenceFdKHR);
 #endif /* VK_KHR_external_fence_fd */
 #ifdef VK_KHR_get_surface_capabilities2
-    pfn_vkGetPhysicalDeviceSurfaceCapabilities2KHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilities2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfaceCapabilities2KHR");
-    pfn_vkGetPhysicalDeviceSurfaceFormats2KHR = (PFN_vkGetPhysicalDeviceSurfaceFormats2KHR)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfaceFormats2KHR");
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceCapabilities2KHR);
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceFormats2KHR);
 #endif /* VK_KHR_get_surface_capabilities2 */
 #ifdef VK_KHR_get_memory_requirements2
-    pfn_vkGetImageMemoryRequirements2KHR = (PFN_vkGetImageMemoryRequirements2KHR)vkGetDeviceProcAddr(device, "vkGetImageMemoryRequirements2KHR");
-    pfn_vkGetBufferMemoryRequirements2KHR = (PFN_vkGetBufferMemoryRequirements2KHR)vkGetDeviceProcAddr(device, "vkGetBufferMemoryRequirements2KHR");
-    pfn_vkGetImageSparseMemoryRequirements2KHR = (PFN_vkGetImageSparseMemoryRequirements2KHR)vkGetDeviceProcAddr(device, "vkGetImageSparseMemoryRequirements2KHR");
+    VK_EXT_RESET(vkGetImageMemoryRequirements2KHR);
+    VK_EXT_RESET(vkGetBufferMemoryRequirements2KHR);
+    VK_EXT_RESET(vkGetImageSparseMemoryRequirements2KHR);
 #endif /* VK_KHR_get_memory_requirements2 */
 #ifdef VK_KHR_sampler_ycbcr_conversion
-    pfn_vkCreateSamplerYcbcrConversionKHR = (PFN_vkCreateSamplerYcbcrConversionKHR)vkGetDeviceProcAddr(device, "vkCreateSamplerYcbcrConversionKHR");
-    pfn_vkDestroySamplerYcbcrConversionKHR = (PFN_vkDestroySamplerYcbcrConversionKHR)vkGetDeviceProcAddr(device, "vkDestroySamplerYcbcrConversionKHR");
+    VK_EXT_RESET(vkCreateSamplerYcbcrConversionKHR);
+    VK_EXT_RESET(vkDestroySamplerYcbcrConversionKHR);
 #endif /* VK_KHR_sampler_ycbcr_conversion */
 #ifdef VK_KHR_bind_memory2
-    pfn_vkBindBufferMemory2KHR = (PFN_vkBindBufferMemory2KHR)vkGetDeviceProcAddr(device, "vkBindBufferMemory2KHR");
-    pfn_vkBindImageMemory2KHR = (PFN_vkBindImageMemory2KHR)vkGetDeviceProcAddr(device, "vkBindImageMemory2KHR");
+    VK_EXT_RESET(vkBindBufferMemory2KHR);
+    VK_EXT_RESET(vkBindImageMemory2KHR);
 #endif /* VK_KHR_bind_memory2 */
 #ifdef VK_ANDROID_native_buffer
-    pfn_vkGetSwapchainGrallocUsageANDROID = (PFN_vkGetSwapchainGrallocUsageANDROID)vkGetDeviceProcAddr(device, "vkGetSwapchainGrallocUsageANDROID");
-    pfn_vkAcquireImageANDROID = (PFN_vkAcquireImageANDROID)vkGetDeviceProcAddr(device, "vkAcquireImageANDROID");
-    pfn_vkQueueSignalReleaseImageANDROID = (PFN_vkQueueSignalReleaseImageANDROID)vkGetDeviceProcAddr(device, "vkQueueSignalReleaseImageANDROID");
+    VK_EXT_RESET(vkGetSwapchainGrallocUsageANDROID);
+    VK_EXT_RESET(vkAcquireImageANDROID);
+    VK_EXT_RESET(vkQueueSignalReleaseImageANDROID);
 #endif /* VK_ANDROID_native_buffer */
 #ifdef VK_EXT_debug_report
-    pfn_vkCreateDebugReportCallbackEXT = (PFN_vkCreateDebugReportCallbackEXT)vkGetDeviceProcAddr(device, "vkCreateDebugReportCallbackEXT");
-    pfn_vkDestroyDebugReportCallbackEXT = (PFN_vkDestroyDebugReportCallbackEXT)vkGetDeviceProcAddr(device, "vkDestroyDebugReportCallbackEXT");
-    pfn_vkDebugReportMessageEXT = (PFN_vkDebugReportMessageEXT)vkGetDeviceProcAddr(device, "vkDebugReportMessageEXT");
+    VK_EXT_RESET(vkCreateDebugReportCallbackEXT);
+    VK_EXT_RESET(vkDestroyDebugReportCallbackEXT);
+    VK_EXT_RESET(vkDebugReportMessageEXT);
 #endif /* VK_EXT_debug_report */
 #ifdef VK_EXT_debug_marker
-    pfn_vkDebugMarkerSetObjectTagEXT = (PFN_vkDebugMarkerSetObjectTagEXT)vkGetDeviceProcAddr(device, "vkDebugMarkerSetObjectTagEXT");
-    pfn_vkDebugMarkerSetObjectNameEXT = (PFN_vkDebugMarkerSetObjectNameEXT)vkGetDeviceProcAddr(device, "vkDebugMarkerSetObjectNameEXT");
-    pfn_vkCmdDebugMarkerBeginEXT = (PFN_vkCmdDebugMarkerBeginEXT)vkGetDeviceProcAddr(device, "vkCmdDebugMarkerBeginEXT");
-    pfn_vkCmdDebugMarkerEndEXT = (PFN_vkCmdDebugMarkerEndEXT)vkGetDeviceProcAddr(device, "vkCmdDebugMarkerEndEXT");
-    pfn_vkCmdDebugMarkerInsertEXT = (PFN_vkCmdDebugMarkerInsertEXT)vkGetDeviceProcAddr(device, "vkCmdDebugMarkerInsertEXT");
+    VK_EXT_RESET(vkDebugMarkerSetObjectTagEXT);
+    VK_EXT_RESET(vkDebugMarkerSetObjectNameEXT);
+    VK_EXT_RESET(vkCmdDebugMarkerBeginEXT);
+    VK_EXT_RESET(vkCmdDebugMarkerEndEXT);
+    VK_EXT_RESET(vkCmdDebugMarkerInsertEXT);
 #endif /* VK_EXT_debug_marker */
 #ifdef VK_AMD_draw_indirect_count
-    pfn_vkCmdDrawIndirectCountAMD = (PFN_vkCmdDrawIndirectCountAMD)vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCountAMD");
-    pfn_vkCmdDrawIndexedIndirectCountAMD = (PFN_vkCmdDrawIndexedIndirectCountAMD)vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountAMD");
+    VK_EXT_RESET(vkCmdDrawIndirectCountAMD);
+    VK_EXT_RESET(vkCmdDrawIndexedIndirectCountAMD);
 #endif /* VK_AMD_draw_indirect_count */
 #ifdef VK_AMD_shader_info
-    pfn_vkGetShaderInfoAMD = (PFN_vkGetShaderInfoAMD)vkGetDeviceProcAddr(device, "vkGetShaderInfoAMD");
+    VK_EXT_RESET(vkGetShaderInfoAMD);
 #endif /* VK_AMD_shader_info */
 #ifdef VK_NV_external_memory_capabilities
-    pfn_vkGetPhysicalDeviceExternalImageFormatPropertiesNV = (PFN_vkGetPhysicalDeviceExternalImageFormatPropertiesNV)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceExternalImageFormatPropertiesNV");
+    VK_EXT_RESET(vkGetPhysicalDeviceExternalImageFormatPropertiesNV);
 #endif /* VK_NV_external_memory_capabilities */
 #ifdef VK_NV_external_memory_win32
 #ifndef VK_NV_external_memory_win32
-    pfn_vkGetMemoryWin32HandleNV = (PFN_vkGetMemoryWin32HandleNV)vkGetDeviceProcAddr(device, "vkGetMemoryWin32HandleNV");
+    VK_EXT_RESET(vkGetMemoryWin32HandleNV);
 #endif /* VK_USE_PLATFORM_WIN32_KHR */
 #endif /* VK_NV_external_memory_win32 */
 #ifdef VK_KHX_device_group
-    pfn_vkGetDeviceGroupPeerMemoryFeaturesKHX = (PFN_vkGetDeviceGroupPeerMemoryFeaturesKHX)vkGetDeviceProcAddr(device, "vkGetDeviceGroupPeerMemoryFeaturesKHX");
-    pfn_vkCmdSetDeviceMaskKHX = (PFN_vkCmdSetDeviceMaskKHX)vkGetDeviceProcAddr(device, "vkCmdSetDeviceMaskKHX");
-    pfn_vkCmdDispatchBaseKHX = (PFN_vkCmdDispatchBaseKHX)vkGetDeviceProcAddr(device, "vkCmdDispatchBaseKHX");
-    pfn_vkGetDeviceGroupPresentCapabilitiesKHX = (PFN_vkGetDeviceGroupPresentCapabilitiesKHX)vkGetDeviceProcAddr(device, "vkGetDeviceGroupPresentCapabilitiesKHX");
-    pfn_vkGetDeviceGroupSurfacePresentModesKHX = (PFN_vkGetDeviceGroupSurfacePresentModesKHX)vkGetDeviceProcAddr(device, "vkGetDeviceGroupSurfacePresentModesKHX");
-    pfn_vkGetPhysicalDevicePresentRectanglesKHX = (PFN_vkGetPhysicalDevicePresentRectanglesKHX)vkGetDeviceProcAddr(device, "vkGetPhysicalDevicePresentRectanglesKHX");
-    pfn_vkAcquireNextImage2KHX = (PFN_vkAcquireNextImage2KHX)vkGetDeviceProcAddr(device, "vkAcquireNextImage2KHX");
+    VK_EXT_RESET(vkGetDeviceGroupPeerMemoryFeaturesKHX);
+    VK_EXT_RESET(vkCmdSetDeviceMaskKHX);
+    VK_EXT_RESET(vkCmdDispatchBaseKHX);
+    VK_EXT_RESET(vkGetDeviceGroupPresentCapabilitiesKHX);
+    VK_EXT_RESET(vkGetDeviceGroupSurfacePresentModesKHX);
+    VK_EXT_RESET(vkGetPhysicalDevicePresentRectanglesKHX);
+    VK_EXT_RESET(vkAcquireNextImage2KHX);
 #endif /* VK_KHX_device_group */
 #ifdef VK_NN_vi_surface
 #ifndef VK_NN_vi_surface
-    pfn_vkCreateViSurfaceNN = (PFN_vkCreateViSurfaceNN)vkGetDeviceProcAddr(device, "vkCreateViSurfaceNN");
+    VK_EXT_RESET(vkCreateViSurfaceNN);
 #endif /* VK_USE_PLATFORM_VI_NN */
 #endif /* VK_NN_vi_surface */
 #ifdef VK_KHX_device_group_creation
-    pfn_vkEnumeratePhysicalDeviceGroupsKHX = (PFN_vkEnumeratePhysicalDeviceGroupsKHX)vkGetDeviceProcAddr(device, "vkEnumeratePhysicalDeviceGroupsKHX");
+    VK_EXT_RESET(vkEnumeratePhysicalDeviceGroupsKHX);
 #endif /* VK_KHX_device_group_creation */
 #ifdef VK_NVX_device_generated_commands
-    pfn_vkCmdProcessCommandsNVX = (PFN_vkCmdProcessCommandsNVX)vkGetDeviceProcAddr(device, "vkCmdProcessCommandsNVX");
-    pfn_vkCmdReserveSpaceForCommandsNVX = (PFN_vkCmdReserveSpaceForCommandsNVX)vkGetDeviceProcAddr(device, "vkCmdReserveSpaceForCommandsNVX");
-    pfn_vkCreateIndirectCommandsLayoutNVX = (PFN_vkCreateIndirectCommandsLayoutNVX)vkGetDeviceProcAddr(device, "vkCreateIndirectCommandsLayoutNVX");
-    pfn_vkDestroyIndirectCommandsLayoutNVX = (PFN_vkDestroyIndirectCommandsLayoutNVX)vkGetDeviceProcAddr(device, "vkDestroyIndirectCommandsLayoutNVX");
-    pfn_vkCreateObjectTableNVX = (PFN_vkCreateObjectTableNVX)vkGetDeviceProcAddr(device, "vkCreateObjectTableNVX");
-    pfn_vkDestroyObjectTableNVX = (PFN_vkDestroyObjectTableNVX)vkGetDeviceProcAddr(device, "vkDestroyObjectTableNVX");
-    pfn_vkRegisterObjectsNVX = (PFN_vkRegisterObjectsNVX)vkGetDeviceProcAddr(device, "vkRegisterObjectsNVX");
-    pfn_vkUnregisterObjectsNVX = (PFN_vkUnregisterObjectsNVX)vkGetDeviceProcAddr(device, "vkUnregisterObjectsNVX");
-    pfn_vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX = (PFN_vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX");
+    VK_EXT_RESET(vkCmdProcessCommandsNVX);
+    VK_EXT_RESET(vkCmdReserveSpaceForCommandsNVX);
+    VK_EXT_RESET(vkCreateIndirectCommandsLayoutNVX);
+    VK_EXT_RESET(vkDestroyIndirectCommandsLayoutNVX);
+    VK_EXT_RESET(vkCreateObjectTableNVX);
+    VK_EXT_RESET(vkDestroyObjectTableNVX);
+    VK_EXT_RESET(vkRegisterObjectsNVX);
+    VK_EXT_RESET(vkUnregisterObjectsNVX);
+    VK_EXT_RESET(vkGetPhysicalDeviceGeneratedCommandsPropertiesNVX);
 #endif /* VK_NVX_device_generated_commands */
 #ifdef VK_NV_clip_space_w_scaling
-    pfn_vkCmdSetViewportWScalingNV = (PFN_vkCmdSetViewportWScalingNV)vkGetDeviceProcAddr(device, "vkCmdSetViewportWScalingNV");
+    VK_EXT_RESET(vkCmdSetViewportWScalingNV);
 #endif /* VK_NV_clip_space_w_scaling */
 #ifdef VK_EXT_direct_mode_display
-    pfn_vkReleaseDisplayEXT = (PFN_vkReleaseDisplayEXT)vkGetDeviceProcAddr(device, "vkReleaseDisplayEXT");
+    VK_EXT_RESET(vkReleaseDisplayEXT);
 #endif /* VK_EXT_direct_mode_display */
 #ifdef VK_EXT_acquire_xlib_display
 #ifndef VK_EXT_acquire_xlib_display
-    pfn_vkAcquireXlibDisplayEXT = (PFN_vkAcquireXlibDisplayEXT)vkGetDeviceProcAddr(device, "vkAcquireXlibDisplayEXT");
-    pfn_vkGetRandROutputDisplayEXT = (PFN_vkGetRandROutputDisplayEXT)vkGetDeviceProcAddr(device, "vkGetRandROutputDisplayEXT");
+    VK_EXT_RESET(vkAcquireXlibDisplayEXT);
+    VK_EXT_RESET(vkGetRandROutputDisplayEXT);
 #endif /* VK_USE_PLATFORM_XLIB_XRANDR_EXT */
 #endif /* VK_EXT_acquire_xlib_display */
 #ifdef VK_EXT_display_surface_counter
-    pfn_vkGetPhysicalDeviceSurfaceCapabilities2EXT = (PFN_vkGetPhysicalDeviceSurfaceCapabilities2EXT)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceSurfaceCapabilities2EXT");
+    VK_EXT_RESET(vkGetPhysicalDeviceSurfaceCapabilities2EXT);
 #endif /* VK_EXT_display_surface_counter */
 #ifdef VK_EXT_display_control
-    pfn_vkDisplayPowerControlEXT = (PFN_vkDisplayPowerControlEXT)vkGetDeviceProcAddr(device, "vkDisplayPowerControlEXT");
-    pfn_vkRegisterDeviceEventEXT = (PFN_vkRegisterDeviceEventEXT)vkGetDeviceProcAddr(device, "vkRegisterDeviceEventEXT");
-    pfn_vkRegisterDisplayEventEXT = (PFN_vkRegisterDisplayEventEXT)vkGetDeviceProcAddr(device, "vkRegisterDisplayEventEXT");
-    pfn_vkGetSwapchainCounterEXT = (PFN_vkGetSwapchainCounterEXT)vkGetDeviceProcAddr(device, "vkGetSwapchainCounterEXT");
+    VK_EXT_RESET(vkDisplayPowerControlEXT);
+    VK_EXT_RESET(vkRegisterDeviceEventEXT);
+    VK_EXT_RESET(vkRegisterDisplayEventEXT);
+    VK_EXT_RESET(vkGetSwapchainCounterEXT);
 #endif /* VK_EXT_display_control */
 #ifdef VK_GOOGLE_display_timing
-    pfn_vkGetRefreshCycleDurationGOOGLE = (PFN_vkGetRefreshCycleDurationGOOGLE)vkGetDeviceProcAddr(device, "vkGetRefreshCycleDurationGOOGLE");
-    pfn_vkGetPastPresentationTimingGOOGLE = (PFN_vkGetPastPresentationTimingGOOGLE)vkGetDeviceProcAddr(device, "vkGetPastPresentationTimingGOOGLE");
+    VK_EXT_RESET(vkGetRefreshCycleDurationGOOGLE);
+    VK_EXT_RESET(vkGetPastPresentationTimingGOOGLE);
 #endif /* VK_GOOGLE_display_timing */
 #ifdef VK_EXT_discard_rectangles
-    pfn_vkCmdSetDiscardRectangleEXT = (PFN_vkCmdSetDiscardRectangleEXT)vkGetDeviceProcAddr(device, "vkCmdSetDiscardRectangleEXT");
+    VK_EXT_RESET(vkCmdSetDiscardRectangleEXT);
 #endif /* VK_EXT_discard_rectangles */
 #ifdef VK_EXT_hdr_metadata
-    pfn_vkSetHdrMetadataEXT = (PFN_vkSetHdrMetadataEXT)vkGetDeviceProcAddr(device, "vkSetHdrMetadataEXT");
+    VK_EXT_RESET(vkSetHdrMetadataEXT);
 #endif /* VK_EXT_hdr_metadata */
 #ifdef VK_MVK_ios_surface
 #ifndef VK_MVK_ios_surface
-    pfn_vkCreateIOSSurfaceMVK = (PFN_vkCreateIOSSurfaceMVK)vkGetDeviceProcAddr(device, "vkCreateIOSSurfaceMVK");
+    VK_EXT_RESET(vkCreateIOSSurfaceMVK);
 #endif /* VK_USE_PLATFORM_IOS_MVK */
 #endif /* VK_MVK_ios_surface */
 #ifdef VK_MVK_macos_surface
 #ifndef VK_MVK_macos_surface
-    pfn_vkCreateMacOSSurfaceMVK = (PFN_vkCreateMacOSSurfaceMVK)vkGetDeviceProcAddr(device, "vkCreateMacOSSurfaceMVK");
+    VK_EXT_RESET(vkCreateMacOSSurfaceMVK);
 #endif /* VK_USE_PLATFORM_MACOS_MVK */
 #endif /* VK_MVK_macos_surface */
 #ifdef VK_EXT_sample_locations
-    pfn_vkCmdSetSampleLocationsEXT = (PFN_vkCmdSetSampleLocationsEXT)vkGetDeviceProcAddr(device, "vkCmdSetSampleLocationsEXT");
-    pfn_vkGetPhysicalDeviceMultisamplePropertiesEXT = (PFN_vkGetPhysicalDeviceMultisamplePropertiesEXT)vkGetDeviceProcAddr(device, "vkGetPhysicalDeviceMultisamplePropertiesEXT");
+    VK_EXT_RESET(vkCmdSetSampleLocationsEXT);
+    VK_EXT_RESET(vkGetPhysicalDeviceMultisamplePropertiesEXT);
 #endif /* VK_EXT_sample_locations */
 #ifdef VK_EXT_validation_cache
-    pfn_vkCreateValidationCacheEXT = (PFN_vkCreateValidationCacheEXT)vkGetDeviceProcAddr(device, "vkCreateValidationCacheEXT");
-    pfn_vkDestroyValidationCacheEXT = (PFN_vkDestroyValidationCacheEXT)vkGetDeviceProcAddr(device, "vkDestroyValidationCacheEXT");
-    pfn_vkMergeValidationCachesEXT = (PFN_vkMergeValidationCachesEXT)vkGetDeviceProcAddr(device, "vkMergeValidationCachesEXT");
-    pfn_vkGetValidationCacheDataEXT = (PFN_vkGetValidationCacheDataEXT)vkGetDeviceProcAddr(device, "vkGetValidationCacheDataEXT");
+    VK_EXT_RESET(vkCreateValidationCacheEXT);
+    VK_EXT_RESET(vkDestroyValidationCacheEXT);
+    VK_EXT_RESET(vkMergeValidationCachesEXT);
+    VK_EXT_RESET(vkGetValidationCacheDataEXT);
 #endif /* VK_EXT_validation_cache */
 #ifdef VK_EXT_external_memory_host
-    pfn_vkGetMemoryHostPointerPropertiesEXT = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetDeviceProcAddr(device, "vkGetMemoryHostPointerPropertiesEXT");
+    VK_EXT_RESET(vkGetMemoryHostPointerPropertiesEXT);
 #endif /* VK_EXT_external_memory_host */
 #ifdef VK_AMD_buffer_marker
-    pfn_vkCmdWriteBufferMarkerAMD = (PFN_vkCmdWriteBufferMarkerAMD)vkGetDeviceProcAddr(device, "vkCmdWriteBufferMarkerAMD");
+    VK_EXT_RESET(vkCmdWriteBufferMarkerAMD);
 #endif /* VK_AMD_buffer_marker */
 }
 
+void vkExtInitDeviceTable(VkDevice device, VkExtDeviceTable* table)
+{
+    table->vkQueueSubmit = (PFN_vkQueueSubmit)vkGetDeviceProcAddr(device, "vkQueueSubmit");
+    table->vkQueueWaitIdle = (PFN_vkQueueWaitIdle)vkGetDeviceProcAddr(device, "vkQueueWaitIdle");
+    table->vkWaitForFences = (PFN_vkWaitForFences)vkGetDeviceProcAddr(device, "vkWaitForFences");
+    table->vkResetFences = (PFN_vkResetFences)vkGetDeviceProcAddr(device, "vkResetFences");
+    table->vkGetFenceStatus = (PFN_vkGetFenceStatus)vkGetDeviceProcAddr(device, "vkGetFenceStatus");
+    table->vkMapMemory = (PFN_vkMapMemory)vkGetDeviceProcAddr(device, "vkMapMemory");
+    table->vkUnmapMemory = (PFN_vkUnmapMemory)vkGetDeviceProcAddr(device, "vkUnmapMemory");
+    table->vkFlushMappedMemoryRanges = (PFN_vkFlushMappedMemoryRanges)vkGetDeviceProcAddr(device, "vkFlushMappedMemoryRanges");
+    table->vkInvalidateMappedMemoryRanges = (PFN_vkInvalidateMappedMemoryRanges)vkGetDeviceProcAddr(device, "vkInvalidateMappedMemoryRanges");
+    table->vkBeginCommandBuffer = (PFN_vkBeginCommandBuffer)vkGetDeviceProcAddr(device, "vkBeginCommandBuffer");
+    table->vkEndCommandBuffer = (PFN_vkEndCommandBuffer)vkGetDeviceProcAddr(device, "vkEndCommandBuffer");
+    table->vkResetCommandBuffer = (PFN_vkResetCommandBuffer)vkGetDeviceProcAddr(device, "vkResetCommandBuffer");
+    table->vkCmdBindPipeline = (PFN_vkCmdBindPipeline)vkGetDeviceProcAddr(device, "vkCmdBindPipeline");
+    table->vkCmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)vkGetDeviceProcAddr(device, "vkCmdBindDescriptorSets");
+    table->vkCmdPushConstants = (PFN_vkCmdPushConstants)vkGetDeviceProcAddr(device, "vkCmdPushConstants");
+    table->vkCmdDispatch = (PFN_vkCmdDispatch)vkGetDeviceProcAddr(device, "vkCmdDispatch");
+    table->vkCmdDispatchIndirect = (PFN_vkCmdDispatchIndirect)vkGetDeviceProcAddr(device, "vkCmdDispatchIndirect");
+    table->vkCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier");
+    table->vkCmdCopyBuffer = (PFN_vkCmdCopyBuffer)vkGetDeviceProcAddr(device, "vkCmdCopyBuffer");
+    table->vkCmdFillBuffer = (PFN_vkCmdFillBuffer)vkGetDeviceProcAddr(device, "vkCmdFillBuffer");
+#ifdef VK_KHR_swapchain
+    table->vkCreateSwapchainKHR = (PFN_vkCreateSwapchainKHR)vkGetDeviceProcAddr(device, "vkCreateSwapchainKHR");
+    table->vkDestroySwapchainKHR = (PFN_vkDestroySwapchainKHR)vkGetDeviceProcAddr(device, "vkDestroySwapchainKHR");
+    table->vkGetSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR)vkGetDeviceProcAddr(device, "vkGetSwapchainImagesKHR");
+    table->vkAcquireNextImageKHR = (PFN_vkAcquireNextImageKHR)vkGetDeviceProcAddr(device, "vkAcquireNextImageKHR");
+    table->vkQueuePresentKHR = (PFN_vkQueuePresentKHR)vkGetDeviceProcAddr(device, "vkQueuePresentKHR");
+#endif /* VK_KHR_swapchain */
+#ifdef VK_KHR_display_swapchain
+    table->vkCreateSharedSwapchainsKHR = (PFN_vkCreateSharedSwapchainsKHR)vkGetDeviceProcAddr(device, "vkCreateSharedSwapchainsKHR");
+#endif /* VK_KHR_display_swapchain */
+#ifdef VK_KHR_maintenance1
+    table->vkTrimCommandPoolKHR = (PFN_vkTrimCommandPoolKHR)vkGetDeviceProcAddr(device, "vkTrimCommandPoolKHR");
+#endif /* VK_KHR_maintenance1 */
+#ifdef VK_KHR_external_memory_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    table->vkGetMemoryWin32HandleKHR = (PFN_vkGetMemoryWin32HandleKHR)vkGetDeviceProcAddr(device, "vkGetMemoryWin32HandleKHR");
+    table->vkGetMemoryWin32HandlePropertiesKHR = (PFN_vkGetMemoryWin32HandlePropertiesKHR)vkGetDeviceProcAddr(device, "vkGetMemoryWin32HandlePropertiesKHR");
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_KHR_external_memory_win32 */
+#ifdef VK_KHR_external_memory_fd
+    table->vkGetMemoryFdKHR = (PFN_vkGetMemoryFdKHR)vkGetDeviceProcAddr(device, "vkGetMemoryFdKHR");
+    table->vkGetMemoryFdPropertiesKHR = (PFN_vkGetMemoryFdPropertiesKHR)vkGetDeviceProcAddr(device, "vkGetMemoryFdPropertiesKHR");
+#endif /* VK_KHR_external_memory_fd */
+#ifdef VK_KHR_external_semaphore_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    table->vkImportSemaphoreWin32HandleKHR = (PFN_vkImportSemaphoreWin32HandleKHR)vkGetDeviceProcAddr(device, "vkImportSemaphoreWin32HandleKHR");
+    table->vkGetSemaphoreWin32HandleKHR = (PFN_vkGetSemaphoreWin32HandleKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreWin32HandleKHR");
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_KHR_external_semaphore_win32 */
+#ifdef VK_KHR_external_semaphore_fd
+    table->vkImportSemaphoreFdKHR = (PFN_vkImportSemaphoreFdKHR)vkGetDeviceProcAddr(device, "vkImportSemaphoreFdKHR");
+    table->vkGetSemaphoreFdKHR = (PFN_vkGetSemaphoreFdKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreFdKHR");
+#endif /* VK_KHR_external_semaphore_fd */
+#ifdef VK_KHR_push_descriptor
+    table->vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+#endif /* VK_KHR_push_descriptor */
+#ifdef VK_KHR_descriptor_update_template
+    table->vkCreateDescriptorUpdateTemplateKHR = (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplateKHR");
+    table->vkDestroyDescriptorUpdateTemplateKHR = (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplateKHR");
+    table->vkUpdateDescriptorSetWithTemplateKHR = (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplateKHR");
+    table->vkCmdPushDescriptorSetWithTemplateKHR = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetWithTemplateKHR");
+#endif /* VK_KHR_descriptor_update_template */
+#ifdef VK_KHR_shared_presentable_image
+    table->vkGetSwapchainStatusKHR = (PFN_vkGetSwapchainStatusKHR)vkGetDeviceProcAddr(device, "vkGetSwapchainStatusKHR");
+#endif /* VK_KHR_shared_presentable_image */
+#ifdef VK_KHR_external_fence_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    table->vkImportFenceWin32HandleKHR = (PFN_vkImportFenceWin32HandleKHR)vkGetDeviceProcAddr(device, "vkImportFenceWin32HandleKHR");
+    table->vkGetFenceWin32HandleKHR = (PFN_vkGetFenceWin32HandleKHR)vkGetDeviceProcAddr(device, "vkGetFenceWin32HandleKHR");
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_KHR_external_fence_win32 */
+#ifdef VK_KHR_external_fence_fd
+    table->vkImportFenceFdKHR = (PFN_vkImportFenceFdKHR)vkGetDeviceProcAddr(device, "vkImportFenceFdKHR");
+    table->vkGetFenceFdKHR = (PFN_vkGetFenceFdKHR)vkGetDeviceProcAddr(device, "vkGetFenceFdKHR");
+#endif /* VK_KHR_external_fence_fd */
+#ifdef VK_KHR_get_memory_requirements2
+    table->vkGetImageMemoryRequirements2KHR = (PFN_vkGetImageMemoryRequirements2KHR)vkGetDeviceProcAddr(device, "vkGetImageMemoryRequirements2KHR");
+    table->vkGetBufferMemoryRequirements2KHR = (PFN_vkGetBufferMemoryRequirements2KHR)vkGetDeviceProcAddr(device, "vkGetBufferMemoryRequirements2KHR");
+    table->vkGetImageSparseMemoryRequirements2KHR = (PFN_vkGetImageSparseMemoryRequirements2KHR)vkGetDeviceProcAddr(device, "vkGetImageSparseMemoryRequirements2KHR");
+#endif /* VK_KHR_get_memory_requirements2 */
+#ifdef VK_KHR_sampler_ycbcr_conversion
+    table->vkCreateSamplerYcbcrConversionKHR = (PFN_vkCreateSamplerYcbcrConversionKHR)vkGetDeviceProcAddr(device, "vkCreateSamplerYcbcrConversionKHR");
+    table->vkDestroySamplerYcbcrConversionKHR = (PFN_vkDestroySamplerYcbcrConversionKHR)vkGetDeviceProcAddr(device, "vkDestroySamplerYcbcrConversionKHR");
+#endif /* VK_KHR_sampler_ycbcr_conversion */
+#ifdef VK_KHR_bind_memory2
+    table->vkBindBufferMemory2KHR = (PFN_vkBindBufferMemory2KHR)vkGetDeviceProcAddr(device, "vkBindBufferMemory2KHR");
+    table->vkBindImageMemory2KHR = (PFN_vkBindImageMemory2KHR)vkGetDeviceProcAddr(device, "vkBindImageMemory2KHR");
+#endif /* VK_KHR_bind_memory2 */
+#ifdef VK_ANDROID_native_buffer
+    table->vkGetSwapchainGrallocUsageANDROID = (PFN_vkGetSwapchainGrallocUsageANDROID)vkGetDeviceProcAddr(device, "vkGetSwapchainGrallocUsageANDROID");
+    table->vkAcquireImageANDROID = (PFN_vkAcquireImageANDROID)vkGetDeviceProcAddr(device, "vkAcquireImageANDROID");
+    table->vkQueueSignalReleaseImageANDROID = (PFN_vkQueueSignalReleaseImageANDROID)vkGetDeviceProcAddr(device, "vkQueueSignalReleaseImageANDROID");
+#endif /* VK_ANDROID_native_buffer */
+#ifdef VK_EXT_debug_marker
+    table->vkDebugMarkerSetObjectTagEXT = (PFN_vkDebugMarkerSetObjectTagEXT)vkGetDeviceProcAddr(device, "vkDebugMarkerSetObjectTagEXT");
+    table->vkDebugMarkerSetObjectNameEXT = (PFN_vkDebugMarkerSetObjectNameEXT)vkGetDeviceProcAddr(device, "vkDebugMarkerSetObjectNameEXT");
+    table->vkCmdDebugMarkerBeginEXT = (PFN_vkCmdDebugMarkerBeginEXT)vkGetDeviceProcAddr(device, "vkCmdDebugMarkerBeginEXT");
+    table->vkCmdDebugMarkerEndEXT = (PFN_vkCmdDebugMarkerEndEXT)vkGetDeviceProcAddr(device, "vkCmdDebugMarkerEndEXT");
+    table->vkCmdDebugMarkerInsertEXT = (PFN_vkCmdDebugMarkerInsertEXT)vkGetDeviceProcAddr(device, "vkCmdDebugMarkerInsertEXT");
+#endif /* VK_EXT_debug_marker */
+#ifdef VK_AMD_draw_indirect_count
+    table->vkCmdDrawIndirectCountAMD = (PFN_vkCmdDrawIndirectCountAMD)vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCountAMD");
+    table->vkCmdDrawIndexedIndirectCountAMD = (PFN_vkCmdDrawIndexedIndirectCountAMD)vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountAMD");
+#endif /* VK_AMD_draw_indirect_count */
+#ifdef VK_AMD_shader_info
+    table->vkGetShaderInfoAMD = (PFN_vkGetShaderInfoAMD)vkGetDeviceProcAddr(device, "vkGetShaderInfoAMD");
+#endif /* VK_AMD_shader_info */
+#ifdef VK_NV_external_memory_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    table->vkGetMemoryWin32HandleNV = (PFN_vkGetMemoryWin32HandleNV)vkGetDeviceProcAddr(device, "vkGetMemoryWin32HandleNV");
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_NV_external_memory_win32 */
+#ifdef VK_KHX_device_group
+    table->vkGetDeviceGroupPeerMemoryFeaturesKHX = (PFN_vkGetDeviceGroupPeerMemoryFeaturesKHX)vkGetDeviceProcAddr(device, "vkGetDeviceGroupPeerMemoryFeaturesKHX");
+    table->vkCmdSetDeviceMaskKHX = (PFN_vkCmdSetDeviceMaskKHX)vkGetDeviceProcAddr(device, "vkCmdSetDeviceMaskKHX");
+    table->vkCmdDispatchBaseKHX = (PFN_vkCmdDispatchBaseKHX)vkGetDeviceProcAddr(device, "vkCmdDispatchBaseKHX");
+    table->vkGetDeviceGroupPresentCapabilitiesKHX = (PFN_vkGetDeviceGroupPresentCapabilitiesKHX)vkGetDeviceProcAddr(device, "vkGetDeviceGroupPresentCapabilitiesKHX");
+    table->vkGetDeviceGroupSurfacePresentModesKHX = (PFN_vkGetDeviceGroupSurfacePresentModesKHX)vkGetDeviceProcAddr(device, "vkGetDeviceGroupSurfacePresentModesKHX");
+    table->vkAcquireNextImage2KHX = (PFN_vkAcquireNextImage2KHX)vkGetDeviceProcAddr(device, "vkAcquireNextImage2KHX");
+#endif /* VK_KHX_device_group */
+#ifdef VK_NVX_device_generated_commands
+    table->vkCmdProcessCommandsNVX = (PFN_vkCmdProcessCommandsNVX)vkGetDeviceProcAddr(device, "vkCmdProcessCommandsNVX");
+    table->vkCmdReserveSpaceForCommandsNVX = (PFN_vkCmdReserveSpaceForCommandsNVX)vkGetDeviceProcAddr(device, "vkCmdReserveSpaceForCommandsNVX");
+    table->vkCreateIndirectCommandsLayoutNVX = (PFN_vkCreateIndirectCommandsLayoutNVX)vkGetDeviceProcAddr(device, "vkCreateIndirectCommandsLayoutNVX");
+    table->vkDestroyIndirectCommandsLayoutNVX = (PFN_vkDestroyIndirectCommandsLayoutNVX)vkGetDeviceProcAddr(device, "vkDestroyIndirectCommandsLayoutNVX");
+    table->vkCreateObjectTableNVX = (PFN_vkCreateObjectTableNVX)vkGetDeviceProcAddr(device, "vkCreateObjectTableNVX");
+    table->vkDestroyObjectTableNVX = (PFN_vkDestroyObjectTableNVX)vkGetDeviceProcAddr(device, "vkDestroyObjectTableNVX");
+    table->vkRegisterObjectsNVX = (PFN_vkRegisterObjectsNVX)vkGetDeviceProcAddr(device, "vkRegisterObjectsNVX");
+    table->vkUnregisterObjectsNVX = (PFN_vkUnregisterObjectsNVX)vkGetDeviceProcAddr(device, "vkUnregisterObjectsNVX");
+#endif /* VK_NVX_device_generated_commands */
+#ifdef VK_NV_clip_space_w_scaling
+    table->vkCmdSetViewportWScalingNV = (PFN_vkCmdSetViewportWScalingNV)vkGetDeviceProcAddr(device, "vkCmdSetViewportWScalingNV");
+#endif /* VK_NV_clip_space_w_scaling */
+#ifdef VK_EXT_display_control
+    table->vkDisplayPowerControlEXT = (PFN_vkDisplayPowerControlEXT)vkGetDeviceProcAddr(device, "vkDisplayPowerControlEXT");
+    table->vkRegisterDeviceEventEXT = (PFN_vkRegisterDeviceEventEXT)vkGetDeviceProcAddr(device, "vkRegisterDeviceEventEXT");
+    table->vkRegisterDisplayEventEXT = (PFN_vkRegisterDisplayEventEXT)vkGetDeviceProcAddr(device, "vkRegisterDisplayEventEXT");
+    table->vkGetSwapchainCounterEXT = (PFN_vkGetSwapchainCounterEXT)vkGetDeviceProcAddr(device, "vkGetSwapchainCounterEXT");
+#endif /* VK_EXT_display_control */
+#ifdef VK_GOOGLE_display_timing
+    table->vkGetRefreshCycleDurationGOOGLE = (PFN_vkGetRefreshCycleDurationGOOGLE)vkGetDeviceProcAddr(device, "vkGetRefreshCycleDurationGOOGLE");
+    table->vkGetPastPresentationTimingGOOGLE = (PFN_vkGetPastPresentationTimingGOOGLE)vkGetDeviceProcAddr(device, "vkGetPastPresentationTimingGOOGLE");
+#endif /* VK_GOOGLE_display_timing */
+#ifdef VK_EXT_discard_rectangles
+    table->vkCmdSetDiscardRectangleEXT = (PFN_vkCmdSetDiscardRectangleEXT)vkGetDeviceProcAddr(device, "vkCmdSetDiscardRectangleEXT");
+#endif /* VK_EXT_discard_rectangles */
+#ifdef VK_EXT_hdr_metadata
+    table->vkSetHdrMetadataEXT = (PFN_vkSetHdrMetadataEXT)vkGetDeviceProcAddr(device, "vkSetHdrMetadataEXT");
+#endif /* VK_EXT_hdr_metadata */
+#ifdef VK_EXT_sample_locations
+    table->vkCmdSetSampleLocationsEXT = (PFN_vkCmdSetSampleLocationsEXT)vkGetDeviceProcAddr(device, "vkCmdSetSampleLocationsEXT");
+#endif /* VK_EXT_sample_locations */
+#ifdef VK_EXT_validation_cache
+    table->vkCreateValidationCacheEXT = (PFN_vkCreateValidationCacheEXT)vkGetDeviceProcAddr(device, "vkCreateValidationCacheEXT");
+    table->vkDestroyValidationCacheEXT = (PFN_vkDestroyValidationCacheEXT)vkGetDeviceProcAddr(device, "vkDestroyValidationCacheEXT");
+    table->vkMergeValidationCachesEXT = (PFN_vkMergeValidationCachesEXT)vkGetDeviceProcAddr(device, "vkMergeValidationCachesEXT");
+    table->vkGetValidationCacheDataEXT = (PFN_vkGetValidationCacheDataEXT)vkGetDeviceProcAddr(device, "vkGetValidationCacheDataEXT");
+#endif /* VK_EXT_validation_cache */
+#ifdef VK_EXT_external_memory_host
+    table->vkGetMemoryHostPointerPropertiesEXT = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetDeviceProcAddr(device, "vkGetMemoryHostPointerPropertiesEXT");
+#endif /* VK_EXT_external_memory_host */
+#ifdef VK_AMD_buffer_marker
+    table->vkCmdWriteBufferMarkerAMD = (PFN_vkCmdWriteBufferMarkerAMD)vkGetDeviceProcAddr(device, "vkCmdWriteBufferMarkerAMD");
+#endif /* VK_AMD_buffer_marker */
+}
@@ -46,9 +46,15 @@ extern "C" {
 **
 ** vkExtInitDevice(device);
 **
-** once the device has been initialized. This will resolve the function pointers
-** upfront and thus removes one indirection for each call into the driver. This *can*
-** result in slightly more performance for calling overhead limited cases.
+** once the device has been initialized. The function pointers are then resolved
+** against that device, so calls go straight into the driver and skip one indirection
+** each. This *can* result in slightly more performance for calling overhead limited
+** cases.
+**
+** Either call is cheap: neither resolves anything itself. Each entry point is looked
+** up on its first use, so only the extensions a program actually calls are ever
+** resolved. Resolution is thread-safe; calling into an extension from several
+** threads at once is fine.
 */
 
 #include <vulkan/vulkan.h>
@@ -56,6 +62,187 @@ extern "C" {
 void vkExtInitInstance(VkInstance instance);
 void vkExtInitDevice(VkDevice device);
 
+/*
+** A dispatch table for one device, for programs that use several devices or
+** want to skip the loader's trampoline on their hot path. Every entry calls
+** straight into the driver of the device the table was initialized with, so
+** each device needs its own table; the table is owned by the caller.
+**
+** The core commands are the ones a compute program calls per frame or per
+** submit; the rest of the core API is best left to the loader.
+*/
+typedef struct VkExtDeviceTable {
+    /* Core commands. */
+    PFN_vkQueueSubmit vkQueueSubmit;
+    PFN_vkQueueWaitIdle vkQueueWaitIdle;
+    PFN_vkWaitForFences vkWaitForFences;
+    PFN_vkResetFences vkResetFences;
+    PFN_vkGetFenceStatus vkGetFenceStatus;
+    PFN_vkMapMemory vkMapMemory;
+    PFN_vkUnmapMemory vkUnmapMemory;
+    PFN_vkFlushMappedMemoryRanges vkFlushMappedMemoryRanges;
+    PFN_vkInvalidateMappedMemoryRanges vkInvalidateMappedMemoryRanges;
+    PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
+    PFN_vkEndCommandBuffer vkEndCommandBuffer;
+    PFN_vkResetCommandBuffer vkResetCommandBuffer;
+    PFN_vkCmdBindPipeline vkCmdBindPipeline;
+    PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets;
+    PFN_vkCmdPushConstants vkCmdPushConstants;
+    PFN_vkCmdDispatch vkCmdDispatch;
+    PFN_vkCmdDispatchIndirect vkCmdDispatchIndirect;
+    PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier;
+    PFN_vkCmdCopyBuffer vkCmdCopyBuffer;
+    PFN_vkCmdFillBuffer vkCmdFillBuffer;
+
+    /* Device-level extension commands, NULL unless the extension is enabled. */
+#ifdef VK_KHR_swapchain
+    PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
+    PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
+    PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
+    PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
+    PFN_vkQueuePresentKHR vkQueuePresentKHR;
+#endif /* VK_KHR_swapchain */
+#ifdef VK_KHR_display_swapchain
+    PFN_vkCreateSharedSwapchainsKHR vkCreateSharedSwapchainsKHR;
+#endif /* VK_KHR_display_swapchain */
+#ifdef VK_KHR_maintenance1
+    PFN_vkTrimCommandPoolKHR vkTrimCommandPoolKHR;
+#endif /* VK_KHR_maintenance1 */
+#ifdef VK_KHR_external_memory_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    PFN_vkGetMemoryWin32HandleKHR vkGetMemoryWin32HandleKHR;
+    PFN_vkGetMemoryWin32HandlePropertiesKHR vkGetMemoryWin32HandlePropertiesKHR;
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_KHR_external_memory_win32 */
+#ifdef VK_KHR_external_memory_fd
+    PFN_vkGetMemoryFdKHR vkGetMemoryFdKHR;
+    PFN_vkGetMemoryFdPropertiesKHR vkGetMemoryFdPropertiesKHR;
+#endif /* VK_KHR_external_memory_fd */
+#ifdef VK_KHR_external_semaphore_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    PFN_vkImportSemaphoreWin32HandleKHR vkImportSemaphoreWin32HandleKHR;
+    PFN_vkGetSemaphoreWin32HandleKHR vkGetSemaphoreWin32HandleKHR;
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_KHR_external_semaphore_win32 */
+#ifdef VK_KHR_external_semaphore_fd
+    PFN_vkImportSemaphoreFdKHR vkImportSemaphoreFdKHR;
+    PFN_vkGetSemaphoreFdKHR vkGetSemaphoreFdKHR;
+#endif /* VK_KHR_external_semaphore_fd */
+#ifdef VK_KHR_push_descriptor
+    PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR;
+#endif /* VK_KHR_push_descriptor */
+#ifdef VK_KHR_descriptor_update_template
+    PFN_vkCreateDescriptorUpdateTemplateKHR vkCreateDescriptorUpdateTemplateKHR;
+    PFN_vkDestroyDescriptorUpdateTemplateKHR vkDestroyDescriptorUpdateTemplateKHR;
+    PFN_vkUpdateDescriptorSetWithTemplateKHR vkUpdateDescriptorSetWithTemplateKHR;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR vkCmdPushDescriptorSetWithTemplateKHR;
+#endif /* VK_KHR_descriptor_update_template */
+#ifdef VK_KHR_shared_presentable_image
+    PFN_vkGetSwapchainStatusKHR vkGetSwapchainStatusKHR;
+#endif /* VK_KHR_shared_presentable_image */
+#ifdef VK_KHR_external_fence_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    PFN_vkImportFenceWin32HandleKHR vkImportFenceWin32HandleKHR;
+    PFN_vkGetFenceWin32HandleKHR vkGetFenceWin32HandleKHR;
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_KHR_external_fence_win32 */
+#ifdef VK_KHR_external_fence_fd
+    PFN_vkImportFenceFdKHR vkImportFenceFdKHR;
+    PFN_vkGetFenceFdKHR vkGetFenceFdKHR;
+#endif /* VK_KHR_external_fence_fd */
+#ifdef VK_KHR_get_memory_requirements2
+    PFN_vkGetImageMemoryRequirements2KHR vkGetImageMemoryRequirements2KHR;
+    PFN_vkGetBufferMemoryRequirements2KHR vkGetBufferMemoryRequirements2KHR;
+    PFN_vkGetImageSparseMemoryRequirements2KHR vkGetImageSparseMemoryRequirements2KHR;
+#endif /* VK_KHR_get_memory_requirements2 */
+#ifdef VK_KHR_sampler_ycbcr_conversion
+    PFN_vkCreateSamplerYcbcrConversionKHR vkCreateSamplerYcbcrConversionKHR;
+    PFN_vkDestroySamplerYcbcrConversionKHR vkDestroySamplerYcbcrConversionKHR;
+#endif /* VK_KHR_sampler_ycbcr_conversion */
+#ifdef VK_KHR_bind_memory2
+    PFN_vkBindBufferMemory2KHR vkBindBufferMemory2KHR;
+    PFN_vkBindImageMemory2KHR vkBindImageMemory2KHR;
+#endif /* VK_KHR_bind_memory2 */
+#ifdef VK_ANDROID_native_buffer
+    PFN_vkGetSwapchainGrallocUsageANDROID vkGetSwapchainGrallocUsageANDROID;
+    PFN_vkAcquireImageANDROID vkAcquireImageANDROID;
+    PFN_vkQueueSignalReleaseImageANDROID vkQueueSignalReleaseImageANDROID;
+#endif /* VK_ANDROID_native_buffer */
+#ifdef VK_EXT_debug_marker
+    PFN_vkDebugMarkerSetObjectTagEXT vkDebugMarkerSetObjectTagEXT;
+    PFN_vkDebugMarkerSetObjectNameEXT vkDebugMarkerSetObjectNameEXT;
+    PFN_vkCmdDebugMarkerBeginEXT vkCmdDebugMarkerBeginEXT;
+    PFN_vkCmdDebugMarkerEndEXT vkCmdDebugMarkerEndEXT;
+    PFN_vkCmdDebugMarkerInsertEXT vkCmdDebugMarkerInsertEXT;
+#endif /* VK_EXT_debug_marker */
+#ifdef VK_AMD_draw_indirect_count
+    PFN_vkCmdDrawIndirectCountAMD vkCmdDrawIndirectCountAMD;
+    PFN_vkCmdDrawIndexedIndirectCountAMD vkCmdDrawIndexedIndirectCountAMD;
+#endif /* VK_AMD_draw_indirect_count */
+#ifdef VK_AMD_shader_info
+    PFN_vkGetShaderInfoAMD vkGetShaderInfoAMD;
+#endif /* VK_AMD_shader_info */
+#ifdef VK_NV_external_memory_win32
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+    PFN_vkGetMemoryWin32HandleNV vkGetMemoryWin32HandleNV;
+#endif /* VK_USE_PLATFORM_WIN32_KHR */
+#endif /* VK_NV_external_memory_win32 */
+#ifdef VK_KHX_device_group
+    PFN_vkGetDeviceGroupPeerMemoryFeaturesKHX vkGetDeviceGroupPeerMemoryFeaturesKHX;
+    PFN_vkCmdSetDeviceMaskKHX vkCmdSetDeviceMaskKHX;
+    PFN_vkCmdDispatchBaseKHX vkCmdDispatchBaseKHX;
+    PFN_vkGetDeviceGroupPresentCapabilitiesKHX vkGetDeviceGroupPresentCapabilitiesKHX;
+    PFN_vkGetDeviceGroupSurfacePresentModesKHX vkGetDeviceGroupSurfacePresentModesKHX;
+    PFN_vkAcquireNextImage2KHX vkAcquireNextImage2KHX;
+#endif /* VK_KHX_device_group */
+#ifdef VK_NVX_device_generated_commands
+    PFN_vkCmdProcessCommandsNVX vkCmdProcessCommandsNVX;
+    PFN_vkCmdReserveSpaceForCommandsNVX vkCmdReserveSpaceForCommandsNVX;
+    PFN_vkCreateIndirectCommandsLayoutNVX vkCreateIndirectCommandsLayoutNVX;
+    PFN_vkDestroyIndirectCommandsLayoutNVX vkDestroyIndirectCommandsLayoutNVX;
+    PFN_vkCreateObjectTableNVX vkCreateObjectTableNVX;
+    PFN_vkDestroyObjectTableNVX vkDestroyObjectTableNVX;
+    PFN_vkRegisterObjectsNVX vkRegisterObjectsNVX;
+    PFN_vkUnregisterObjectsNVX vkUnregisterObjectsNVX;
+#endif /* VK_NVX_device_generated_commands */
+#ifdef VK_NV_clip_space_w_scaling
+    PFN_vkCmdSetViewportWScalingNV vkCmdSetViewportWScalingNV;
+#endif /* VK_NV_clip_space_w_scaling */
+#ifdef VK_EXT_display_control
+    PFN_vkDisplayPowerControlEXT vkDisplayPowerControlEXT;
+    PFN_vkRegisterDeviceEventEXT vkRegisterDeviceEventEXT;
+    PFN_vkRegisterDisplayEventEXT vkRegisterDisplayEventEXT;
+    PFN_vkGetSwapchainCounterEXT vkGetSwapchainCounterEXT;
+#endif /* VK_EXT_display_control */
+#ifdef VK_GOOGLE_display_timing
+    PFN_vkGetRefreshCycleDurationGOOGLE vkGetRefreshCycleDurationGOOGLE;
+    PFN_vkGetPastPresentationTimingGOOGLE vkGetPastPresentationTimingGOOGLE;
+#endif /* VK_GOOGLE_display_timing */
+#ifdef VK_EXT_discard_rectangles
+    PFN_vkCmdSetDiscardRectangleEXT vkCmdSetDiscardRectangleEXT;
+#endif /* VK_EXT_discard_rectangles */
+#ifdef VK_EXT_hdr_metadata
+    PFN_vkSetHdrMetadataEXT vkSetHdrMetadataEXT;
+#endif /* VK_EXT_hdr_metadata */
+#ifdef VK_EXT_sample_locations
+    PFN_vkCmdSetSampleLocationsEXT vkCmdSetSampleLocationsEXT;
+#endif /* VK_EXT_sample_locations */
+#ifdef VK_EXT_validation_cache
+    PFN_vkCreateValidationCacheEXT vkCreateValidationCacheEXT;
+    PFN_vkDestroyValidationCacheEXT vkDestroyValidationCacheEXT;
+    PFN_vkMergeValidationCachesEXT vkMergeValidationCachesEXT;
+    PFN_vkGetValidationCacheDataEXT vkGetValidationCacheDataEXT;
+#endif /* VK_EXT_validation_cache */
+#ifdef VK_EXT_external_memory_host
+    PFN_vkGetMemoryHostPointerPropertiesEXT vkGetMemoryHostPointerPropertiesEXT;
+#endif /* VK_EXT_external_memory_host */
+#ifdef VK_AMD_buffer_marker
+    PFN_vkCmdWriteBufferMarkerAMD vkCmdWriteBufferMarkerAMD;
+#endif /* VK_AMD_buffer_marker */
+} VkExtDeviceTable;
+
+void vkExtInitDeviceTable(VkDevice device, VkExtDeviceTable* table);
+
 #ifdef __cplusplus
 }
 #endif
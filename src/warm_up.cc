@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "warm_up.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace warm_up {
+
+Pool::Pool(unsigned threads) {
+  for (unsigned i = 0; i < threads; ++i) {
+    threads_.emplace_back(&Pool::Work, this);
+  }
+}
+
+Pool::~Pool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+Pool::Task Pool::Add(std::function<void()> work) {
+  Task task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task = entries_.size();
+    entries_.emplace_back();
+    entries_.back().work = std::move(work);
+    queue_.push_back(task);
+  }
+  queued_.notify_one();
+  return task;
+}
+
+void Pool::Wait(Task task) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (task >= entries_.size()) {
+    throw std::out_of_range("warm_up::Pool::Wait: unknown task.");
+  }
+  auto &entry = entries_[task];
+  if (entry.state == State::kQueued) {
+    /* Left in queue_; the workers skip tasks that are no longer queued. */
+    RunLocked(task, &lock);
+  }
+  finished_.wait(lock, [&entry] {
+    return entry.state == State::kReady or entry.state == State::kFailed;
+  });
+  if (entry.error) {
+    std::rethrow_exception(entry.error);
+  }
+}
+
+void Pool::WaitAll() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (Task task = 0; task < entries_.size(); ++task) {
+    if (entries_[task].state == State::kQueued) {
+      RunLocked(task, &lock);
+    }
+    finished_.wait(lock, [this, task] {
+      return entries_[task].state == State::kReady or
+             entries_[task].state == State::kFailed;
+    });
+  }
+}
+
+Health Pool::health() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Health health;
+  for (const auto &entry : entries_) {
+    switch (entry.state) {
+      case State::kReady:
+        ++health.ready;
+        break;
+      case State::kFailed:
+        ++health.failed;
+        break;
+      default:
+        ++health.pending;
+    }
+  }
+  return health;
+}
+
+/* Runs a queued task with the lock released; returns with it held again. */
+void Pool::RunLocked(Task task, std::unique_lock<std::mutex> *lock) {
+  auto &entry = entries_[task];
+  entry.state = State::kRunning;
+  auto work = std::move(entry.work);
+  lock->unlock();
+  std::exception_ptr error;
+  try {
+    work();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  lock->lock();
+  entry.error = error;
+  entry.state = error ? State::kFailed : State::kReady;
+  finished_.notify_all();
+}
+
+void Pool::Work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    queued_.wait(lock, [this] { return stop_ or not queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+    Task task = queue_.front();
+    queue_.pop_front();
+    if (entries_[task].state == State::kQueued) {
+      RunLocked(task, &lock);
+    }
+  }
+}
+
+}  // namespace warm_up
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2018 Andre Cunha
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef WARM_UP_H
+#define WARM_UP_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Runs expensive one-off preparation, such as creating pipelines, on a pool
+ * of background threads, while the caller gets on with other setup. A job
+ * that needs one result waits for that task alone: if no thread has picked
+ * it up yet, it runs on the waiting thread at once instead of queueing
+ * behind the others.
+ */
+namespace warm_up {
+
+/* Readiness of the tasks added so far, for health checks. */
+struct Health {
+  size_t ready = 0;
+  /* Queued or running. */
+  size_t pending = 0;
+  size_t failed = 0;
+
+  bool AllReady() const { return pending == 0 and failed == 0; }
+};
+
+class Pool {
+ public:
+  using Task = size_t;
+
+  /* With no threads, every task runs when it is first waited for. */
+  explicit Pool(unsigned threads);
+  /* Drops the tasks not started yet and waits for the running ones. */
+  ~Pool();
+
+  Pool(const Pool &) = delete;
+  Pool &operator=(const Pool &) = delete;
+
+  /* Queues work; tasks start in the order they were added. */
+  Task Add(std::function<void()> work);
+
+  /*
+   * Returns once task has finished, running it on this thread if it has not
+   * started. Rethrows the exception the task failed with, if any.
+   */
+  void Wait(Task task);
+
+  /* Waits for every task added so far; does not throw. */
+  void WaitAll();
+
+  Health health() const;
+
+ private:
+  enum class State { kQueued, kRunning, kReady, kFailed };
+
+  struct Entry {
+    std::function<void()> work;
+    State state = State::kQueued;
+    std::exception_ptr error;
+  };
+
+  void RunLocked(Task task, std::unique_lock<std::mutex> *lock);
+  void Work();
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable finished_;
+  /* Never shrinks: Task is an index into it. */
+  std::deque<Entry> entries_;
+  std::deque<Task> queue_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace warm_up
+
+#endif